@@ -21,6 +21,9 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "modbus_slave.h"
+#include "capture.h"
+#include "event_fifo.h"
 
 /* USER CODE END Includes */
 
@@ -94,6 +97,9 @@ int main(void)
   MX_ADC_Init();
   MX_USART1_UART_Init();
   /* USER CODE BEGIN 2 */
+  Capture_Init();
+  ModbusSlave_Init();
+  EventFifo_Init();
 
   /* USER CODE END 2 */
 
@@ -104,6 +110,9 @@ int main(void)
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
+    Capture_Poll();
+    EventFifo_Scan();
+    ModbusSlave_Poll();
   }
   /* USER CODE END 3 */
 }
@@ -15,8 +15,8 @@ extern "C" {
 /* Address counts (0-based Modbus addresses) */
 #define COIL_COUNT           8
 #define DISCRETE_COUNT       8
-#define HOLDING_REG_COUNT    4
-#define INPUT_REG_COUNT     7
+#define HOLDING_REG_COUNT    14
+#define INPUT_REG_COUNT      21
 
 #define COIL_START           0
 #define DISCRETE_START       0
@@ -52,7 +52,14 @@ typedef enum {
     HPSB_HOLDING_STATUS = 0,
     HPSB_HOLDING_ALARM  = 1,
     HPSB_HOLDING_RESERVED_2 = 2,
-    HPSB_HOLDING_RESERVED_3 = 3
+    HPSB_HOLDING_RESERVED_3 = 3,
+    /* 4..7 reserved (read 0) */
+    HPSB_HOLDING_CAPTURE_CTRL = 8,      /* write CAPTURE_CMD_*, read = capture state */
+    HPSB_HOLDING_CAPTURE_OFFSET = 9,    /* readout offset (channel-major sample index) */
+    HPSB_HOLDING_CAPTURE_TRIG_RAW = 10, /* armed trigger: |raw - mid-scale| threshold, 0 = command only */
+    HPSB_HOLDING_CAPTURE_LENGTH = 11,   /* samples per channel, 1..CAPTURE_DEPTH (0 = max) */
+    HPSB_HOLDING_CAPTURE_PERIOD_US = 12, /* sample period in us (min CAPTURE_MIN_PERIOD_US) */
+    HPSB_HOLDING_BAUD_CODE = 13         /* bus speed: unicast write stages, broadcast commits (modbus_baud.h) */
 } HpsbHoldingRegIdx_t;
 
 /* Input register indices (3x): Reg0=DI image, Reg1..3=CT raw ch1..3, Reg4..6=CT RMS x100 (optional, 0 for v1) */
@@ -63,14 +70,25 @@ typedef enum {
     HPSB_INPUT_REG_CT_CH3_RAW = 3,
     HPSB_INPUT_REG_CT_CH1_RMS_X100 = 4,
     HPSB_INPUT_REG_CT_CH2_RMS_X100 = 5,
-    HPSB_INPUT_REG_CT_CH3_RMS_X100 = 6
+    HPSB_INPUT_REG_CT_CH3_RMS_X100 = 6,
+    /* 7..13 reserved (read 0) */
+    HPSB_INPUT_REG_EVENT_PENDING = 14,  /* events in the FC24 FIFO not yet acknowledged */
+    HPSB_INPUT_REG_EVENT_OVERFLOW = 15, /* events dropped because the FIFO was full */
+    HPSB_INPUT_REG_CAPTURE_STATUS = 16, /* CAPTURE_STATUS_* (capture.h) */
+    HPSB_INPUT_REG_CAPTURE_COUNT = 17,  /* samples per channel held */
+    HPSB_INPUT_REG_CAPTURE_PERIOD_US = 18,
+    HPSB_INPUT_REG_CAPTURE_PRETRIG = 19, /* samples before the trigger point */
+    HPSB_INPUT_REG_CAPTURE_SEQ = 20     /* incremented when a capture completes */
 } HpsbInputRegIdx_t;
 
 uint8_t IO_HPSB_ReadDiscrete(uint16_t idx);
+uint8_t IO_HPSB_ReadIdBits(void);     /* ID_BIT1..4 as a 0..15 value, bit0 = ID_BIT1 */
 void    IO_HPSB_WriteCoil(uint16_t idx, uint8_t value);
 uint8_t IO_HPSB_ReadCoil(uint16_t idx);
 void    IO_HPSB_ReadAllDiscrete(uint8_t *bits);
 void    IO_HPSB_ReadAllCoils(uint8_t *bits);
+/* One software-started ADC scan of CT ch1..3 (ADC ch3..5). Returns 0 on success. */
+int     IO_HPSB_ReadCTScan(uint16_t *raw);
 
 #ifdef __cplusplus
 }
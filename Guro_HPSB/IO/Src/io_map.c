@@ -1,10 +1,15 @@
 /**
  * @file io_map.c
  * @brief HPSB: GPIO mapping for Coils (relays) and Discrete (ID bits). LSB-first.
+ *        CT ADC scan (ch3..5) for capture.
  */
 #include "io_map.h"
 #include "main.h"
 
+#define CT_CH_COUNT  3
+
+extern ADC_HandleTypeDef hadc;
+
 /* Coil index -> GPIO (RLY_EN01, 02, 03) */
 static const struct { uint16_t pin; GPIO_TypeDef *port; } coil_gpio[COIL_COUNT] = {
     { RLY_EN01_Pin, RLY_EN01_GPIO_Port },
@@ -28,6 +33,14 @@ uint8_t IO_HPSB_ReadDiscrete(uint16_t idx)
     return (HAL_GPIO_ReadPin(discrete_gpio[idx].port, discrete_gpio[idx].pin) == GPIO_PIN_SET) ? 1 : 0;
 }
 
+uint8_t IO_HPSB_ReadIdBits(void)
+{
+    uint8_t id = 0;
+    for (uint16_t i = 0; i < 4; i++)
+        id |= (uint8_t)(IO_HPSB_ReadDiscrete(HPSB_DISCRETE_ID_BIT1 + i) << i);
+    return id;
+}
+
 void IO_HPSB_WriteCoil(uint16_t idx, uint8_t value)
 {
     if (idx >= COIL_COUNT || coil_gpio[idx].port == NULL) return;
@@ -51,3 +64,17 @@ void IO_HPSB_ReadAllCoils(uint8_t *bits)
     for (uint16_t i = 0; i < COIL_COUNT; i++)
         bits[i] = IO_HPSB_ReadCoil(i);
 }
+
+int IO_HPSB_ReadCTScan(uint16_t *raw)
+{
+    if (HAL_ADC_Start(&hadc) != HAL_OK) return -1;
+    for (uint8_t ch = 0; ch < CT_CH_COUNT; ch++) {
+        if (HAL_ADC_PollForConversion(&hadc, 1) != HAL_OK) {
+            HAL_ADC_Stop(&hadc);
+            return -1;
+        }
+        raw[ch] = (uint16_t)HAL_ADC_GetValue(&hadc);
+    }
+    HAL_ADC_Stop(&hadc);
+    return 0;
+}
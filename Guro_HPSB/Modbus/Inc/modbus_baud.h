@@ -0,0 +1,34 @@
+/**
+ * @file modbus_baud.h
+ * @brief HPSB: downstream RS485 speed switching. MAIN stages a speed code with a unicast FC06 to
+ *        HPSB_HOLDING_BAUD_CODE (acked at the old speed), then commits it with a broadcast FC06 of
+ *        the same value. Without a CRC-valid frame for MODBUS_BAUD_FALLBACK_MS at a negotiated
+ *        speed the slave drops back to MODBUS_BAUD_DEFAULT_CODE on its own.
+ */
+#ifndef MODBUS_BAUD_HPSB_H
+#define MODBUS_BAUD_HPSB_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MODBUS_BAUD_NONE    0xFFu   /* no code staged */
+
+void     ModbusBaud_Init(void);
+/* Called from ModbusSlave_Poll: applies a committed code once TX is idle, runs the fallback timer. */
+void     ModbusBaud_Poll(void);
+void     ModbusBaud_OnValidFrame(void);
+
+/* HPSB_HOLDING_BAUD_CODE: bits 0..7 active code, bits 8..15 staged code (MODBUS_BAUD_NONE = none) */
+uint16_t ModbusBaud_GetReg(void);
+void     ModbusBaud_Stage(uint16_t code);
+/* Broadcast commit: switches only if code matches the staged one. */
+void     ModbusBaud_Commit(uint16_t code);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MODBUS_BAUD_HPSB_H */
@@ -0,0 +1,115 @@
+/**
+ * @file event_fifo.c
+ * @brief HPSB: Event FIFO - edge detection on discretes/coils/alarm and FC24 readout.
+ */
+#include "event_fifo.h"
+#include "io_map.h"
+#include "modbus_table.h"
+#include "main.h"
+
+typedef struct {
+    uint16_t seq;
+    uint8_t  type;
+    uint8_t  index;
+    uint16_t value;
+    uint16_t tick;
+} fifo_event_t;
+
+static fifo_event_t fifo[EVENT_FIFO_DEPTH];
+static uint16_t head;           /* oldest event */
+static uint16_t count;
+static uint16_t next_seq;
+static uint16_t overflow_count;
+
+static uint8_t  last_discrete;
+static uint8_t  last_coils;
+static uint16_t last_alarm;
+
+static uint8_t read_discrete_bits(void)
+{
+    uint8_t bits = 0;
+    for (uint16_t i = 0; i < DISCRETE_COUNT; i++)
+        if (IO_HPSB_ReadDiscrete(i)) bits |= (uint8_t)(1u << i);
+    return bits;
+}
+
+static uint8_t read_coil_bits(void)
+{
+    uint8_t bits = 0;
+    for (uint16_t i = 0; i < COIL_COUNT; i++)
+        if (IO_HPSB_ReadCoil(i)) bits |= (uint8_t)(1u << i);
+    return bits;
+}
+
+static void push_bit_edges(uint8_t type, uint8_t prev, uint8_t now)
+{
+    uint8_t changed = prev ^ now;
+    for (uint8_t i = 0; changed != 0; i++, changed >>= 1)
+        if (changed & 1u) EventFifo_Push(type, i, (now >> i) & 1u);
+}
+
+void EventFifo_Init(void)
+{
+    head = 0;
+    count = 0;
+    next_seq = 0;
+    overflow_count = 0;
+    last_discrete = read_discrete_bits();
+    last_coils = read_coil_bits();
+    last_alarm = ModbusTable_GetHoldingReg(HPSB_HOLDING_ALARM);
+    EventFifo_Push(EVENT_TYPE_BOOT, 0, 0);
+}
+
+void EventFifo_Scan(void)
+{
+    uint8_t  d = read_discrete_bits();
+    uint8_t  c = read_coil_bits();
+    uint16_t a = ModbusTable_GetHoldingReg(HPSB_HOLDING_ALARM);
+
+    if (d != last_discrete) { push_bit_edges(EVENT_TYPE_DISCRETE, last_discrete, d); last_discrete = d; }
+    if (c != last_coils)    { push_bit_edges(EVENT_TYPE_COIL, last_coils, c); last_coils = c; }
+    if (a != last_alarm)    { EventFifo_Push(EVENT_TYPE_ALARM, 0, a); last_alarm = a; }
+}
+
+void EventFifo_Push(uint8_t type, uint8_t index, uint16_t value)
+{
+    if (count >= EVENT_FIFO_DEPTH) {
+        /* Drop oldest; MAIN sees the gap in sequence numbers */
+        head = (uint16_t)((head + 1) % EVENT_FIFO_DEPTH);
+        count--;
+        overflow_count++;
+    }
+    fifo_event_t *e = &fifo[(head + count) % EVENT_FIFO_DEPTH];
+    e->seq   = next_seq++;
+    e->type  = type;
+    e->index = index;
+    e->value = value;
+    e->tick  = (uint16_t)HAL_GetTick();
+    count++;
+}
+
+uint16_t EventFifo_Read(uint16_t cursor, uint16_t *regs, uint16_t max_events)
+{
+    /* Acknowledge: drop events older than cursor. A cursor outside the stored range (MAIN out of
+     * sync, e.g. after this board reset) acknowledges nothing. */
+    if (count > 0) {
+        uint16_t acked = (uint16_t)(cursor - fifo[head].seq);
+        if (acked <= count) {
+            head = (uint16_t)((head + acked) % EVENT_FIFO_DEPTH);
+            count = (uint16_t)(count - acked);
+        }
+    }
+
+    uint16_t n = (count < max_events) ? count : max_events;
+    for (uint16_t i = 0; i < n; i++) {
+        const fifo_event_t *e = &fifo[(head + i) % EVENT_FIFO_DEPTH];
+        regs[i * EVENT_FIFO_REGS_PER_EVENT + 0] = e->seq;
+        regs[i * EVENT_FIFO_REGS_PER_EVENT + 1] = (uint16_t)((e->type << 8) | e->index);
+        regs[i * EVENT_FIFO_REGS_PER_EVENT + 2] = e->value;
+        regs[i * EVENT_FIFO_REGS_PER_EVENT + 3] = e->tick;
+    }
+    return n;
+}
+
+uint16_t EventFifo_Count(void)            { return count; }
+uint16_t EventFifo_GetOverflowCount(void) { return overflow_count; }
@@ -0,0 +1,75 @@
+/**
+ * @file modbus_baud.c
+ * @brief HPSB: downstream RS485 speed switching (stage / broadcast commit / silent fallback).
+ */
+#include "modbus_baud.h"
+#include "modbus_cfg.h"
+#include "main.h"
+
+extern UART_HandleTypeDef huart1;
+
+static const uint32_t baud_table[MODBUS_BAUD_CODE_COUNT] = MODBUS_BAUD_TABLE;
+
+static uint8_t  active_code;
+static uint8_t  staged_code;
+static uint8_t  pending_code;   /* committed, applied by ModbusBaud_Poll */
+static uint32_t last_valid_tick;
+
+static void apply(uint8_t code)
+{
+    HAL_UART_AbortReceive(&MODBUS_UART);     /* modbus_slave re-arms RX on the next poll */
+    MODBUS_UART.Init.BaudRate = baud_table[code];
+    if (HAL_UART_Init(&MODBUS_UART) != HAL_OK) {
+        MODBUS_UART.Init.BaudRate = baud_table[MODBUS_BAUD_DEFAULT_CODE];
+        HAL_UART_Init(&MODBUS_UART);
+        code = MODBUS_BAUD_DEFAULT_CODE;
+    }
+    active_code = code;
+    last_valid_tick = HAL_GetTick();
+}
+
+void ModbusBaud_Init(void)
+{
+    active_code = MODBUS_BAUD_DEFAULT_CODE;
+    staged_code = MODBUS_BAUD_NONE;
+    pending_code = MODBUS_BAUD_NONE;
+    last_valid_tick = HAL_GetTick();
+}
+
+void ModbusBaud_Poll(void)
+{
+    if (MODBUS_UART.gState != HAL_UART_STATE_READY) return;    /* response still going out */
+
+    if (pending_code != MODBUS_BAUD_NONE) {
+        apply(pending_code);
+        pending_code = MODBUS_BAUD_NONE;
+        return;
+    }
+    if (active_code != MODBUS_BAUD_DEFAULT_CODE &&
+        (HAL_GetTick() - last_valid_tick) >= MODBUS_BAUD_FALLBACK_MS) {
+        staged_code = MODBUS_BAUD_NONE;
+        apply(MODBUS_BAUD_DEFAULT_CODE);
+    }
+}
+
+void ModbusBaud_OnValidFrame(void)
+{
+    last_valid_tick = HAL_GetTick();
+}
+
+uint16_t ModbusBaud_GetReg(void)
+{
+    return (uint16_t)(((uint16_t)staged_code << 8) | active_code);
+}
+
+void ModbusBaud_Stage(uint16_t code)
+{
+    staged_code = (code < MODBUS_BAUD_CODE_COUNT) ? (uint8_t)code : MODBUS_BAUD_NONE;
+}
+
+void ModbusBaud_Commit(uint16_t code)
+{
+    if (staged_code == MODBUS_BAUD_NONE || code != staged_code) return;
+    staged_code = MODBUS_BAUD_NONE;
+    if (code != active_code) pending_code = (uint8_t)code;
+}
@@ -1,9 +1,13 @@
 /**
  * @file modbus_table.c
  * @brief HPSB: Modbus address table implementation. Coil/Discrete from io_map; Holding/Input in RAM.
+ *        Capture control/readout registers are owned by capture.
  */
 #include "modbus_table.h"
 #include "io_map.h"
+#include "capture.h"
+#include "event_fifo.h"
+#include "modbus_baud.h"
 #include <string.h>
 
 static uint8_t  discrete_image[DISCRETE_COUNT];
@@ -47,19 +51,35 @@ void ModbusTable_RefreshDiscrete(void)
 uint16_t ModbusTable_GetHoldingReg(uint16_t addr)
 {
     if (addr >= HOLDING_REG_COUNT) return 0;
-    return holding_regs[addr];
+    switch (addr) {
+        case HPSB_HOLDING_CAPTURE_CTRL:      return Capture_GetState();
+        case HPSB_HOLDING_CAPTURE_OFFSET:    return Capture_GetOffset();
+        case HPSB_HOLDING_CAPTURE_TRIG_RAW:  return Capture_GetTrigRaw();
+        case HPSB_HOLDING_CAPTURE_LENGTH:    return Capture_GetLength();
+        case HPSB_HOLDING_CAPTURE_PERIOD_US: return Capture_GetPeriodUs();
+        case HPSB_HOLDING_BAUD_CODE:         return ModbusBaud_GetReg();
+        default:                             return holding_regs[addr];
+    }
 }
 
 void ModbusTable_SetHoldingReg(uint16_t addr, uint16_t value)
 {
     if (addr >= HOLDING_REG_COUNT) return;
-    holding_regs[addr] = value;
+    switch (addr) {
+        case HPSB_HOLDING_CAPTURE_CTRL:      Capture_Command(value);     break;
+        case HPSB_HOLDING_CAPTURE_OFFSET:    Capture_SetOffset(value);   break;
+        case HPSB_HOLDING_CAPTURE_TRIG_RAW:  Capture_SetTrigRaw(value);  break;
+        case HPSB_HOLDING_CAPTURE_LENGTH:    Capture_SetLength(value);   break;
+        case HPSB_HOLDING_CAPTURE_PERIOD_US: Capture_SetPeriodUs(value); break;
+        case HPSB_HOLDING_BAUD_CODE:         ModbusBaud_Stage(value);    break;
+        default:                             holding_regs[addr] = value; break;
+    }
 }
 
 void ModbusTable_SetHoldingRegs(uint16_t start, const uint16_t *regs, uint16_t num)
 {
     for (uint16_t i = 0; i < num && (start + i) < HOLDING_REG_COUNT; i++)
-        holding_regs[start + i] = regs[i];
+        ModbusTable_SetHoldingReg(start + i, regs[i]);
 }
 
 uint16_t ModbusTable_GetInputReg(uint16_t addr)
@@ -83,4 +103,25 @@ void ModbusTable_RefreshInputRegs(void)
     input_regs[HPSB_INPUT_REG_CT_CH1_RMS_X100] = 0;
     input_regs[HPSB_INPUT_REG_CT_CH2_RMS_X100] = 0;
     input_regs[HPSB_INPUT_REG_CT_CH3_RMS_X100] = 0;
+    input_regs[HPSB_INPUT_REG_CAPTURE_STATUS]    = Capture_GetStatus();
+    input_regs[HPSB_INPUT_REG_CAPTURE_COUNT]     = Capture_GetCount();
+    input_regs[HPSB_INPUT_REG_CAPTURE_PERIOD_US] = Capture_GetPeriodUs();
+    input_regs[HPSB_INPUT_REG_CAPTURE_PRETRIG]   = Capture_GetPretrig();
+    input_regs[HPSB_INPUT_REG_CAPTURE_SEQ]       = Capture_GetSeq();
+    input_regs[HPSB_INPUT_REG_EVENT_PENDING]     = EventFifo_Count();
+    input_regs[HPSB_INPUT_REG_EVENT_OVERFLOW]    = EventFifo_GetOverflowCount();
+}
+
+int ModbusTable_ReadInputRegs(uint16_t start, uint16_t num, uint16_t *regs)
+{
+    if (num == 0) return -1;
+    if (start >= CAPTURE_WINDOW_START) {
+        if (start + num > CAPTURE_WINDOW_START + CAPTURE_WINDOW_REGS) return -1;
+        Capture_ReadWindow((uint16_t)(start - CAPTURE_WINDOW_START), regs, num);
+        return 0;
+    }
+    if (start + num > INPUT_REG_COUNT) return -1;
+    ModbusTable_RefreshInputRegs();
+    for (uint16_t i = 0; i < num; i++) regs[i] = input_regs[start + i];
+    return 0;
 }
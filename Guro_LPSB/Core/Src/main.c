@@ -21,6 +21,10 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "modbus_slave.h"
+#include "current_sense.h"
+#include "capture.h"
+#include "event_fifo.h"
 
 /* USER CODE END Includes */
 
@@ -94,6 +98,10 @@ int main(void)
   MX_USART1_UART_Init();
   MX_ADC_Init();
   /* USER CODE BEGIN 2 */
+  CurrentSense_Init();
+  Capture_Init();
+  ModbusSlave_Init();
+  EventFifo_Init();
 
   /* USER CODE END 2 */
 
@@ -104,6 +112,10 @@ int main(void)
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
+    CurrentSense_Poll();
+    Capture_Poll();
+    EventFifo_Scan();
+    ModbusSlave_Poll();
   }
   /* USER CODE END 3 */
 }
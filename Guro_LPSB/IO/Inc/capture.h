@@ -0,0 +1,80 @@
+/**
+ * @file capture.h
+ * @brief LPSB: triggered burst capture of the ACS712 waveforms (ADC ch3..5) into RAM.
+ *        Started by MAIN (trigger now) or armed on a |raw - offset| threshold with pre-trigger
+ *        history. Read out channel-major through the FC04 window at CAPTURE_WINDOW_START;
+ *        the readout offset advances by the number of registers read.
+ */
+#ifndef CAPTURE_LPSB_H
+#define CAPTURE_LPSB_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CAPTURE_CH_COUNT            3
+
+/* Samples per channel held in RAM. Override at build time; must stay within CAPTURE_RAM_BUDGET. */
+#ifndef CAPTURE_DEPTH
+#define CAPTURE_DEPTH               128u
+#endif
+#define CAPTURE_RAM_BUDGET          1024u   /* bytes of the F030's 4 KB reserved for the sample buffer */
+
+#if (CAPTURE_CH_COUNT * CAPTURE_DEPTH * 2u) > CAPTURE_RAM_BUDGET
+#error "CAPTURE_DEPTH too large for CAPTURE_RAM_BUDGET"
+#endif
+
+#define CAPTURE_DEFAULT_PERIOD_US   625u    /* 32 samples per 50 Hz cycle: 128 samples = 4 cycles */
+#define CAPTURE_MIN_PERIOD_US       250u
+#define CAPTURE_DEFAULT_TRIG_RAW    600u    /* |raw - offset| to trigger an armed capture */
+
+/* FC04 readout window (input registers) */
+#define CAPTURE_WINDOW_START        32u
+#define CAPTURE_WINDOW_REGS         24u
+
+/* LPSB_HOLDING_CAPTURE_CTRL commands */
+#define CAPTURE_CMD_STOP            0u
+#define CAPTURE_CMD_TRIGGER         1u
+#define CAPTURE_CMD_ARM             2u
+
+/* Capture state (LPSB_INPUT_REG_CAPTURE_STATUS bits 0..1) */
+#define CAPTURE_STATE_IDLE          0u
+#define CAPTURE_STATE_ARMED         1u
+#define CAPTURE_STATE_RECORDING     2u
+#define CAPTURE_STATE_DONE          3u
+
+/* LPSB_INPUT_REG_CAPTURE_STATUS bits */
+#define CAPTURE_STATUS_STATE_MASK   0x0003u
+#define CAPTURE_STATUS_TRIG_CH(s)   (((s) >> 4) & 0x3u)     /* channel that crossed the threshold */
+#define CAPTURE_STATUS_THRESHOLD    (1u << 6)               /* 1 = threshold trigger, 0 = MAIN command */
+#define CAPTURE_STATUS_LATE         (1u << 7)               /* a sample was taken more than one period late */
+
+void     Capture_Init(void);
+void     Capture_Poll(void);
+
+void     Capture_Command(uint16_t cmd);
+uint16_t Capture_GetState(void);
+uint16_t Capture_GetStatus(void);
+uint16_t Capture_GetCount(void);
+uint16_t Capture_GetPretrig(void);
+uint16_t Capture_GetSeq(void);
+
+uint16_t Capture_GetOffset(void);
+void     Capture_SetOffset(uint16_t offset);
+uint16_t Capture_GetTrigRaw(void);
+void     Capture_SetTrigRaw(uint16_t raw);
+uint16_t Capture_GetLength(void);
+void     Capture_SetLength(uint16_t samples);
+uint16_t Capture_GetPeriodUs(void);
+void     Capture_SetPeriodUs(uint16_t us);
+
+/* Copy num samples from window register rel (0-based) at the readout offset, then advance it. */
+void     Capture_ReadWindow(uint16_t rel, uint16_t *regs, uint16_t num);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAPTURE_LPSB_H */
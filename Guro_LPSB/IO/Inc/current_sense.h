@@ -0,0 +1,59 @@
+/**
+ * @file current_sense.h
+ * @brief LPSB: ACS712 current sensing on ADC ch3..5 (Port1..3).
+ *        Boot zero-offset calibration, per-port peak/RMS tracking and a local
+ *        fast overcurrent trip that switches the port SSR off without waiting for MAIN.
+ */
+#ifndef CURRENT_SENSE_LPSB_H
+#define CURRENT_SENSE_LPSB_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CURRENT_SENSE_CH_COUNT              3
+#define CURRENT_SENSE_SAMPLE_PERIOD_MS      1u
+#define CURRENT_SENSE_WINDOW_SAMPLES        20u     /* 1 mains cycle @ 50 Hz, 1 kHz sampling */
+#define CURRENT_SENSE_CAL_SAMPLES           64u
+#define CURRENT_SENSE_OFFSET_NOMINAL        2048u   /* 12-bit mid-scale = 0 A */
+#define CURRENT_SENSE_OFFSET_TOLERANCE      400u    /* calibrated offset outside nominal +/- this = fault */
+
+/* Defaults for the trip configuration registers (raw ADC counts away from zero offset) */
+#define CURRENT_SENSE_DEFAULT_PEAK_TRIP_RAW 1800u   /* 0 = peak trip disabled */
+#define CURRENT_SENSE_DEFAULT_RMS_TRIP_RAW  0u      /* 0 = RMS trip disabled */
+#define CURRENT_SENSE_DEFAULT_TRIP_SAMPLES  2u      /* consecutive samples over peak threshold */
+#define CURRENT_SENSE_MAX_TRIP_SAMPLES      255u    /* over-threshold counter is 8-bit */
+
+typedef struct {
+    uint16_t peak_trip_raw;
+    uint16_t rms_trip_raw;
+    uint16_t trip_samples;
+} current_sense_cfg_t;
+
+void     CurrentSense_Init(void);
+void     CurrentSense_Poll(void);
+
+/* One ADC scan of ch3..5 (also used by capture.c). Returns 0 on success. */
+int      CurrentSense_ReadAdc(uint16_t raw[CURRENT_SENSE_CH_COUNT]);
+
+uint16_t CurrentSense_GetRaw(uint8_t ch);
+uint16_t CurrentSense_GetPeak(uint8_t ch);
+uint16_t CurrentSense_GetRms(uint8_t ch);
+uint16_t CurrentSense_GetOffset(uint8_t ch);
+
+uint16_t CurrentSense_GetStatus(void);
+uint16_t CurrentSense_GetAlarm(void);
+uint16_t CurrentSense_GetTripCause(void);
+uint8_t  CurrentSense_IsTripped(uint8_t ch);
+void     CurrentSense_ClearTrip(uint16_t ch_mask);
+
+void     CurrentSense_GetConfig(current_sense_cfg_t *cfg);
+void     CurrentSense_SetConfig(const current_sense_cfg_t *cfg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CURRENT_SENSE_LPSB_H */
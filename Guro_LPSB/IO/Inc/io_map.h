@@ -14,8 +14,8 @@ extern "C" {
 
 #define COIL_COUNT           8
 #define DISCRETE_COUNT       8
-#define HOLDING_REG_COUNT    4
-#define INPUT_REG_COUNT      4
+#define HOLDING_REG_COUNT    14
+#define INPUT_REG_COUNT      21
 
 #define COIL_START           0
 #define DISCRETE_START       0
@@ -46,19 +46,59 @@ typedef enum {
 
 typedef enum {
     LPSB_HOLDING_STATUS = 0,
-    LPSB_HOLDING_ALARM  = 1,
-    LPSB_HOLDING_RESERVED_2 = 2,
-    LPSB_HOLDING_RESERVED_3 = 3
+    LPSB_HOLDING_ALARM  = 1,            /* bit n = Port(n+1) OC trip latched; write 0 to the bit to clear */
+    LPSB_HOLDING_TRIP_CAUSE = 2,        /* see LPSB_TRIP_CAUSE_* (read-only) */
+    LPSB_HOLDING_RESERVED_3 = 3,
+    LPSB_HOLDING_OC_PEAK_TRIP_RAW = 4,  /* |raw - offset| threshold, 0 = disabled */
+    LPSB_HOLDING_OC_RMS_TRIP_RAW = 5,   /* RMS threshold (raw counts), 0 = disabled */
+    LPSB_HOLDING_OC_TRIP_SAMPLES = 6,   /* consecutive samples over peak threshold */
+    LPSB_HOLDING_RESERVED_7 = 7,
+    LPSB_HOLDING_CAPTURE_CTRL = 8,      /* write CAPTURE_CMD_*, read = capture state */
+    LPSB_HOLDING_CAPTURE_OFFSET = 9,    /* readout offset (channel-major sample index) */
+    LPSB_HOLDING_CAPTURE_TRIG_RAW = 10, /* armed trigger: |raw - offset| threshold, 0 = command only */
+    LPSB_HOLDING_CAPTURE_LENGTH = 11,   /* samples per channel, 1..CAPTURE_DEPTH (0 = max) */
+    LPSB_HOLDING_CAPTURE_PERIOD_US = 12, /* sample period in us (min CAPTURE_MIN_PERIOD_US) */
+    LPSB_HOLDING_BAUD_CODE = 13         /* bus speed: unicast write stages, broadcast commits (modbus_baud.h) */
 } LpsbHoldingRegIdx_t;
 
+/* LPSB_HOLDING_STATUS bits */
+#define LPSB_STATUS_CAL_OK              (1u << 0)   /* zero offsets calibrated at boot */
+#define LPSB_STATUS_ADC_FAULT           (1u << 1)
+
+/* LPSB_HOLDING_ALARM bits */
+#define LPSB_ALARM_OC_TRIP(ch)          (1u << (ch))
+#define LPSB_ALARM_OC_TRIP_MASK         0x0007u
+
+/* LPSB_HOLDING_TRIP_CAUSE bits: low nibble = peak trip, high nibble = RMS trip */
+#define LPSB_TRIP_CAUSE_PEAK(ch)        (1u << (ch))
+#define LPSB_TRIP_CAUSE_RMS(ch)         (1u << (4 + (ch)))
+
 typedef enum {
     LPSB_INPUT_REG_DISCRETE_IMAGE = 0,
     LPSB_INPUT_REG_ACS_CH1_RAW = 1,
     LPSB_INPUT_REG_ACS_CH2_RAW = 2,
-    LPSB_INPUT_REG_ACS_CH3_RAW = 3
+    LPSB_INPUT_REG_ACS_CH3_RAW = 3,
+    LPSB_INPUT_REG_ACS_CH1_PEAK = 4,    /* max |raw - offset| over last window */
+    LPSB_INPUT_REG_ACS_CH2_PEAK = 5,
+    LPSB_INPUT_REG_ACS_CH3_PEAK = 6,
+    LPSB_INPUT_REG_ACS_CH1_RMS = 7,     /* RMS of (raw - offset) over last window */
+    LPSB_INPUT_REG_ACS_CH2_RMS = 8,
+    LPSB_INPUT_REG_ACS_CH3_RMS = 9,
+    LPSB_INPUT_REG_ACS_CH1_OFFSET = 10, /* calibrated zero offset */
+    LPSB_INPUT_REG_ACS_CH2_OFFSET = 11,
+    LPSB_INPUT_REG_ACS_CH3_OFFSET = 12,
+    /* 13 reserved (read 0) */
+    LPSB_INPUT_REG_EVENT_PENDING = 14,  /* events in the FC24 FIFO not yet acknowledged */
+    LPSB_INPUT_REG_EVENT_OVERFLOW = 15, /* events dropped because the FIFO was full */
+    LPSB_INPUT_REG_CAPTURE_STATUS = 16, /* CAPTURE_STATUS_* (capture.h) */
+    LPSB_INPUT_REG_CAPTURE_COUNT = 17,  /* samples per channel held */
+    LPSB_INPUT_REG_CAPTURE_PERIOD_US = 18,
+    LPSB_INPUT_REG_CAPTURE_PRETRIG = 19, /* samples before the trigger point */
+    LPSB_INPUT_REG_CAPTURE_SEQ = 20     /* incremented when a capture completes */
 } LpsbInputRegIdx_t;
 
 uint8_t IO_LPSB_ReadDiscrete(uint16_t idx);
+uint8_t IO_LPSB_ReadIdBits(void);     /* ID_BIT1..4 as a 0..15 value, bit0 = ID_BIT1 */
 void    IO_LPSB_WriteCoil(uint16_t idx, uint8_t value);
 uint8_t IO_LPSB_ReadCoil(uint16_t idx);
 void    IO_LPSB_ReadAllDiscrete(uint8_t *bits);
@@ -0,0 +1,184 @@
+/**
+ * @file capture.c
+ * @brief LPSB: burst waveform capture. Samples ch3..5 from the main loop on a SysTick-derived
+ *        microsecond timebase into a ring of `length` samples per channel. When armed the ring
+ *        keeps a pre-trigger history (length/4); the capture freezes once the ring is full after
+ *        the trigger. Length and period are latched when a capture starts.
+ */
+#include "capture.h"
+#include "current_sense.h"
+#include "main.h"
+
+static uint16_t buf[CAPTURE_CH_COUNT][CAPTURE_DEPTH];
+
+static uint16_t state;
+static uint16_t status_flags;
+static uint16_t wr;             /* next ring slot */
+static uint16_t filled;         /* valid samples in ring (<= len) */
+static uint16_t remaining;      /* samples still to record after the trigger */
+static uint16_t pretrig;
+static uint16_t seq;
+static uint16_t read_offset;
+
+static uint16_t cfg_length = CAPTURE_DEPTH;
+static uint16_t cfg_period_us = CAPTURE_DEFAULT_PERIOD_US;
+static uint16_t trig_raw = CAPTURE_DEFAULT_TRIG_RAW;
+
+static uint16_t len;            /* latched cfg_length for the running capture */
+static uint16_t period_us;      /* latched cfg_period_us */
+static uint32_t next_us;
+
+/* Microseconds from HAL tick + SysTick down-counter (wraps with the 32-bit product; deltas only). */
+static uint32_t now_us(void)
+{
+    uint32_t ms, val;
+    do {
+        ms  = HAL_GetTick();
+        val = SysTick->VAL;
+    } while (ms != HAL_GetTick());
+    uint32_t load = SysTick->LOAD + 1u;
+    return ms * 1000u + ((load - val) * 1000u) / load;
+}
+
+static void restart(uint16_t new_state)
+{
+    len = cfg_length;
+    period_us = cfg_period_us;
+    wr = 0;
+    filled = 0;
+    pretrig = 0;
+    status_flags = 0;
+    read_offset = 0;
+    next_us = now_us();
+    state = new_state;
+}
+
+static void finish(void)
+{
+    state = CAPTURE_STATE_DONE;
+    seq++;
+}
+
+/* pre_avail = samples in the ring that precede the trigger point */
+static void trigger(uint16_t pre_avail, uint16_t trig_in_ring, uint16_t flags)
+{
+    uint16_t max_pre = (uint16_t)(len / 4u);
+    pretrig = (pre_avail < max_pre) ? pre_avail : max_pre;
+    remaining = (uint16_t)(len - pretrig - trig_in_ring);
+    status_flags |= flags;
+    state = CAPTURE_STATE_RECORDING;
+    if (remaining == 0) finish();
+}
+
+static uint16_t magnitude(uint8_t ch, uint16_t raw)
+{
+    uint16_t zero = CurrentSense_GetOffset(ch);
+    return (raw > zero) ? (uint16_t)(raw - zero) : (uint16_t)(zero - raw);
+}
+
+void Capture_Init(void)
+{
+    seq = 0;
+    restart(CAPTURE_STATE_IDLE);
+}
+
+void Capture_Poll(void)
+{
+    uint16_t raw[CAPTURE_CH_COUNT];
+
+    if (state != CAPTURE_STATE_ARMED && state != CAPTURE_STATE_RECORDING) return;
+
+    uint32_t now = now_us();
+    if ((int32_t)(now - next_us) < 0) return;
+    if ((now - next_us) >= period_us) {
+        status_flags |= CAPTURE_STATUS_LATE;
+        next_us = now;      /* do not burst to catch up: keep spacing, flag the gap */
+    }
+    next_us += period_us;
+
+    if (CurrentSense_ReadAdc(raw) != 0) return;
+    for (uint8_t ch = 0; ch < CAPTURE_CH_COUNT; ch++)
+        buf[ch][wr] = raw[ch];
+    if (++wr >= len) wr = 0;
+    if (filled < len) filled++;
+
+    if (state == CAPTURE_STATE_ARMED) {
+        if (trig_raw == 0) return;
+        for (uint8_t ch = 0; ch < CAPTURE_CH_COUNT; ch++) {
+            if (magnitude(ch, raw[ch]) >= trig_raw) {
+                trigger((uint16_t)(filled - 1u), 1u, (uint16_t)(CAPTURE_STATUS_THRESHOLD | ((uint16_t)ch << 4)));
+                return;
+            }
+        }
+        return;
+    }
+    if (--remaining == 0) finish();
+}
+
+void Capture_Command(uint16_t cmd)
+{
+    switch (cmd) {
+        case CAPTURE_CMD_STOP:
+            state = CAPTURE_STATE_IDLE;
+            break;
+        case CAPTURE_CMD_TRIGGER:
+            if (state == CAPTURE_STATE_ARMED) {
+                trigger(filled, 0u, 0u);    /* keep the history recorded while armed */
+            } else if (state != CAPTURE_STATE_RECORDING) {
+                restart(CAPTURE_STATE_ARMED);
+                trigger(0u, 0u, 0u);
+            }
+            break;
+        case CAPTURE_CMD_ARM:
+            restart(CAPTURE_STATE_ARMED);
+            break;
+        default:
+            break;
+    }
+}
+
+uint16_t Capture_GetState(void)   { return state; }
+uint16_t Capture_GetStatus(void)  { return (uint16_t)(state | status_flags); }
+uint16_t Capture_GetCount(void)   { return filled; }
+uint16_t Capture_GetPretrig(void) { return pretrig; }
+uint16_t Capture_GetSeq(void)     { return seq; }
+
+uint16_t Capture_GetOffset(void)          { return read_offset; }
+void     Capture_SetOffset(uint16_t off)  { read_offset = off; }
+uint16_t Capture_GetTrigRaw(void)         { return trig_raw; }
+void     Capture_SetTrigRaw(uint16_t raw) { trig_raw = raw; }
+uint16_t Capture_GetLength(void)          { return cfg_length; }
+uint16_t Capture_GetPeriodUs(void)        { return period_us; }
+
+void Capture_SetLength(uint16_t samples)
+{
+    if (samples == 0 || samples > CAPTURE_DEPTH) samples = CAPTURE_DEPTH;
+    cfg_length = samples;
+}
+
+void Capture_SetPeriodUs(uint16_t us)
+{
+    if (us < CAPTURE_MIN_PERIOD_US) us = CAPTURE_MIN_PERIOD_US;
+    cfg_period_us = us;
+}
+
+void Capture_ReadWindow(uint16_t rel, uint16_t *regs, uint16_t num)
+{
+    /* Channel-major: index = ch * filled + n, n = 0 oldest */
+    uint16_t oldest = (filled >= len) ? wr : 0;
+    uint32_t total = (uint32_t)filled * CAPTURE_CH_COUNT;
+
+    for (uint16_t i = 0; i < num; i++) {
+        uint32_t k = (uint32_t)read_offset + rel + i;
+        if (k >= total || filled == 0) {
+            regs[i] = 0;
+            continue;
+        }
+        uint16_t ch = (uint16_t)(k / filled);
+        uint16_t n  = (uint16_t)(k % filled);
+        uint16_t slot = (uint16_t)(oldest + n);
+        if (slot >= len) slot = (uint16_t)(slot - len);
+        regs[i] = buf[ch][slot];
+    }
+    read_offset = (uint16_t)(read_offset + rel + num);
+}
@@ -0,0 +1,211 @@
+/**
+ * @file current_sense.c
+ * @brief LPSB: ACS712 sampling (ADC scan ch3..5, 1 kHz), zero-offset calibration at boot,
+ *        per-window peak/RMS and local overcurrent trip. A trip switches the SSR off in the
+ *        same sample, latches LPSB_HOLDING_ALARM and TRIP_CAUSE, and blocks the coil until
+ *        MAIN clears the alarm bit.
+ */
+#include "current_sense.h"
+#include "io_map.h"
+#include "main.h"
+
+extern ADC_HandleTypeDef hadc;
+
+static current_sense_cfg_t cfg = {
+    CURRENT_SENSE_DEFAULT_PEAK_TRIP_RAW,
+    CURRENT_SENSE_DEFAULT_RMS_TRIP_RAW,
+    CURRENT_SENSE_DEFAULT_TRIP_SAMPLES
+};
+
+static uint16_t offset[CURRENT_SENSE_CH_COUNT];
+static uint16_t last_raw[CURRENT_SENSE_CH_COUNT];
+static uint16_t peak[CURRENT_SENSE_CH_COUNT];
+static uint16_t rms[CURRENT_SENSE_CH_COUNT];
+
+static uint16_t win_peak[CURRENT_SENSE_CH_COUNT];
+static uint32_t win_sumsq[CURRENT_SENSE_CH_COUNT];
+static uint16_t win_count;
+static uint8_t  over_count[CURRENT_SENSE_CH_COUNT];
+
+static uint16_t status;
+static uint16_t alarm;
+static uint16_t trip_cause;
+static uint32_t last_sample_tick;
+
+/* One software-started scan of ch3,4,5 (forward scan, EOC per conversion). */
+static int adc_read_scan(uint16_t raw[CURRENT_SENSE_CH_COUNT])
+{
+    if (HAL_ADC_Start(&hadc) != HAL_OK) return -1;
+    for (uint8_t ch = 0; ch < CURRENT_SENSE_CH_COUNT; ch++) {
+        if (HAL_ADC_PollForConversion(&hadc, 1) != HAL_OK) {
+            HAL_ADC_Stop(&hadc);
+            return -1;
+        }
+        raw[ch] = (uint16_t)HAL_ADC_GetValue(&hadc);
+    }
+    HAL_ADC_Stop(&hadc);
+    return 0;
+}
+
+static uint16_t isqrt32(uint32_t v)
+{
+    uint32_t res = 0;
+    uint32_t bit = 1uL << 30;
+    while (bit > v) bit >>= 2;
+    while (bit != 0) {
+        if (v >= res + bit) {
+            v -= res + bit;
+            res = (res >> 1) + bit;
+        } else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint16_t)res;
+}
+
+static void calibrate(void)
+{
+    uint32_t sum[CURRENT_SENSE_CH_COUNT] = { 0 };
+    uint16_t raw[CURRENT_SENSE_CH_COUNT];
+    uint16_t n = 0;
+
+    for (uint16_t i = 0; i < CURRENT_SENSE_CAL_SAMPLES; i++) {
+        if (adc_read_scan(raw) == 0) {
+            for (uint8_t ch = 0; ch < CURRENT_SENSE_CH_COUNT; ch++) sum[ch] += raw[ch];
+            n++;
+        }
+        HAL_Delay(1);
+    }
+
+    status = LPSB_STATUS_CAL_OK;
+    if (n == 0) status = LPSB_STATUS_ADC_FAULT;
+    for (uint8_t ch = 0; ch < CURRENT_SENSE_CH_COUNT; ch++) {
+        uint16_t avg = (n > 0) ? (uint16_t)(sum[ch] / n) : CURRENT_SENSE_OFFSET_NOMINAL;
+        uint16_t diff = (avg > CURRENT_SENSE_OFFSET_NOMINAL) ? (uint16_t)(avg - CURRENT_SENSE_OFFSET_NOMINAL)
+                                                            : (uint16_t)(CURRENT_SENSE_OFFSET_NOMINAL - avg);
+        if (diff > CURRENT_SENSE_OFFSET_TOLERANCE) {
+            /* Port not at 0 A at boot or sensor fault: fall back to nominal mid-scale */
+            avg = CURRENT_SENSE_OFFSET_NOMINAL;
+            status &= (uint16_t)~LPSB_STATUS_CAL_OK;
+        }
+        offset[ch] = avg;
+        last_raw[ch] = avg;
+    }
+}
+
+static void trip(uint8_t ch, uint16_t cause)
+{
+    IO_LPSB_WriteCoil(LPSB_COIL_SSR1 + ch, 0);
+    alarm |= LPSB_ALARM_OC_TRIP(ch);
+    trip_cause |= cause;
+}
+
+static void sample_channel(uint8_t ch, uint16_t raw)
+{
+    uint16_t mag = (raw > offset[ch]) ? (uint16_t)(raw - offset[ch]) : (uint16_t)(offset[ch] - raw);
+    uint8_t need = (uint8_t)cfg.trip_samples;    /* 1..255, clamped by CurrentSense_SetConfig */
+
+    last_raw[ch] = raw;
+    if (mag > win_peak[ch]) win_peak[ch] = mag;
+    win_sumsq[ch] += (uint32_t)mag * mag;
+
+    if (cfg.peak_trip_raw != 0 && mag >= cfg.peak_trip_raw) {
+        if (over_count[ch] < 0xFF) over_count[ch]++;
+        if (over_count[ch] >= need) trip(ch, LPSB_TRIP_CAUSE_PEAK(ch));
+    } else {
+        over_count[ch] = 0;
+    }
+}
+
+static void close_window(void)
+{
+    for (uint8_t ch = 0; ch < CURRENT_SENSE_CH_COUNT; ch++) {
+        peak[ch] = win_peak[ch];
+        rms[ch]  = isqrt32(win_sumsq[ch] / win_count);
+        win_peak[ch] = 0;
+        win_sumsq[ch] = 0;
+        if (cfg.rms_trip_raw != 0 && rms[ch] >= cfg.rms_trip_raw)
+            trip(ch, LPSB_TRIP_CAUSE_RMS(ch));
+    }
+    win_count = 0;
+}
+
+void CurrentSense_Init(void)
+{
+    HAL_ADCEx_Calibration_Start(&hadc);
+    calibrate();
+    alarm = 0;
+    trip_cause = 0;
+    win_count = 0;
+    for (uint8_t ch = 0; ch < CURRENT_SENSE_CH_COUNT; ch++) {
+        peak[ch] = rms[ch] = win_peak[ch] = 0;
+        win_sumsq[ch] = 0;
+        over_count[ch] = 0;
+    }
+    last_sample_tick = HAL_GetTick();
+}
+
+void CurrentSense_Poll(void)
+{
+    uint16_t raw[CURRENT_SENSE_CH_COUNT];
+    uint32_t now = HAL_GetTick();
+
+    if ((now - last_sample_tick) < CURRENT_SENSE_SAMPLE_PERIOD_MS) return;
+    last_sample_tick = now;
+
+    if (adc_read_scan(raw) != 0) {
+        status |= LPSB_STATUS_ADC_FAULT;
+        return;
+    }
+    for (uint8_t ch = 0; ch < CURRENT_SENSE_CH_COUNT; ch++)
+        sample_channel(ch, raw[ch]);
+    if (++win_count >= CURRENT_SENSE_WINDOW_SAMPLES)
+        close_window();
+}
+
+int CurrentSense_ReadAdc(uint16_t raw[CURRENT_SENSE_CH_COUNT])
+{
+    return adc_read_scan(raw);
+}
+
+uint16_t CurrentSense_GetRaw(uint8_t ch)    { return (ch < CURRENT_SENSE_CH_COUNT) ? last_raw[ch] : 0; }
+uint16_t CurrentSense_GetPeak(uint8_t ch)   { return (ch < CURRENT_SENSE_CH_COUNT) ? peak[ch] : 0; }
+uint16_t CurrentSense_GetRms(uint8_t ch)    { return (ch < CURRENT_SENSE_CH_COUNT) ? rms[ch] : 0; }
+uint16_t CurrentSense_GetOffset(uint8_t ch) { return (ch < CURRENT_SENSE_CH_COUNT) ? offset[ch] : 0; }
+
+uint16_t CurrentSense_GetStatus(void)    { return status; }
+uint16_t CurrentSense_GetAlarm(void)     { return alarm; }
+uint16_t CurrentSense_GetTripCause(void) { return trip_cause; }
+
+uint8_t CurrentSense_IsTripped(uint8_t ch)
+{
+    if (ch >= CURRENT_SENSE_CH_COUNT) return 0;
+    return (alarm & LPSB_ALARM_OC_TRIP(ch)) ? 1 : 0;
+}
+
+void CurrentSense_ClearTrip(uint16_t ch_mask)
+{
+    for (uint8_t ch = 0; ch < CURRENT_SENSE_CH_COUNT; ch++) {
+        if (!(ch_mask & (1u << ch))) continue;
+        alarm &= (uint16_t)~LPSB_ALARM_OC_TRIP(ch);
+        trip_cause &= (uint16_t)~(LPSB_TRIP_CAUSE_PEAK(ch) | LPSB_TRIP_CAUSE_RMS(ch));
+        over_count[ch] = 0;
+    }
+}
+
+void CurrentSense_GetConfig(current_sense_cfg_t *out)
+{
+    if (out) *out = cfg;
+}
+
+void CurrentSense_SetConfig(const current_sense_cfg_t *in)
+{
+    current_sense_cfg_t c;
+
+    if (!in) return;
+    c = *in;
+    if (c.trip_samples == 0) c.trip_samples = 1u;
+    if (c.trip_samples > CURRENT_SENSE_MAX_TRIP_SAMPLES) c.trip_samples = CURRENT_SENSE_MAX_TRIP_SAMPLES;
+    cfg = c;
+}
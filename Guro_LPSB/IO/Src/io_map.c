@@ -26,6 +26,14 @@ uint8_t IO_LPSB_ReadDiscrete(uint16_t idx)
     return (HAL_GPIO_ReadPin(discrete_gpio[idx].port, discrete_gpio[idx].pin) == GPIO_PIN_SET) ? 1 : 0;
 }
 
+uint8_t IO_LPSB_ReadIdBits(void)
+{
+    uint8_t id = 0;
+    for (uint16_t i = 0; i < 4; i++)
+        id |= (uint8_t)(IO_LPSB_ReadDiscrete(LPSB_DISCRETE_ID_BIT1 + i) << i);
+    return id;
+}
+
 void IO_LPSB_WriteCoil(uint16_t idx, uint8_t value)
 {
     if (idx >= COIL_COUNT || coil_gpio[idx].port == NULL) return;
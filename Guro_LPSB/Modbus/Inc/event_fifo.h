@@ -0,0 +1,39 @@
+/**
+ * @file event_fifo.h
+ * @brief LPSB: Timestamped event FIFO (DI / coil edges, alarm changes) read by MAIN with FC24.
+ *        Each event = 4 registers: [seq][type<<8 | index][value][tick_ms low 16 bits].
+ *        FC24 FIFO pointer = next sequence number MAIN expects; events before it are acknowledged
+ *        and dropped, so a lost response is simply read again.
+ */
+#ifndef EVENT_FIFO_LPSB_H
+#define EVENT_FIFO_LPSB_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVENT_FIFO_DEPTH            16u     /* events kept until acknowledged; oldest dropped on overflow */
+#define EVENT_FIFO_REGS_PER_EVENT   4u
+#define EVENT_FIFO_MAX_READ         7u      /* 28 regs per FC24 response (FC24 limit 31) */
+
+typedef enum {
+    EVENT_TYPE_BOOT     = 0,    /* index 0, value = 0; first event after reset */
+    EVENT_TYPE_DISCRETE = 1,    /* index = discrete bit, value = new level */
+    EVENT_TYPE_COIL     = 2,    /* index = coil bit, value = new output level */
+    EVENT_TYPE_ALARM    = 3     /* index = 0, value = new alarm register */
+} EventType_t;
+
+void     EventFifo_Init(void);
+void     EventFifo_Scan(void);
+void     EventFifo_Push(uint8_t type, uint8_t index, uint16_t value);
+uint16_t EventFifo_Read(uint16_t cursor, uint16_t *regs, uint16_t max_events);
+uint16_t EventFifo_Count(void);
+uint16_t EventFifo_GetOverflowCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENT_FIFO_LPSB_H */
@@ -1,6 +1,6 @@
 /**
  * @file modbus_cfg.h
- * @brief Modbus configuration (LPSB = Slave, address 2)
+ * @brief Modbus configuration (LPSB = Slave, address 2 + ID DIP)
  */
 #ifndef MODBUS_CFG_LPSB_H
 #define MODBUS_CFG_LPSB_H
@@ -12,7 +12,8 @@ extern "C" {
 #define MODBUS_MASTER         0
 #define MODBUS_SLAVE          1
 
-#define MODBUS_SLAVE_ADDR     2
+#define MODBUS_SLAVE_ADDR_BASE  2       /* address = base + ID_BIT1..4 DIP value, read at boot */
+#define MODBUS_BOARD_TYPE       0x02    /* FC17 slave id byte: 0x01 = HPSB, 0x02 = LPSB */
 #define MODBUS_UART           huart1
 #define MODBUS_DE_GPIO_PORT   RS485_DE_GPIO_Port
 #define MODBUS_DE_GPIO_PIN    RS485_DE_Pin
@@ -20,6 +21,15 @@ extern "C" {
 #define MODBUS_RTU_RX_BUF_SIZE    64
 #define MODBUS_RTU_TX_BUF_SIZE    64
 #define MODBUS_MAX_PDU_LEN        64
+#define MODBUS_MAX_READ_REGS      ((MODBUS_RTU_TX_BUF_SIZE - 5) / 2)   /* FC03/04 regs per response */
+
+#define MODBUS_BROADCAST_ADDR     0
+
+/* Downstream bus speed codes (LPSB_HOLDING_BAUD_CODE), see modbus_baud.h */
+#define MODBUS_BAUD_TABLE         { 115200u, 230400u, 460800u, 921600u }
+#define MODBUS_BAUD_CODE_COUNT    4u
+#define MODBUS_BAUD_DEFAULT_CODE  0u      /* power-up speed, as set by MX_USART1_UART_Init */
+#define MODBUS_BAUD_FALLBACK_MS   1000u   /* no valid frame this long at a negotiated speed -> default */
 
 #ifdef __cplusplus
 }
@@ -27,6 +27,8 @@ size_t ModbusRTU_BuildFC05Response(uint8_t *pdu, uint8_t slave_addr, uint16_t co
 size_t ModbusRTU_BuildFC06Response(uint8_t *pdu, uint8_t slave_addr, uint16_t reg_addr, uint16_t value);
 size_t ModbusRTU_BuildFC15Response(uint8_t *pdu, uint8_t slave_addr, uint16_t start_addr, uint16_t num_coils);
 size_t ModbusRTU_BuildFC16Response(uint8_t *pdu, uint8_t slave_addr, uint16_t start_addr, uint16_t num_regs);
+size_t ModbusRTU_BuildFC24Response(uint8_t *pdu, uint8_t slave_addr, const uint16_t *regs, uint16_t num_regs);
+size_t ModbusRTU_BuildFC17Response(uint8_t *pdu, uint8_t slave_addr, const uint8_t *data, uint8_t len);
 
 int ModbusRTU_ParseFC05Request(const uint8_t *frame, size_t len, uint16_t *coil_addr, uint8_t *value);
 int ModbusRTU_ParseFC06Request(const uint8_t *frame, size_t len, uint16_t *reg_addr, uint16_t *value);
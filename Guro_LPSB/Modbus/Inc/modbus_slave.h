@@ -1,16 +1,20 @@
 /**
  * @file modbus_slave.h
- * @brief LPSB: Modbus RTU Slave - FC01/02/03/04/05/06/15/16.
+ * @brief LPSB: Modbus RTU Slave - FC01/02/03/04/05/06/15/16/17/24.
+ *        Address = MODBUS_SLAVE_ADDR_BASE + ID_BIT1..4, read once in ModbusSlave_Init.
  */
 #ifndef MODBUS_SLAVE_LPSB_H
 #define MODBUS_SLAVE_LPSB_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 void ModbusSlave_Init(void);
 void ModbusSlave_Poll(void);
+uint8_t ModbusSlave_GetAddress(void);
 
 #ifdef __cplusplus
 }
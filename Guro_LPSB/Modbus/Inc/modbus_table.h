@@ -26,6 +26,8 @@ void     ModbusTable_SetHoldingRegs(uint16_t start, const uint16_t *regs, uint16
 
 uint16_t ModbusTable_GetInputReg(uint16_t addr);
 void     ModbusTable_RefreshInputRegs(void);
+/* FC04 read: input registers 0..INPUT_REG_COUNT-1 or the capture window. Returns 0 on success. */
+int      ModbusTable_ReadInputRegs(uint16_t start, uint16_t num, uint16_t *regs);
 
 #ifdef __cplusplus
 }
@@ -110,6 +110,23 @@ size_t ModbusRTU_BuildFC04Response(uint8_t *pdu, uint8_t slave_addr, const uint1
     }
     return 3 + num_regs * 2;
 }
+size_t ModbusRTU_BuildFC24Response(uint8_t *pdu, uint8_t slave_addr, const uint16_t *regs, uint16_t num_regs)
+{
+    uint16_t byte_count = (uint16_t)(2 + num_regs * 2);
+    pdu[0] = slave_addr; pdu[1] = 0x18;
+    pdu[2] = (uint8_t)(byte_count >> 8); pdu[3] = (uint8_t)(byte_count & 0xFF);
+    pdu[4] = (uint8_t)(num_regs >> 8);   pdu[5] = (uint8_t)(num_regs & 0xFF);
+    for (uint16_t i = 0; i < num_regs; i++) {
+        pdu[6 + i * 2] = (uint8_t)(regs[i] >> 8); pdu[6 + i * 2 + 1] = (uint8_t)(regs[i] & 0xFF);
+    }
+    return 6 + num_regs * 2;
+}
+size_t ModbusRTU_BuildFC17Response(uint8_t *pdu, uint8_t slave_addr, const uint8_t *data, uint8_t len)
+{
+    pdu[0] = slave_addr; pdu[1] = 0x11; pdu[2] = len;
+    for (uint8_t i = 0; i < len; i++) pdu[3 + i] = data[i];
+    return (size_t)(3 + len);
+}
 size_t ModbusRTU_BuildFC05Response(uint8_t *pdu, uint8_t slave_addr, uint16_t coil_addr, uint8_t value)
 {
     pdu[0] = slave_addr; pdu[1] = 0x05;
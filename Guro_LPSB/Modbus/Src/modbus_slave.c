@@ -1,11 +1,13 @@
 /**
  * @file modbus_slave.c
- * @brief LPSB: Modbus Slave - receive, dispatch FC01-04/05/06/15/16, respond. LSB-first.
+ * @brief LPSB: Modbus Slave - receive, dispatch FC01-04/05/06/15/16/17/24, respond. LSB-first.
  */
 #include "modbus_slave.h"
 #include "modbus_rtu.h"
 #include "modbus_cfg.h"
 #include "modbus_table.h"
+#include "event_fifo.h"
+#include "modbus_baud.h"
 #include "io_map.h"
 #include "main.h"
 #include <string.h>
@@ -14,32 +16,82 @@ extern UART_HandleTypeDef huart1;
 
 static uint8_t rx_buf[64];
 static uint16_t rx_len;
-static uint32_t last_rx_tick;
-#define FRAME_SILENCE_MS  5
+static volatile uint16_t rx_ready;      /* frame length from the idle-line event, 0 = none */
+static uint8_t tx_frame[MODBUS_RTU_TX_BUF_SIZE];
+static volatile uint8_t tx_busy;
+static uint8_t slave_addr;      /* MODBUS_SLAVE_ADDR_BASE + ID DIP, latched at boot */
+static uint8_t id_bits;
+static uint16_t uid16;          /* folded unique ID: two boards set to one address never answer alike */
 
 static void set_de_tx(void) { HAL_GPIO_WritePin(MODBUS_DE_GPIO_PORT, MODBUS_DE_GPIO_PIN, GPIO_PIN_SET); }
 static void set_de_rx(void) { HAL_GPIO_WritePin(MODBUS_DE_GPIO_PORT, MODBUS_DE_GPIO_PIN, GPIO_PIN_RESET); }
 
 void ModbusSlave_Init(void)
 {
+    uint32_t uid = HAL_GetUIDw0() ^ HAL_GetUIDw1() ^ HAL_GetUIDw2();
+
+    id_bits = IO_LPSB_ReadIdBits();
+    slave_addr = (uint8_t)(MODBUS_SLAVE_ADDR_BASE + id_bits);
+    uid16 = (uint16_t)(uid ^ (uid >> 16));
     rx_len = 0;
-    last_rx_tick = 0;
+    rx_ready = 0;
+    tx_busy = 0;
     set_de_rx();
+    ModbusBaud_Init();
+}
+
+/* Frame = bytes up to an idle line, so the main loop no longer has to keep up with the byte rate. */
+static void start_rx(void)
+{
+    HAL_UARTEx_ReceiveToIdle_IT(&MODBUS_UART, rx_buf, sizeof(rx_buf));
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    if (huart != &MODBUS_UART) return;
+    rx_ready = Size;
 }
 
+/* Non-blocking TX so capture sampling in the main loop keeps running; DE released in TxCplt. */
 static void send_response(uint8_t *pdu, size_t pdu_len)
 {
-    ModbusRTU_AppendCRC(pdu, pdu_len);
+    if (tx_busy || pdu_len + 2 > sizeof(tx_frame)) return;
+    memcpy(tx_frame, pdu, pdu_len);
+    ModbusRTU_AppendCRC(tx_frame, pdu_len);
+    tx_busy = 1;
     set_de_tx();
-    HAL_UART_Transmit(&MODBUS_UART, pdu, (uint16_t)(pdu_len + 2), 100);
+    if (HAL_UART_Transmit_IT(&MODBUS_UART, tx_frame, (uint16_t)(pdu_len + 2)) != HAL_OK) {
+        set_de_rx();
+        tx_busy = 0;
+    }
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart != &MODBUS_UART) return;
     set_de_rx();
+    tx_busy = 0;
+}
+
+/* Broadcast: only the bus speed commit is accepted, and never answered. */
+static void process_broadcast(void)
+{
+    uint16_t reg_addr, value;
+    if (rx_buf[1] != 0x06) return;
+    if (ModbusRTU_ParseFC06Request(rx_buf, rx_len, &reg_addr, &value) != 0) return;
+    if (reg_addr == LPSB_HOLDING_BAUD_CODE) ModbusBaud_Commit(value);
 }
 
 static void process_frame(void)
 {
     if (rx_len < 4) return;
-    if (rx_buf[0] != MODBUS_SLAVE_ADDR) return;
     if (ModbusRTU_CRC16Check(rx_buf, rx_len) != 0) return;
+    ModbusBaud_OnValidFrame();      /* any good frame, whoever it is for, proves the bus speed */
+    if (rx_buf[0] == MODBUS_BROADCAST_ADDR) {
+        process_broadcast();
+        return;
+    }
+    if (rx_buf[0] != slave_addr) return;
 
     uint8_t fc = rx_buf[1];
     uint8_t tx_pdu[64];
@@ -54,7 +106,7 @@ static void process_frame(void)
             uint8_t coil_bytes[1];
             for (uint16_t i = 0; i < num; i++) coil_bits[i] = ModbusTable_GetCoil(start + i);
             ModbusRTU_PackCoilsLSB(coil_bits, num, coil_bytes);
-            tx_len = ModbusRTU_BuildFC01Response(tx_pdu, MODBUS_SLAVE_ADDR, coil_bytes, num);
+            tx_len = ModbusRTU_BuildFC01Response(tx_pdu, slave_addr, coil_bytes, num);
             send_response(tx_pdu, tx_len);
             break;
         }
@@ -67,7 +119,7 @@ static void process_frame(void)
             uint8_t disc_bytes[1];
             for (uint16_t i = 0; i < num; i++) disc_bits[i] = ModbusTable_GetDiscrete(start + i);
             ModbusRTU_PackCoilsLSB(disc_bits, num, disc_bytes);
-            tx_len = ModbusRTU_BuildFC02Response(tx_pdu, MODBUS_SLAVE_ADDR, disc_bytes, num);
+            tx_len = ModbusRTU_BuildFC02Response(tx_pdu, slave_addr, disc_bytes, num);
             send_response(tx_pdu, tx_len);
             break;
         }
@@ -77,18 +129,17 @@ static void process_frame(void)
             if (start + num > HOLDING_REG_COUNT) break;
             uint16_t regs[HOLDING_REG_COUNT];
             for (uint16_t i = 0; i < num; i++) regs[i] = ModbusTable_GetHoldingReg(start + i);
-            tx_len = ModbusRTU_BuildFC03Response(tx_pdu, MODBUS_SLAVE_ADDR, regs, num);
+            tx_len = ModbusRTU_BuildFC03Response(tx_pdu, slave_addr, regs, num);
             send_response(tx_pdu, tx_len);
             break;
         }
         case 0x04: {
             uint16_t start = (uint16_t)((rx_buf[2] << 8) | rx_buf[3]);
             uint16_t num   = (uint16_t)((rx_buf[4] << 8) | rx_buf[5]);
-            ModbusTable_RefreshInputRegs();
-            if (start + num > INPUT_REG_COUNT) break;
-            uint16_t regs[INPUT_REG_COUNT];
-            for (uint16_t i = 0; i < num; i++) regs[i] = ModbusTable_GetInputReg(start + i);
-            tx_len = ModbusRTU_BuildFC04Response(tx_pdu, MODBUS_SLAVE_ADDR, regs, num);
+            if (num > MODBUS_MAX_READ_REGS) break;
+            uint16_t regs[MODBUS_MAX_READ_REGS];
+            if (ModbusTable_ReadInputRegs(start, num, regs) != 0) break;
+            tx_len = ModbusRTU_BuildFC04Response(tx_pdu, slave_addr, regs, num);
             send_response(tx_pdu, tx_len);
             break;
         }
@@ -97,7 +148,7 @@ static void process_frame(void)
             if (ModbusRTU_ParseFC05Request(rx_buf, rx_len, &coil_addr, &value) != 0) break;
             if (coil_addr >= COIL_COUNT) break;
             ModbusTable_SetCoil(coil_addr, value);
-            tx_len = ModbusRTU_BuildFC05Response(tx_pdu, MODBUS_SLAVE_ADDR, coil_addr, value);
+            tx_len = ModbusRTU_BuildFC05Response(tx_pdu, slave_addr, coil_addr, value);
             send_response(tx_pdu, tx_len);
             break;
         }
@@ -106,7 +157,7 @@ static void process_frame(void)
             if (ModbusRTU_ParseFC06Request(rx_buf, rx_len, &reg_addr, &value) != 0) break;
             if (reg_addr >= HOLDING_REG_COUNT) break;
             ModbusTable_SetHoldingReg(reg_addr, value);
-            tx_len = ModbusRTU_BuildFC06Response(tx_pdu, MODBUS_SLAVE_ADDR, reg_addr, value);
+            tx_len = ModbusRTU_BuildFC06Response(tx_pdu, slave_addr, reg_addr, value);
             send_response(tx_pdu, tx_len);
             break;
         }
@@ -116,7 +167,7 @@ static void process_frame(void)
             if (ModbusRTU_ParseFC15Request(rx_buf, rx_len, &start_addr, &num_coils, coil_bytes, sizeof(coil_bytes)) != 0) break;
             if (start_addr + num_coils > COIL_COUNT) break;
             ModbusTable_SetCoilBytesFrom(start_addr, coil_bytes, num_coils);
-            tx_len = ModbusRTU_BuildFC15Response(tx_pdu, MODBUS_SLAVE_ADDR, start_addr, num_coils);
+            tx_len = ModbusRTU_BuildFC15Response(tx_pdu, slave_addr, start_addr, num_coils);
             send_response(tx_pdu, tx_len);
             break;
         }
@@ -126,7 +177,27 @@ static void process_frame(void)
             if (ModbusRTU_ParseFC16Request(rx_buf, rx_len, &start_addr, &num_regs, regs, HOLDING_REG_COUNT) != 0) break;
             if (start_addr + num_regs > HOLDING_REG_COUNT) break;
             ModbusTable_SetHoldingRegs(start_addr, regs, num_regs);
-            tx_len = ModbusRTU_BuildFC16Response(tx_pdu, MODBUS_SLAVE_ADDR, start_addr, num_regs);
+            tx_len = ModbusRTU_BuildFC16Response(tx_pdu, slave_addr, start_addr, num_regs);
+            send_response(tx_pdu, tx_len);
+            break;
+        }
+        case 0x11: {
+            /* Report Slave ID for MAIN's bus enumeration: board type, run indicator, ID DIP, register counts,
+             * folded UID (MAIN probes twice and compares, to catch two boards at one address) */
+            if (rx_len != 4) break;
+            const uint8_t id[] = { MODBUS_BOARD_TYPE, 0xFF, id_bits, HOLDING_REG_COUNT, INPUT_REG_COUNT,
+                                   (uint8_t)(uid16 & 0xFF), (uint8_t)(uid16 >> 8) };
+            tx_len = ModbusRTU_BuildFC17Response(tx_pdu, slave_addr, id, (uint8_t)sizeof(id));
+            send_response(tx_pdu, tx_len);
+            break;
+        }
+        case 0x18: {
+            /* FIFO pointer = sequence number of the next event MAIN expects (acks everything before it) */
+            if (rx_len != 6) break;
+            uint16_t cursor = (uint16_t)((rx_buf[2] << 8) | rx_buf[3]);
+            uint16_t regs[EVENT_FIFO_MAX_READ * EVENT_FIFO_REGS_PER_EVENT];
+            uint16_t n = EventFifo_Read(cursor, regs, EVENT_FIFO_MAX_READ);
+            tx_len = ModbusRTU_BuildFC24Response(tx_pdu, slave_addr, regs, (uint16_t)(n * EVENT_FIFO_REGS_PER_EVENT));
             send_response(tx_pdu, tx_len);
             break;
         }
@@ -137,14 +208,18 @@ static void process_frame(void)
 
 void ModbusSlave_Poll(void)
 {
-    uint8_t b;
-    while (HAL_UART_Receive(&MODBUS_UART, &b, 1, 0) == HAL_OK) {
-        last_rx_tick = HAL_GetTick();
-        if (rx_len < sizeof(rx_buf))
-            rx_buf[rx_len++] = b;
-    }
-    if (rx_len > 0 && (HAL_GetTick() - last_rx_tick) >= FRAME_SILENCE_MS) {
+    if (rx_ready) {
+        rx_len = rx_ready;
+        rx_ready = 0;
         process_frame();
-        rx_len = 0;
     }
+    ModbusBaud_Poll();
+    /* (Re)arm after a frame, a UART error abort or a speed change */
+    if (MODBUS_UART.RxState == HAL_UART_STATE_READY && !rx_ready)
+        start_rx();
+}
+
+uint8_t ModbusSlave_GetAddress(void)
+{
+    return slave_addr;
 }
@@ -1,9 +1,15 @@
 /**
  * @file modbus_table.c
  * @brief LPSB: Modbus address table - Coil/Discrete from io_map; Holding/Input in RAM.
+ *        Status/Alarm/Trip cause and OC trip config are owned by current_sense; capture
+ *        control/readout by capture.
  */
 #include "modbus_table.h"
 #include "io_map.h"
+#include "current_sense.h"
+#include "capture.h"
+#include "event_fifo.h"
+#include "modbus_baud.h"
 #include <string.h>
 
 static uint8_t  discrete_image[DISCRETE_COUNT];
@@ -19,6 +25,7 @@ uint8_t ModbusTable_GetCoil(uint16_t addr)
 void ModbusTable_SetCoil(uint16_t addr, uint8_t value)
 {
     if (addr >= COIL_COUNT) return;
+    if (value && CurrentSense_IsTripped((uint8_t)addr)) return;   /* OC trip latched: clear alarm first */
     IO_LPSB_WriteCoil(addr, value);
 }
 
@@ -46,20 +53,69 @@ void ModbusTable_RefreshDiscrete(void)
 
 uint16_t ModbusTable_GetHoldingReg(uint16_t addr)
 {
+    current_sense_cfg_t cfg;
+
     if (addr >= HOLDING_REG_COUNT) return 0;
-    return holding_regs[addr];
+    switch (addr) {
+        case LPSB_HOLDING_STATUS:     return CurrentSense_GetStatus();
+        case LPSB_HOLDING_ALARM:      return CurrentSense_GetAlarm();
+        case LPSB_HOLDING_TRIP_CAUSE: return CurrentSense_GetTripCause();
+        case LPSB_HOLDING_OC_PEAK_TRIP_RAW:
+        case LPSB_HOLDING_OC_RMS_TRIP_RAW:
+        case LPSB_HOLDING_OC_TRIP_SAMPLES:
+            CurrentSense_GetConfig(&cfg);
+            if (addr == LPSB_HOLDING_OC_PEAK_TRIP_RAW) return cfg.peak_trip_raw;
+            if (addr == LPSB_HOLDING_OC_RMS_TRIP_RAW)  return cfg.rms_trip_raw;
+            return cfg.trip_samples;
+        case LPSB_HOLDING_CAPTURE_CTRL:      return Capture_GetState();
+        case LPSB_HOLDING_CAPTURE_OFFSET:    return Capture_GetOffset();
+        case LPSB_HOLDING_CAPTURE_TRIG_RAW:  return Capture_GetTrigRaw();
+        case LPSB_HOLDING_CAPTURE_LENGTH:    return Capture_GetLength();
+        case LPSB_HOLDING_CAPTURE_PERIOD_US: return Capture_GetPeriodUs();
+        case LPSB_HOLDING_BAUD_CODE:         return ModbusBaud_GetReg();
+        default:
+            return holding_regs[addr];
+    }
 }
 
 void ModbusTable_SetHoldingReg(uint16_t addr, uint16_t value)
 {
+    current_sense_cfg_t cfg;
+
     if (addr >= HOLDING_REG_COUNT) return;
-    holding_regs[addr] = value;
+    switch (addr) {
+        case LPSB_HOLDING_STATUS:
+        case LPSB_HOLDING_TRIP_CAUSE:
+            break;    /* read-only */
+        case LPSB_HOLDING_ALARM:
+            /* Writing 0 to a latched trip bit clears that port; 1 bits are left as they are */
+            CurrentSense_ClearTrip((uint16_t)(~value & LPSB_ALARM_OC_TRIP_MASK));
+            break;
+        case LPSB_HOLDING_OC_PEAK_TRIP_RAW:
+        case LPSB_HOLDING_OC_RMS_TRIP_RAW:
+        case LPSB_HOLDING_OC_TRIP_SAMPLES:
+            CurrentSense_GetConfig(&cfg);
+            if (addr == LPSB_HOLDING_OC_PEAK_TRIP_RAW)     cfg.peak_trip_raw = value;
+            else if (addr == LPSB_HOLDING_OC_RMS_TRIP_RAW) cfg.rms_trip_raw = value;
+            else                                           cfg.trip_samples = value;
+            CurrentSense_SetConfig(&cfg);
+            break;
+        case LPSB_HOLDING_CAPTURE_CTRL:      Capture_Command(value);     break;
+        case LPSB_HOLDING_CAPTURE_OFFSET:    Capture_SetOffset(value);   break;
+        case LPSB_HOLDING_CAPTURE_TRIG_RAW:  Capture_SetTrigRaw(value);  break;
+        case LPSB_HOLDING_CAPTURE_LENGTH:    Capture_SetLength(value);   break;
+        case LPSB_HOLDING_CAPTURE_PERIOD_US: Capture_SetPeriodUs(value); break;
+        case LPSB_HOLDING_BAUD_CODE:         ModbusBaud_Stage(value);    break;
+        default:
+            holding_regs[addr] = value;
+            break;
+    }
 }
 
 void ModbusTable_SetHoldingRegs(uint16_t start, const uint16_t *regs, uint16_t num)
 {
     for (uint16_t i = 0; i < num && (start + i) < HOLDING_REG_COUNT; i++)
-        holding_regs[start + i] = regs[i];
+        ModbusTable_SetHoldingReg(start + i, regs[i]);
 }
 
 uint16_t ModbusTable_GetInputReg(uint16_t addr)
@@ -75,8 +131,31 @@ void ModbusTable_RefreshInputRegs(void)
     for (uint16_t i = 0; i < 8 && i < DISCRETE_COUNT; i++)
         byte |= (discrete_image[i] ? (1u << i) : 0);
     input_regs[LPSB_INPUT_REG_DISCRETE_IMAGE] = (uint16_t)byte;
-    /* ACS712 ch1..3 raw: ADC raw; fill from IO when wired */
-    input_regs[LPSB_INPUT_REG_ACS_CH1_RAW] = 0;
-    input_regs[LPSB_INPUT_REG_ACS_CH2_RAW] = 0;
-    input_regs[LPSB_INPUT_REG_ACS_CH3_RAW] = 0;
+    for (uint8_t ch = 0; ch < CURRENT_SENSE_CH_COUNT; ch++) {
+        input_regs[LPSB_INPUT_REG_ACS_CH1_RAW + ch]    = CurrentSense_GetRaw(ch);
+        input_regs[LPSB_INPUT_REG_ACS_CH1_PEAK + ch]   = CurrentSense_GetPeak(ch);
+        input_regs[LPSB_INPUT_REG_ACS_CH1_RMS + ch]    = CurrentSense_GetRms(ch);
+        input_regs[LPSB_INPUT_REG_ACS_CH1_OFFSET + ch] = CurrentSense_GetOffset(ch);
+    }
+    input_regs[LPSB_INPUT_REG_CAPTURE_STATUS]    = Capture_GetStatus();
+    input_regs[LPSB_INPUT_REG_CAPTURE_COUNT]     = Capture_GetCount();
+    input_regs[LPSB_INPUT_REG_CAPTURE_PERIOD_US] = Capture_GetPeriodUs();
+    input_regs[LPSB_INPUT_REG_CAPTURE_PRETRIG]   = Capture_GetPretrig();
+    input_regs[LPSB_INPUT_REG_CAPTURE_SEQ]       = Capture_GetSeq();
+    input_regs[LPSB_INPUT_REG_EVENT_PENDING]     = EventFifo_Count();
+    input_regs[LPSB_INPUT_REG_EVENT_OVERFLOW]    = EventFifo_GetOverflowCount();
+}
+
+int ModbusTable_ReadInputRegs(uint16_t start, uint16_t num, uint16_t *regs)
+{
+    if (num == 0) return -1;
+    if (start >= CAPTURE_WINDOW_START) {
+        if (start + num > CAPTURE_WINDOW_START + CAPTURE_WINDOW_REGS) return -1;
+        Capture_ReadWindow((uint16_t)(start - CAPTURE_WINDOW_START), regs, num);
+        return 0;
+    }
+    if (start + num > INPUT_REG_COUNT) return -1;
+    ModbusTable_RefreshInputRegs();
+    for (uint16_t i = 0; i < num; i++) regs[i] = input_regs[start + i];
+    return 0;
 }
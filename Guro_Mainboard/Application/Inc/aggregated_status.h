@@ -5,6 +5,7 @@
 #ifndef AGGREGATED_STATUS_H
 #define AGGREGATED_STATUS_H
 
+#include "io_map.h"
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -19,6 +20,13 @@ typedef uint32_t agg_tick_t;
 #define AGG_ERR_UPSTREAM_RX (1u << 3)
 #define AGG_FLAG_FAULT      (1u << 4)
 #define AGG_ERR_DOWNSTREAM_WRITE (1u << 5)
+#define AGG_ERR_STALE_DATA  (1u << 6)   /* a fitted board's currents are older than AGG_SENSE_MAX_AGE_MS */
+#define AGG_ERR_ADDR_COLLISION (1u << 7) /* two sub-boards answer at one address (bus_enum.h) */
+
+/* Data age per board: [0] = HPSB, [1 + n] = SLAVE_ID_LPSB(n) */
+#define AGG_AGE_SLAVE_COUNT (1u + SLAVE_LPSB_MAPPED_COUNT)
+#define AGG_AGE_NEVER       0xFFFFu     /* never acquired; ages saturate at 0xFFFE ms */
+#define AGG_SENSE_MAX_AGE_MS 1000u      /* older currents are not used for alarms and read as stale */
 
 typedef struct {
 	agg_tick_t timestamp_ms;
@@ -31,16 +39,14 @@ typedef struct {
 	uint16_t  hpsb_status_reg;
 	uint16_t  hpsb_alarm_reg;
 	uint16_t  hpsb_sense_raw[3];
-	uint8_t   lpsb1_coils[3];
-	uint8_t   lpsb2_coils[3];
-	uint8_t   lpsb3_coils[3];
-	uint16_t  lpsb1_alarm_reg;
-	uint16_t  lpsb2_alarm_reg;
-	uint16_t  lpsb3_alarm_reg;
-	uint16_t  lpsb1_sense_raw[3];
-	uint16_t  lpsb2_sense_raw[3];
-	uint16_t  lpsb3_sense_raw[3];
+	/* [n] = SLAVE_ID_LPSB(n) */
+	uint8_t   lpsb_coils[SLAVE_LPSB_MAPPED_COUNT][SLAVE_LPSB_PORT_COUNT];
+	uint16_t  lpsb_alarm_reg[SLAVE_LPSB_MAPPED_COUNT];
+	uint16_t  lpsb_sense_raw[SLAVE_LPSB_MAPPED_COUNT][SLAVE_LPSB_PORT_COUNT];
+	uint16_t  data_age_ms[AGG_AGE_SLAVE_COUNT][SLAVE_AREA_COUNT];  /* [board][SlaveArea_t] */
+	uint8_t   stale_mask;       /* bit b = board b (as data_age_ms) has currents older than AGG_SENSE_MAX_AGE_MS */
 	uint16_t  error_flags;
+	uint16_t  torn_snapshots;   /* slave images kept because every snapshot try was torn (wraps) */
 } aggregated_status_t;
 
 void AggregatedStatus_Clear(aggregated_status_t *s);
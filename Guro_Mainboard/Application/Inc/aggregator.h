@@ -1,6 +1,12 @@
 /**
  * @file aggregator.h
- * @brief Fills aggregated_status from Modbus table, local IO, and env (SHTC3). Call periodically.
+ * @brief Fills aggregated_status from Modbus table, local IO, and env (SHTC3). Incremental: only
+ *        the parts marked in dirty_flags are recomputed, so Aggregator_Update() is cheap to call on
+ *        every main-loop pass and reacts to a change on the same pass. Data ages advance only on
+ *        DIRTY_AGE_TICK, which the caller marks periodically.
+ *        The agg bit image is produced from a const rule table (aggregator.c agg_rules[]); each
+ *        rule is one source word read and one bulk bit write, so a full pass costs
+ *        Aggregator_GetRuleCount() rule evaluations.
  */
 #ifndef AGGREGATOR_H
 #define AGGREGATOR_H
@@ -11,7 +17,10 @@
 extern "C" {
 #endif
 
+/* Marks everything dirty, so the next update fills the whole status and agg bit image */
+void Aggregator_Init(void);
 void Aggregator_Update(aggregated_status_t *out);
+uint8_t Aggregator_GetRuleCount(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,72 @@
+/**
+ * @file app_event.h
+ * @brief MAIN board: typed events from interrupt handlers to the main loop.
+ *        One lock-free single-producer / single-consumer ring per source. A source is the set of
+ *        ISRs at one NVIC priority (they cannot preempt each other), the consumer is the main loop.
+ *        AppEvent_Dispatch() hands each event to the handler registered for its type, in the main
+ *        loop's context; AppEvent_Idle() sleeps until the next interrupt when there is nothing to do.
+ */
+#ifndef APP_EVENT_H
+#define APP_EVENT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_EVENT_QUEUE_LEN     16u     /* per source, power of 2 */
+
+/* Sleep in AppEvent_Idle; 0 keeps the loop spinning (e.g. for a debugger without DBG_SLEEP) */
+#ifndef APP_EVENT_IDLE_WFI
+#define APP_EVENT_IDLE_WFI      1
+#endif
+
+/* Producers; each posts only from ISRs of one NVIC priority */
+typedef enum {
+	APP_EV_SRC_DOWNSTREAM = 0,  /* USART1 interrupt */
+	APP_EV_SRC_UPSTREAM,        /* USART2 and its DMA1 stream 5/6 interrupts */
+	APP_EV_SRC_COUNT
+} app_event_src_t;
+
+typedef enum {
+	APP_EV_DOWNSTREAM_RX = 0,   /* arg = bytes received up to the idle line */
+	APP_EV_UPSTREAM_RX,         /* arg = bytes received up to the idle line */
+	APP_EV_UPSTREAM_TX_DONE,
+	APP_EV_UPSTREAM_ERROR,
+	APP_EV_COUNT
+} app_event_type_t;
+
+typedef struct {
+	uint8_t  type;
+	uint16_t arg;
+} app_event_t;
+
+typedef void (*app_event_handler_t)(const app_event_t *ev);
+
+typedef struct {
+	uint32_t posted;
+	uint32_t dropped;           /* queue full */
+	uint8_t  max_depth;
+} app_event_stats_t;
+
+void AppEvent_Init(void);
+/* Handler for type, or NULL to drop events of that type */
+void AppEvent_SetHandler(app_event_type_t type, app_event_handler_t handler);
+
+/* From an ISR of src's priority only. -1 when the queue is full (counted in dropped). */
+int  AppEvent_Post(app_event_src_t src, app_event_type_t type, uint16_t arg);
+
+/* Main loop: run the handlers of all queued events, return how many */
+uint16_t AppEvent_Dispatch(void);
+uint8_t  AppEvent_Pending(void);
+/* Main loop, end of a pass: WFI unless an event is queued or a scheduler task is due. The 1 ms
+ * SysTick bounds the sleep, so deadlines are met without a wake-up timer. */
+void AppEvent_Idle(void);
+void AppEvent_GetStats(app_event_src_t src, app_event_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_EVENT_H */
@@ -1,6 +1,9 @@
 /**
  * @file app_scheduler.h
  * @brief Minimal 1ms-base task scheduler (no blocking). Use with SysTick or HAL_GetTick().
+ *        Deadline based: each periodic task has its next deadline, kept in deadline order, and is
+ *        released (flagged due) when HAL_GetTick() passes it; tick arithmetic is wrap-safe.
+ *        A task can also be released by an event (AppScheduler_Trigger) or be event-only (period 0).
  */
 #ifndef APP_SCHEDULER_H
 #define APP_SCHEDULER_H
@@ -16,13 +19,38 @@ typedef enum {
 	TASK_DOWNSTREAM_MODBUS,
 	TASK_AGGREGATE_UPDATE,
 	TASK_UPSTREAM_SEND_STATUS,
+	TASK_MAIN_IO_SCAN,
+	TASK_LED_STATUS,
+	TASK_GATEWAY_ACTIONS,
+	TASK_AGGREGATOR,        /* also released by the dirty marks (main.c) */
 	TASK_COUNT
 } app_task_id_t;
 
+#define APP_SCHEDULER_NO_DEADLINE  0xFFFFFFFFu
+
+/* A deadline is missed when a periodic release comes before the previous periodic release was
+ * taken, or when Update comes so late that whole periods pass without a release. A release still
+ * pending from AppScheduler_Trigger is not a miss; triggers are counted on their own. */
+typedef struct {
+	uint32_t runs;          /* releases taken by AppScheduler_IsDue */
+	uint32_t missed;
+	uint32_t triggered;     /* AppScheduler_Trigger calls (one from an ISR racing the main loop may be lost) */
+	uint16_t max_late_ms;   /* worst lateness of a periodic release */
+} app_task_stats_t;
+
 void AppScheduler_Init(void);
 void AppScheduler_Update(void);
 uint8_t AppScheduler_IsDue(app_task_id_t id);
 
+/* Release id now, whatever its period; safe from interrupt handlers */
+void AppScheduler_Trigger(app_task_id_t id);
+/* New period from now on; 0 makes the task event-only */
+void AppScheduler_SetPeriod(app_task_id_t id, uint32_t ms);
+/* ms until the earliest deadline: 0 if a task is already due, APP_SCHEDULER_NO_DEADLINE if none.
+ * The idle loop may sleep this long (an event wakes it earlier). */
+uint32_t AppScheduler_MsToNextDeadline(void);
+void AppScheduler_GetStats(app_task_id_t id, app_task_stats_t *out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,72 @@
+/**
+ * @file app_supervisor.h
+ * @brief MAIN board: task-liveness supervisor in front of the WWDG.
+ *        Each supervised task checks in when it runs and must do so again within its deadline.
+ *        AppSupervisor_Update() refreshes the WWDG only while every task is in time and the
+ *        counter is inside the window, so a starved task or a stalled loop ends in a WWDG reset.
+ *        What led to it - starved tasks, last check-in, loop gaps - is kept in .noinit RAM and
+ *        reported after the reset. Main-loop context, except the early-wakeup record (WWDG IRQ).
+ */
+#ifndef APP_SUPERVISOR_H
+#define APP_SUPERVISOR_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* WWDG set up by MX_WWDG_Init: PCLK1 21 MHz / 4096 / 8 = 1.56 ms per count; counter 127 -> reset at
+ * 63 (98 ms); refresh allowed below the window (96), i.e. from 48 ms on */
+typedef enum {
+	APP_SUP_DOWNSTREAM = 0,     /* Modbus master task */
+	APP_SUP_UPSTREAM,           /* PC link task */
+	APP_SUP_AGGREGATOR,
+	APP_SUP_GATEWAY_ACTIONS,
+	APP_SUP_TASK_COUNT
+} app_sup_task_t;
+
+typedef enum {
+	APP_SUP_CAUSE_NONE = 0,
+	APP_SUP_CAUSE_STARVED,      /* a task missed its deadline; refresh withheld */
+	APP_SUP_CAUSE_STALL         /* WWDG about to reset with every task in time: the loop stopped */
+} app_sup_cause_t;
+
+/* Reset flags of this boot (RCC_CSR) */
+#define APP_SUP_RESET_WWDG      0x01u
+#define APP_SUP_RESET_IWDG      0x02u
+#define APP_SUP_RESET_SW        0x04u
+#define APP_SUP_RESET_POWER     0x08u   /* power-on / brown-out: the kept record is lost */
+#define APP_SUP_RESET_PIN       0x10u
+
+#define APP_SUP_GAP_BUCKETS     8u      /* loop gap: 0, 1, 2-3, 4-7, 8-15, 16-31, 32-63, >= 64 ms */
+
+typedef struct {
+	uint8_t  cause;             /* app_sup_cause_t */
+	uint8_t  starved_mask;      /* bit i = task i past its deadline */
+	uint8_t  last_checkin;      /* task that checked in last; a stall is in whatever ran after it */
+	uint32_t uptime_ms;
+	uint16_t max_gap_ms;        /* longest main-loop pass */
+	uint16_t gap_hist[APP_SUP_GAP_BUCKETS];     /* saturating counts */
+} app_sup_record_t;
+
+typedef struct {
+	uint8_t  reset_flags;       /* APP_SUP_RESET_* of this boot */
+	uint32_t wwdg_resets;       /* since power-on */
+	uint32_t starve_events;     /* this boot: passes that withheld the refresh */
+	app_sup_record_t prev;      /* boot before the reset; all 0 after power-on */
+	app_sup_record_t now;       /* this boot so far */
+} app_sup_report_t;
+
+/* Call once after MX_WWDG_Init and before any long init step: the WWDG is already running */
+void AppSupervisor_Init(void);
+void AppSupervisor_CheckIn(app_sup_task_t id);
+/* Call every main-loop pass (at most a few ms apart) */
+void AppSupervisor_Update(void);
+void AppSupervisor_GetReport(app_sup_report_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_SUPERVISOR_H */
@@ -0,0 +1,88 @@
+/**
+ * @file profiler.h
+ * @brief MAIN board: main-loop profiler on the DWT cycle counter (core clock cycles).
+ *        Each probe keeps count, min, max, mean and a histogram of its run times; top-level probes
+ *        also add up to the loop utilisation (busy cycles / all cycles, per 1 s window).
+ *        Build with PROFILER_ENABLED=1 to use it; at 0 the PROFILE_* macros expand to nothing and
+ *        the getters report no probes. Main-loop context only.
+ */
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED            0
+#endif
+
+#if PROFILER_ENABLED
+#include "main.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	PROF_LOOP = 0,              /* one main-loop pass, start to start (includes the WFI idle) */
+	PROF_EVENT_DISPATCH,        /* AppEvent_Dispatch */
+	PROF_LED_TICK,              /* LED_Status_Tick_1ms (TASK_LED_STATUS) */
+	PROF_SCHEDULER,             /* AppScheduler_Update */
+	PROF_TASK_UPSTREAM_POLL,
+	PROF_UPSTREAM_PC_POLL,      /* UpstreamPC_Poll, inside TASK_UPSTREAM_POLL */
+	PROF_TASK_DOWNSTREAM_MODBUS,
+	PROF_MODBUS_MASTER_POLL,    /* ModbusMaster_Poll, inside TASK_DOWNSTREAM_MODBUS */
+	PROF_TASK_MAIN_IO_SCAN,
+	PROF_TASK_AGGREGATE_UPDATE,
+	PROF_GATEWAY_ACTIONS,       /* Gateway_Action_Update (TASK_GATEWAY_ACTIONS) */
+	PROF_AGGREGATOR,            /* Aggregator_Update (TASK_AGGREGATOR) */
+	PROF_UPSTREAM_REPORT,       /* UpstreamPC_Report (TASK_UPSTREAM_SEND_STATUS) */
+	PROF_COUNT
+} Profiler_ProbeId_t;
+
+/* Probes not counted as busy time: the loop itself and those nested in another probe */
+#define PROFILER_NOT_BUSY_MASK      ((1u << PROF_LOOP) | (1u << PROF_UPSTREAM_PC_POLL) | \
+                                     (1u << PROF_MODBUS_MASTER_POLL))
+
+/* Bucket b < 7 holds runs of less than 256 << (2 * b) cycles: 256, 1K, 4K ... 1M, then >= 1M */
+#define PROFILER_HIST_BUCKETS       8u
+#define PROFILER_WINDOW_MS          1000u
+
+typedef struct {
+	uint32_t count;
+	uint32_t min_cycles;        /* 0 while count is 0 */
+	uint32_t max_cycles;
+	uint32_t mean_cycles;
+	uint16_t hist[PROFILER_HIST_BUCKETS];   /* saturating counts */
+} Profiler_Probe_t;
+
+#if PROFILER_ENABLED
+#define PROFILE_BEGIN(id)   uint32_t profile_t0_##id = DWT->CYCCNT
+#define PROFILE_END(id)     Profiler_Record((id), DWT->CYCCNT - profile_t0_##id)
+#define PROFILE_LOOP()      Profiler_Loop()
+#else
+#define PROFILE_BEGIN(id)   ((void)0)
+#define PROFILE_END(id)     ((void)0)
+#define PROFILE_LOOP()      ((void)0)
+#endif
+
+/* Start the DWT cycle counter and clear the figures */
+void Profiler_Init(void);
+void Profiler_Record(Profiler_ProbeId_t id, uint32_t cycles);
+/* Call at the top of every main-loop pass: times PROF_LOOP and rolls the utilisation window */
+void Profiler_Loop(void);
+void Profiler_Clear(void);
+
+/* Probes compiled in: PROF_COUNT, or 0 when disabled */
+uint8_t  Profiler_ProbeCount(void);
+/* -1 on a bad id or when disabled */
+int      Profiler_GetProbe(Profiler_ProbeId_t id, Profiler_Probe_t *out);
+/* Busy share of the last complete window in 0.1 % (0..1000) */
+uint16_t Profiler_GetUtilisation(void);
+uint16_t Profiler_CpuMHz(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROFILER_H */
@@ -0,0 +1,19 @@
+/**
+ * @file uart_dispatch.h
+ * @brief HAL UART callbacks -> app events -> port owners (uart_dispatch.c).
+ */
+#ifndef UART_DISPATCH_H
+#define UART_DISPATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Register the UART event handlers; after AppEvent_Init, before the ports start receiving */
+void UartDispatch_Init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UART_DISPATCH_H */
@@ -1,6 +1,23 @@
 /**
  * @file upstream_pc_protocol.h
- * @brief Upstream PC link over USART2: frame-based RX (ReceiveToIdle_IT), simple frame format, non-blocking TX.
+ * @brief Upstream PC link over USART2: byte-stream RX parsed as it arrives, COBS frames, non-blocking TX.
+ *        Status frames go out either every TASK_UPSTREAM_SEND_STATUS period or, in event mode, as soon
+ *        as a reported field changes (rate-limited), with a slow heartbeat while nothing changes.
+ *
+ *        Framing, both directions: 0x00 | COBS(body CRC16) | 0x00. The body never contains 0x00 once
+ *        COBS-encoded, so a 0x00 always ends a frame and a receiver resyncs at the next one; the CRC is
+ *        the Modbus CRC16 of the body, low byte first. PC -> MAIN body: cmd payload...
+ *
+ *        Status frame body (version 2): ver type seq base | TLV...
+ *        TLV = tag, len, value (little-endian). seq is +1 per frame so the PC can count drops.
+ *        A keyframe ('K', base = seq) carries every field. A delta ('D') carries the fields that
+ *        changed since the frame the PC last acknowledged (base) or since any frame sent after it;
+ *        the PC applies it to its current state. The PC acknowledges with command UPSTREAM_CMD_ACK,
+ *        payload = seq. Without acks, or UPSTREAM_KEYFRAME_MS after the last one, a keyframe is sent.
+ *
+ *        Commands (upstream_cmd.c): cmd id args..., id chosen by the PC. Each is answered at once by a
+ *        reply frame 'A' (queued, or why not) and, once carried out, by 'C' with the outcome, so the PC
+ *        can have several in flight. Reply body: ver type id result.
  */
 #ifndef UPSTREAM_PC_PROTOCOL_H
 #define UPSTREAM_PC_PROTOCOL_H
@@ -12,20 +29,80 @@
 extern "C" {
 #endif
 
-#define UPSTREAM_STX  0x02
-#define UPSTREAM_ETX  0x03
-#define UPSTREAM_RX_BUF_SIZE  64
-#define UPSTREAM_TX_BUF_SIZE  128
+#define UPSTREAM_FRAME_DELIM   0x00u
+#define UPSTREAM_RX_RING_SIZE  128u     /* bytes between ISR and parser; power of 2 */
+#define UPSTREAM_RX_BUF_SIZE   64u      /* largest decoded PC frame (cmd + payload + CRC) */
+#define UPSTREAM_TX_BUF_SIZE   128u     /* encoded frame incl. both delimiters */
+
+/* Event mode: frames at least MIN_GAP apart, counted from the start of the last one (a keyframe is
+ * 97 bytes on the wire, ~101 ms at 9600 baud 8N1, so 150 ms leaves ~50 ms of idle line after it), and
+ * one every HEARTBEAT when nothing reported has changed. Temperature/RH and the timestamp do not
+ * trigger a frame. */
+#define UPSTREAM_EVENT_MIN_GAP_MS    150u
+#define UPSTREAM_EVENT_HEARTBEAT_MS  5000u
+
+#define UPSTREAM_FRAME_VERSION       2u
+#define UPSTREAM_FRAME_KEY           0x4Bu   /* 'K' */
+#define UPSTREAM_FRAME_DELTA         0x44u   /* 'D' */
+#define UPSTREAM_CMD_ACK             0x06u   /* PC -> MAIN, payload: seq of the frame applied */
+#define UPSTREAM_KEYFRAME_MS         10000u
+#define UPSTREAM_DELTA_HISTORY       8u      /* frames kept for delta bases; more unacked -> keyframe */
+#define UPSTREAM_REPLY_QUEUE_LEN     16u     /* pending 'A'/'C' replies, power of 2 */
+
+/* PC -> MAIN commands; multi-byte args little-endian */
+#define UPSTREAM_CMD_WRITE_DO        0x10u   /* id, u16 value, u16 mask: MAIN DO bitmap */
+#define UPSTREAM_CMD_WRITE_COIL      0x11u   /* id, slave, u16 coil, u8 value: FC05 to a sub-board */
+#define UPSTREAM_CMD_DOOR_PULSE      0x12u   /* id, door 1..2 [, u16 ms, default 300]; restarts a running pulse */
+#define UPSTREAM_CMD_WRITE_REG       0x13u   /* id, slave (0 = broadcast), u16 reg, u16 value: FC06 */
+
+/* MAIN -> PC replies */
+#define UPSTREAM_REPLY_ACK           0x41u   /* 'A' */
+#define UPSTREAM_REPLY_DONE          0x43u   /* 'C' */
+#define UPSTREAM_RESULT_OK           0x00u   /* 'A': queued, 'C': done (downstream write echoed) */
+#define UPSTREAM_RESULT_QUEUE_FULL   0x01u
+#define UPSTREAM_RESULT_BAD_REQUEST  0x02u   /* unknown command or bad arguments */
+#define UPSTREAM_RESULT_FAILED       0x03u   /* downstream timeout, exception or bad frame */
+
+/* TLV tags */
+#define UPSTREAM_TAG_TIMESTAMP       0x01u   /* u32 ms */
+#define UPSTREAM_TAG_ENV_TEMP        0x02u   /* s16 degC x10 */
+#define UPSTREAM_TAG_ENV_RH          0x03u   /* u16 % x10 */
+#define UPSTREAM_TAG_MAIN_DI         0x04u   /* u8 bitmap */
+#define UPSTREAM_TAG_MAIN_DO         0x05u   /* u8 bitmap */
+#define UPSTREAM_TAG_ERROR_FLAGS     0x06u   /* u16 AGG_ERR_* */
+#define UPSTREAM_TAG_STALE_MASK      0x07u   /* u8 */
+#define UPSTREAM_TAG_HPSB_COILS      0x10u   /* u8 */
+#define UPSTREAM_TAG_HPSB_DISCRETE   0x11u   /* u8 */
+#define UPSTREAM_TAG_HPSB_STATUS     0x12u   /* u16 */
+#define UPSTREAM_TAG_HPSB_ALARM      0x13u   /* u16 */
+#define UPSTREAM_TAG_HPSB_SENSE      0x14u   /* 3 x u16 raw */
+#define UPSTREAM_TAG_LPSB(n)         (0x20u + (n))   /* u8 coils bitmap, u16 alarm reg */
+#define UPSTREAM_TAG_LPSB_SENSE(n)   (0x30u + (n))   /* 3 x u16 raw */
+
+typedef enum {
+	UPSTREAM_REPORT_PERIODIC = 0,
+	UPSTREAM_REPORT_EVENT
+} upstream_report_mode_t;
+
+#define UPSTREAM_REPORT_MODE_DEFAULT  UPSTREAM_REPORT_EVENT
 
 void UpstreamPC_Init(void);
 void UpstreamPC_Poll(void);
 int  UpstreamPC_SendStatus(const aggregated_status_t *status);
+/* Call every main-loop pass. periodic_due = TASK_UPSTREAM_SEND_STATUS is due (periodic mode only).
+ * Returns 1 if a frame was started, 0 otherwise. */
+int  UpstreamPC_Report(const aggregated_status_t *status, uint8_t periodic_due);
+void UpstreamPC_SetReportMode(upstream_report_mode_t mode);
+/* Queue a reply frame (UPSTREAM_REPLY_*); sent from UpstreamPC_Poll ahead of status frames.
+ * Returns -1 if the queue is full. */
+int  UpstreamPC_QueueReply(uint8_t type, uint8_t id, uint8_t result);
 
 typedef void (*upstream_cmd_cb_t)(uint8_t cmd, const uint8_t *data, uint8_t len);
 void UpstreamPC_SetCommandCallback(upstream_cmd_cb_t cb);
 
-void UpstreamPC_UART_RxEventCallback(uint16_t Size);
+void UpstreamPC_UART_RxCpltCallback(void);
 void UpstreamPC_TxCpltCallback(void);
+void UpstreamPC_ErrorCallback(void);
 
 #ifdef __cplusplus
 }
@@ -10,6 +10,10 @@ void AggregatedStatus_Clear(aggregated_status_t *s)
 	memset(s, 0, sizeof(*s));
 	s->env_temp_cx10 = -32768;
 	s->env_rh_x10    = 0xFFFF;
+	for (unsigned b = 0; b < AGG_AGE_SLAVE_COUNT; b++) {
+		for (unsigned a = 0; a < SLAVE_AREA_COUNT; a++)
+			s->data_age_ms[b][a] = AGG_AGE_NEVER;
+	}
 }
 
 void AggregatedStatus_UpdateTimestamp(aggregated_status_t *s, agg_tick_t now_ms)
@@ -1,146 +1,333 @@
+/**
+ * @file aggregator.c
+ * @brief Incremental aggregation in two steps.
+ *        1) Each section below depends on one kind of change mark and refreshes only its own
+ *           fields of aggregated_status: MAIN DI / DO, one slave image, the age tick (data age,
+ *           stale_mask, HPSB OC count) or tick/comm/gateway (error_flags).
+ *        2) The agg bit image is described by agg_rules[]: each rule copies a run of bits from one
+ *           source word to consecutive agg bits. A pass evaluates only the rules whose source
+ *           depends on what step 1 refreshed; Aggregator_Init() resolves those dependencies.
+ */
 #include "aggregator.h"
 #include "io_map.h"
 #include "modbus_table.h"
 #include "modbus_master.h"
+#include "bus_enum.h"
 #include "main.h"
 #include "h2tech_address_map.h"
 #include "gateway_actions.h"
+#include "dirty_flags.h"
 
 /* Overcurrent thresholds (configurable). Raw ADC/register value above this sets alarm. */
 #define HPSB_OC_THRESHOLD_RAW  2048u   /* 12-bit ADC: adjust for HCT17W */
 #define LPSB_OC_THRESHOLD_RAW  2048u   /* ACS712: margin above/below mid-scale; adjust per hardware */
 #define LPSB_SENSE_MIDSCALE    2048u   /* 12-bit mid-scale (0A for ACS712); alarm if |raw - mid| > threshold */
-#define HPSB_OC_CYCLES_REQUIRED 3u    /* Consecutive cycles above threshold before ALM5/6/7 */
+#define HPSB_OC_CYCLES_REQUIRED 3u    /* Consecutive age ticks (100 ms) above threshold before ALM5/6/7 */
+#define SNAPSHOT_TRIES          3u    /* re-read a slave image the master republished meanwhile; if every
+                                         try is torn the previous image is kept and retried next pass */
 
-static int lpsb_oc(const uint16_t raw[3])
+/* Sense raw = InputReg 1..3, present on both board types and in the zero view of absent slaves */
+_Static_assert(SLAVE_LPSB_INPUT_COUNT >= 4u && SLAVE_HPSB_INPUT_COUNT >= 4u, "sense regs 1..3 missing");
+
+/* Rule sources: one word of aggregated_status (or derived from it), bit n = item n */
+typedef enum {
+	AGG_SRC_CONST0 = 0,
+	AGG_SRC_MAIN_DI,        /* main_di */
+	AGG_SRC_MAIN_DO,        /* main_do */
+	AGG_SRC_HPSB_COILS,     /* hpsb_coils */
+	AGG_SRC_LPSB_COILS,     /* lpsb_coils[arg][0..2] */
+	AGG_SRC_HPSB_ALARM,     /* hpsb_alarm_reg (OC after HPSB_OC_CYCLES_REQUIRED ticks) */
+	AGG_SRC_LPSB_OC,        /* bit n: LPSB n fresh raw OC or its own latched trip */
+	AGG_SRC_ERROR_FLAGS     /* error_flags */
+} AggSrc_t;
+
+/* agg bits [bit, bit + count) = source bits [shift, shift + count) */
+typedef struct {
+	uint8_t bit;
+	uint8_t count;
+	uint8_t src;
+	uint8_t arg;
+	uint8_t shift;
+} AggRule_t;
+
+#define AGR(_bit, _count, _src, _arg, _shift) \
+	{ .bit = (_bit), .count = (_count), .src = (_src), .arg = (_arg), .shift = (_shift) }
+
+/* error_flags bit positions used by the alarm rules */
+_Static_assert(AGG_ERR_COMM_HPSB == (1u << 0) && AGG_ERR_COMM_LPSB == (1u << 1) && AGG_ERR_SHTC3 == (1u << 2) &&
+               AGG_ERR_UPSTREAM_RX == (1u << 3) && AGG_ERR_DOWNSTREAM_WRITE == (1u << 5), "alarm rule shifts");
+
+static const AggRule_t agg_rules[] = {
+	/* 0821~0836 ON/OFF 1~16: MAIN DO 0~1, HPSB coils 0~2, LPSB1/2/3 coils 0~2, reserved */
+	AGR(AGG_BIT_ONOFF_1,  2, AGG_SRC_MAIN_DO,    0, 0),
+	AGR(AGG_BIT_ONOFF_3,  3, AGG_SRC_HPSB_COILS, 0, 0),
+	AGR(AGG_BIT_ONOFF_6,  3, AGG_SRC_LPSB_COILS, 0, 0),
+	AGR(AGG_BIT_ONOFF_9,  3, AGG_SRC_LPSB_COILS, 1, 0),
+	AGR(AGG_BIT_ONOFF_12, 3, AGG_SRC_LPSB_COILS, 2, 0),
+	AGR(AGG_BIT_ONOFF_15, 2, AGG_SRC_CONST0,     0, 0),
+
+	/* Door sensors: MAIN DI 0,1 = magnetic 1,2; 2,3 = button 1,2 */
+	AGR(AGG_BIT_DOOR_MAG_1, 2, AGG_SRC_MAIN_DI, 0, 0),
+	AGR(AGG_BIT_DOOR_BTN_1, 2, AGG_SRC_MAIN_DI, 0, 2),
+
+	/* Alarms: 1=HPSB comm, 2=any LPSB comm, 3=SHTC3, 4=door fault, 5-7=HPSB OC, 8-10=LPSB1/2/3 OC, 11=PC link, 12=downstream write */
+	AGR(AGG_BIT_ALM_1,  3, AGG_SRC_ERROR_FLAGS, 0, 0),
+	AGR(AGG_BIT_ALM_4,  1, AGG_SRC_CONST0,      0, 0),
+	AGR(AGG_BIT_ALM_5,  3, AGG_SRC_HPSB_ALARM,  0, 0),
+	AGR(AGG_BIT_ALM_8,  3, AGG_SRC_LPSB_OC,     0, 0),
+	AGR(AGG_BIT_ALM_11, 1, AGG_SRC_ERROR_FLAGS, 0, 3),
+	AGR(AGG_BIT_ALM_12, 1, AGG_SRC_ERROR_FLAGS, 0, 5),
+
+	/* CMD ON/OFF 1~7: mirror of output state (MAIN DO 0~1, HPSB coils 0~2, LPSB1 coils 0~1) */
+	AGR(AGG_BIT_CMD_ONOFF_1, 2, AGG_SRC_MAIN_DO,    0, 0),
+	AGR(AGG_BIT_CMD_ONOFF_3, 3, AGG_SRC_HPSB_COILS, 0, 0),
+	AGR(AGG_BIT_CMD_ONOFF_6, 2, AGG_SRC_LPSB_COILS, 0, 0),
+};
+
+#define AGG_RULE_COUNT  (sizeof(agg_rules) / sizeof(agg_rules[0]))
+
+/* What a pass refreshed in step 1; a rule runs when its source depends on any of it */
+#define DEP_MAIN_DI     (1u << 0)
+#define DEP_MAIN_DO     (1u << 1)
+#define DEP_HPSB        (1u << 2)
+#define DEP_AGE_TICK    (1u << 3)
+#define DEP_ERRORS      (1u << 4)
+#define DEP_LPSB(n)     (1u << (8u + (n)))
+#define DEP_LPSB_ANY    (((1u << SLAVE_LPSB_MAPPED_COUNT) - 1u) << 8u)
+#define DEP_ALL         0xFFFFFFFFu
+
+static uint8_t  hpsb_oc_count[3];
+static uint32_t rule_deps[AGG_RULE_COUNT];
+static uint8_t  full_pass;
+
+static uint16_t age_reg(SlaveId_t s, SlaveArea_t area)
+{
+	uint32_t age = ModbusTable_GetAgeMs(s, area);
+	if (age == MODBUS_AGE_NEVER) return AGG_AGE_NEVER;
+	return (age >= AGG_AGE_NEVER) ? (uint16_t)(AGG_AGE_NEVER - 1u) : (uint16_t)age;
+}
+
+static int lpsb_oc(const uint16_t raw[SLAVE_LPSB_PORT_COUNT])
 {
-	for (int i = 0; i < 3; i++) {
+	for (int i = 0; i < (int)SLAVE_LPSB_PORT_COUNT; i++) {
 		if (raw[i] > LPSB_SENSE_MIDSCALE + LPSB_OC_THRESHOLD_RAW) return 1;
 		if (raw[i] < LPSB_SENSE_MIDSCALE && (LPSB_SENSE_MIDSCALE - raw[i]) > LPSB_OC_THRESHOLD_RAW) return 1;
 	}
 	return 0;
 }
 
-void Aggregator_Update(aggregated_status_t *out)
+static uint32_t src_deps(const AggRule_t *r)
 {
-	if (!out) return;
+	switch (r->src) {
+		case AGG_SRC_MAIN_DI:     return DEP_MAIN_DI;
+		case AGG_SRC_MAIN_DO:     return DEP_MAIN_DO;
+		case AGG_SRC_HPSB_COILS:  return DEP_HPSB;
+		case AGG_SRC_LPSB_COILS:  return DEP_LPSB(r->arg);
+		case AGG_SRC_HPSB_ALARM:  return DEP_AGE_TICK;
+		case AGG_SRC_LPSB_OC:     return DEP_LPSB_ANY | DEP_AGE_TICK;     /* stale_mask gates the raw check */
+		case AGG_SRC_ERROR_FLAGS: return DEP_ERRORS;
+		default:                  return 0;                               /* constants: full pass only */
+	}
+}
 
-	out->timestamp_ms = HAL_GetTick();
+static uint32_t src_word(const aggregated_status_t *s, const AggRule_t *r)
+{
+	uint32_t w = 0;
 
-	out->env_temp_cx10 = -32768;
-	out->env_rh_x10    = 0xFFFF;
+	switch (r->src) {
+		case AGG_SRC_MAIN_DI:     return s->main_di;
+		case AGG_SRC_MAIN_DO:     return s->main_do;
+		case AGG_SRC_HPSB_COILS:  return s->hpsb_coils;
+		case AGG_SRC_HPSB_ALARM:  return s->hpsb_alarm_reg;
+		case AGG_SRC_ERROR_FLAGS: return s->error_flags;
+		case AGG_SRC_LPSB_COILS:
+			for (unsigned p = 0; p < SLAVE_LPSB_PORT_COUNT; p++)
+				w |= (uint32_t)(s->lpsb_coils[r->arg][p] ? 1u : 0u) << p;
+			return w;
+		case AGG_SRC_LPSB_OC:
+			/* MAIN-side raw check (fresh currents only) or the LPSB's own latched trip */
+			for (unsigned n = 0; n < SLAVE_LPSB_MAPPED_COUNT; n++) {
+				int raw_oc = !(s->stale_mask & (1u << (1u + n))) && lpsb_oc(s->lpsb_sense_raw[n]);
+				if (raw_oc || (s->lpsb_alarm_reg[n] & LPSB_ALARM_OC_TRIP_MASK)) w |= 1u << n;
+			}
+			return w;
+		default:
+			return 0;
+	}
+}
+
+static void eval_rules(const aggregated_status_t *s, uint32_t deps)
+{
+	for (unsigned i = 0; i < AGG_RULE_COUNT; i++) {
+		const AggRule_t *r = &agg_rules[i];
+		if (deps != DEP_ALL && !(rule_deps[i] & deps)) continue;
+		uint32_t bits = src_word(s, r) >> r->shift;
+		H2Map_WriteAggBits(r->bit, r->count, bits);
+	}
+}
 
+static void update_main_di(aggregated_status_t *out)
+{
 	out->main_di = 0;
 	for (int i = 0; i < MAIN_DI_COUNT; i++)
 		out->main_di |= (IO_Main_ReadDI((MainDiChannel_t)i) ? (1u << i) : 0);
+}
+
+static void update_main_do(aggregated_status_t *out)
+{
 	out->main_do = 0;
 	for (int i = 0; i < 2; i++)
 		out->main_do |= (IO_Main_ReadDO((MainDoChannel_t)i) ? (1u << i) : 0);
+}
 
-	out->hpsb_coils      = 0;
-	out->hpsb_discrete   = 0;
-	out->hpsb_status_reg = 0;
-	out->hpsb_alarm_reg  = 0;
-	out->hpsb_sense_raw[0] = ModbusTable_GetInputReg(SLAVE_ID_HPSB, 1);
-	out->hpsb_sense_raw[1] = ModbusTable_GetInputReg(SLAVE_ID_HPSB, 2);
-	out->hpsb_sense_raw[2] = ModbusTable_GetInputReg(SLAVE_ID_HPSB, 3);
-	for (int i = 0; i < MODBUS_COIL_COUNT; i++)
-		out->hpsb_coils |= (ModbusTable_GetCoil(SLAVE_ID_HPSB, (uint16_t)i) ? (1u << i) : 0);
-	for (int i = 0; i < MODBUS_DISCRETE_COUNT; i++)
-		out->hpsb_discrete |= (ModbusTable_GetDiscrete(SLAVE_ID_HPSB, (uint16_t)i) ? (1u << i) : 0);
-	out->hpsb_status_reg = ModbusTable_GetHoldingReg(SLAVE_ID_HPSB, HOLDING_REG_STATUS);
-	out->hpsb_alarm_reg  = ModbusTable_GetHoldingReg(SLAVE_ID_HPSB, HOLDING_REG_ALARM);
-
-	/* Separate LPSB aggregator image: coils[3] and alarm/sense per slave */
-	out->lpsb1_coils[0] = ModbusTable_GetCoil(SLAVE_ID_LPSB1, 0);
-	out->lpsb1_coils[1] = ModbusTable_GetCoil(SLAVE_ID_LPSB1, 1);
-	out->lpsb1_coils[2] = ModbusTable_GetCoil(SLAVE_ID_LPSB1, 2);
-	out->lpsb2_coils[0] = ModbusTable_GetCoil(SLAVE_ID_LPSB2, 0);
-	out->lpsb2_coils[1] = ModbusTable_GetCoil(SLAVE_ID_LPSB2, 1);
-	out->lpsb2_coils[2] = ModbusTable_GetCoil(SLAVE_ID_LPSB2, 2);
-	out->lpsb3_coils[0] = ModbusTable_GetCoil(SLAVE_ID_LPSB3, 0);
-	out->lpsb3_coils[1] = ModbusTable_GetCoil(SLAVE_ID_LPSB3, 1);
-	out->lpsb3_coils[2] = ModbusTable_GetCoil(SLAVE_ID_LPSB3, 2);
-	out->lpsb1_alarm_reg  = ModbusTable_GetHoldingReg(SLAVE_ID_LPSB1, HOLDING_REG_ALARM);
-	out->lpsb2_alarm_reg  = ModbusTable_GetHoldingReg(SLAVE_ID_LPSB2, HOLDING_REG_ALARM);
-	out->lpsb3_alarm_reg  = ModbusTable_GetHoldingReg(SLAVE_ID_LPSB3, HOLDING_REG_ALARM);
-	out->lpsb1_sense_raw[0] = ModbusTable_GetInputReg(SLAVE_ID_LPSB1, 1);
-	out->lpsb1_sense_raw[1] = ModbusTable_GetInputReg(SLAVE_ID_LPSB1, 2);
-	out->lpsb1_sense_raw[2] = ModbusTable_GetInputReg(SLAVE_ID_LPSB1, 3);
-	out->lpsb2_sense_raw[0] = ModbusTable_GetInputReg(SLAVE_ID_LPSB2, 1);
-	out->lpsb2_sense_raw[1] = ModbusTable_GetInputReg(SLAVE_ID_LPSB2, 2);
-	out->lpsb2_sense_raw[2] = ModbusTable_GetInputReg(SLAVE_ID_LPSB2, 3);
-	out->lpsb3_sense_raw[0] = ModbusTable_GetInputReg(SLAVE_ID_LPSB3, 1);
-	out->lpsb3_sense_raw[1] = ModbusTable_GetInputReg(SLAVE_ID_LPSB3, 2);
-	out->lpsb3_sense_raw[2] = ModbusTable_GetInputReg(SLAVE_ID_LPSB3, 3);
+/* One snapshot: every field comes from the same published image. The fields are copied out of
+ * the image first and only stored once the snapshot checks valid; -1 leaves out untouched. */
+static int update_hpsb(aggregated_status_t *out)
+{
+	SlaveSnapshot_t v;
+	uint16_t sense[3];
+	for (unsigned t = 0; t < SNAPSHOT_TRIES; t++) {
+		ModbusTable_GetSnapshot(SLAVE_ID_HPSB, &v);
+		uint8_t  coils    = v.head->coils;
+		uint8_t  discrete = v.head->discrete;
+		uint16_t status   = v.head->holding[HOLDING_REG_STATUS];
+		for (int i = 0; i < 3; i++)
+			sense[i] = v.input[1 + i];
+		if (!ModbusTable_SnapshotValid(&v)) continue;
+		out->hpsb_coils      = coils;
+		out->hpsb_discrete   = discrete;
+		out->hpsb_status_reg = status;
+		for (int i = 0; i < 3; i++)
+			out->hpsb_sense_raw[i] = sense[i];
+		return 0;
+	}
+	return -1;
+}
 
-	out->error_flags = 0;
-	if (!ModbusMaster_IsCommOk(SLAVE_ID_HPSB)) out->error_flags |= AGG_ERR_COMM_HPSB;
-	if (!ModbusMaster_IsCommOk(SLAVE_ID_LPSB1) || !ModbusMaster_IsCommOk(SLAVE_ID_LPSB2) || !ModbusMaster_IsCommOk(SLAVE_ID_LPSB3))
-		out->error_flags |= AGG_ERR_COMM_LPSB;
-	if (Gateway_Action_PollDownstreamWriteFail()) out->error_flags |= AGG_ERR_DOWNSTREAM_WRITE;
+static int update_lpsb(aggregated_status_t *out, unsigned n)
+{
+	SlaveSnapshot_t v;
+	uint16_t sense[SLAVE_LPSB_PORT_COUNT];
+	for (unsigned t = 0; t < SNAPSHOT_TRIES; t++) {
+		ModbusTable_GetSnapshot(SLAVE_ID_LPSB(n), &v);
+		uint8_t  coils = v.head->coils;
+		uint16_t alarm = v.head->holding[HOLDING_REG_ALARM];
+		for (unsigned p = 0; p < SLAVE_LPSB_PORT_COUNT; p++)
+			sense[p] = v.input[1u + p];
+		if (!ModbusTable_SnapshotValid(&v)) continue;
+		for (unsigned p = 0; p < SLAVE_LPSB_PORT_COUNT; p++) {
+			out->lpsb_coils[n][p]     = (uint8_t)((coils >> p) & 1u);
+			out->lpsb_sense_raw[n][p] = sense[p];
+		}
+		out->lpsb_alarm_reg[n] = alarm;
+		return 0;
+	}
+	return -1;
+}
+
+/* Every try torn: count it and mark the slave again, so the next pass retries */
+static void snapshot_torn(aggregated_status_t *out, SlaveId_t s)
+{
+	out->torn_snapshots++;
+	DirtyFlags_MarkSlave(s);
+}
 
-	/* HPSB overcurrent: use ADC from HPSB Modbus InputReg 1,2,3. If > threshold for 3 consecutive cycles, set ALM5/6/7. */
-	static uint8_t hpsb_oc_count[3];
-	for (int i = 0; i < 3; i++) {
+/* Time-driven part: ages grow without any change on the bus */
+static void update_ages(aggregated_status_t *out)
+{
+	/* Currents of a fitted board (HPSB always, LPSB once enumerated) going stale are flagged */
+	out->stale_mask = 0;
+	for (unsigned b = 0; b < AGG_AGE_SLAVE_COUNT; b++) {
+		SlaveId_t s = (b == 0) ? SLAVE_ID_HPSB : SLAVE_ID_LPSB(b - 1u);
+		for (unsigned a = 0; a < SLAVE_AREA_COUNT; a++)
+			out->data_age_ms[b][a] = age_reg(s, (SlaveArea_t)a);
+		if ((b == 0 || BusEnum_IsPresent(s)) && out->data_age_ms[b][SLAVE_AREA_INPUT] > AGG_SENSE_MAX_AGE_MS)
+			out->stale_mask |= (uint8_t)(1u << b);
+	}
+
+	/* HPSB overcurrent: use ADC from HPSB Modbus InputReg 1,2,3. If > threshold for 3 consecutive ticks, set ALM5/6/7.
+	 * Stale currents restart the count. */
+	out->hpsb_alarm_reg = 0;
+	for (unsigned i = 0; i < 3u; i++) {
 		uint16_t raw = out->hpsb_sense_raw[i];
-		if (raw > HPSB_OC_THRESHOLD_RAW) {
+		if (!(out->stale_mask & 1u) && raw > HPSB_OC_THRESHOLD_RAW) {
 			if (hpsb_oc_count[i] < 255u) hpsb_oc_count[i]++;
 		} else {
 			hpsb_oc_count[i] = 0;
 		}
+		if (hpsb_oc_count[i] >= HPSB_OC_CYCLES_REQUIRED) out->hpsb_alarm_reg |= (uint16_t)(1u << i);
 	}
-	out->hpsb_alarm_reg = 0;
-	if (hpsb_oc_count[0] >= HPSB_OC_CYCLES_REQUIRED) out->hpsb_alarm_reg |= (1u << 0);
-	if (hpsb_oc_count[1] >= HPSB_OC_CYCLES_REQUIRED) out->hpsb_alarm_reg |= (1u << 1);
-	if (hpsb_oc_count[2] >= HPSB_OC_CYCLES_REQUIRED) out->hpsb_alarm_reg |= (1u << 2);
-
-	/* Fill H2TECH aggregated bit image for upstream FC02
-	 * 0821~0822 MAIN DO; 0823~0825 HPSB coils 0~2; 0826~0828 LPSB1, 0829~0831 LPSB2, 0832~0834 LPSB3; 0835~0836 reserved. */
-	H2Map_WriteAggBit(AGG_BIT_ONOFF_1, (out->main_do & (1u << 0)) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ONOFF_2, (out->main_do & (1u << 1)) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ONOFF_3, (out->hpsb_coils & (1u << 0)) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ONOFF_4, (out->hpsb_coils & (1u << 1)) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ONOFF_5, (out->hpsb_coils & (1u << 2)) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ONOFF_6, out->lpsb1_coils[0] ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ONOFF_7, out->lpsb1_coils[1] ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ONOFF_8, out->lpsb1_coils[2] ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ONOFF_9, out->lpsb2_coils[0] ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ONOFF_10, out->lpsb2_coils[1] ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ONOFF_11, out->lpsb2_coils[2] ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ONOFF_12, out->lpsb3_coils[0] ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ONOFF_13, out->lpsb3_coils[1] ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ONOFF_14, out->lpsb3_coils[2] ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ONOFF_15, false);
-	H2Map_WriteAggBit(AGG_BIT_ONOFF_16, false);
+}
 
-	/* Door sensors: MAIN DI 0,1 = magnetic 1,2; 2,3 = button 1,2 */
-	H2Map_WriteAggBit(AGG_BIT_DOOR_MAG_1, (out->main_di & (1u << 0)) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_DOOR_MAG_2, (out->main_di & (1u << 1)) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_DOOR_BTN_1, (out->main_di & (1u << 2)) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_DOOR_BTN_2, (out->main_di & (1u << 3)) ? true : false);
-
-	/* Alarms: 1=HPSB comm, 2=any LPSB comm, 3=SHTC3, 4=door fault, 5-7=HPSB OC, 8-10=LPSB1/2/3 OC, 11=PC link, 12=reserved */
-	H2Map_WriteAggBit(AGG_BIT_ALM_1, (out->error_flags & AGG_ERR_COMM_HPSB) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ALM_2, (out->error_flags & AGG_ERR_COMM_LPSB) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ALM_3, (out->error_flags & AGG_ERR_SHTC3) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ALM_4, false);
-	H2Map_WriteAggBit(AGG_BIT_ALM_5, (out->hpsb_alarm_reg & (1u << 0)) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ALM_6, (out->hpsb_alarm_reg & (1u << 1)) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ALM_7, (out->hpsb_alarm_reg & (1u << 2)) ? true : false);
-	/* LPSB overcurrent: any of 3 ports over threshold (mid-scale ± margin) sets ALM8/9/10 */
-	H2Map_WriteAggBit(AGG_BIT_ALM_8, lpsb_oc(out->lpsb1_sense_raw) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ALM_9, lpsb_oc(out->lpsb2_sense_raw) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ALM_10, lpsb_oc(out->lpsb3_sense_raw) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ALM_11, (out->error_flags & AGG_ERR_UPSTREAM_RX) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_ALM_12, (out->error_flags & AGG_ERR_DOWNSTREAM_WRITE) ? true : false);
-
-	/* CMD ON/OFF 1~7: mirror of output state for consistency (optional) */
-	H2Map_WriteAggBit(AGG_BIT_CMD_ONOFF_1, (out->main_do & (1u << 0)) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_CMD_ONOFF_2, (out->main_do & (1u << 1)) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_CMD_ONOFF_3, (out->hpsb_coils & (1u << 0)) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_CMD_ONOFF_4, (out->hpsb_coils & (1u << 1)) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_CMD_ONOFF_5, (out->hpsb_coils & (1u << 2)) ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_CMD_ONOFF_6, out->lpsb1_coils[0] ? true : false);
-	H2Map_WriteAggBit(AGG_BIT_CMD_ONOFF_7, out->lpsb1_coils[1] ? true : false);
+static void update_errors(aggregated_status_t *out)
+{
+	out->error_flags = 0;
+	if (out->stale_mask) out->error_flags |= AGG_ERR_STALE_DATA;
+	if (!ModbusMaster_IsCommOk(SLAVE_ID_HPSB)) out->error_flags |= AGG_ERR_COMM_HPSB;
+	/* HPSB is always fitted; other boards only count once the bus enumeration has found them */
+	for (uint32_t a = SLAVE_ID_HPSB + 1u; a <= SLAVE_ID_LAST; a++) {
+		if (BusEnum_IsPresent((SlaveId_t)a) && !ModbusMaster_IsCommOk((SlaveId_t)a))
+			out->error_flags |= AGG_ERR_COMM_LPSB;
+	}
+	if (Gateway_Action_PollDownstreamWriteFail()) out->error_flags |= AGG_ERR_DOWNSTREAM_WRITE;
+	if (BusEnum_GetCollisionMask()) out->error_flags |= AGG_ERR_ADDR_COLLISION;
+}
+
+void Aggregator_Init(void)
+{
+	for (unsigned i = 0; i < 3u; i++)
+		hpsb_oc_count[i] = 0;
+	for (unsigned i = 0; i < AGG_RULE_COUNT; i++)
+		rule_deps[i] = src_deps(&agg_rules[i]);
+	full_pass = 1;
+	DirtyFlags_MarkAll();
+}
+
+uint8_t Aggregator_GetRuleCount(void)
+{
+	return (uint8_t)AGG_RULE_COUNT;
+}
+
+void Aggregator_Update(aggregated_status_t *out)
+{
+	uint32_t slaves;
+	uint32_t marks;
+	uint32_t deps = 0;
+
+	if (!out || !DirtyFlags_Any()) return;
+	marks = DirtyFlags_Take(&slaves);
+	out->timestamp_ms = HAL_GetTick();
+
+	if (marks & DIRTY_MAIN_DI) {
+		update_main_di(out);
+		deps |= DEP_MAIN_DI;
+	}
+	if (marks & DIRTY_MAIN_DO) {
+		update_main_do(out);
+		deps |= DEP_MAIN_DO;
+	}
+	if (slaves & DIRTY_SLAVE_BIT(SLAVE_ID_HPSB)) {
+		if (update_hpsb(out) == 0) deps |= DEP_HPSB;
+		else snapshot_torn(out, SLAVE_ID_HPSB);
+	}
+	for (unsigned n = 0; n < SLAVE_LPSB_MAPPED_COUNT; n++) {
+		if (slaves & DIRTY_SLAVE_BIT(SLAVE_ID_LPSB(n))) {
+			if (update_lpsb(out, n) == 0) deps |= DEP_LPSB(n);
+			else snapshot_torn(out, SLAVE_ID_LPSB(n));
+		}
+	}
+	if (marks & DIRTY_AGE_TICK) {
+		update_ages(out);
+		deps |= DEP_AGE_TICK;
+	}
+	if (marks & (DIRTY_AGE_TICK | DIRTY_COMM | DIRTY_GATEWAY)) {
+		update_errors(out);
+		deps |= DEP_ERRORS;
+	}
+
+	if (full_pass) {
+		deps = DEP_ALL;
+		full_pass = 0;
+	}
+	eval_rules(out, deps);
 }
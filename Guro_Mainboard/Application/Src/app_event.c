@@ -0,0 +1,100 @@
+/**
+ * @file app_event.c
+ * @brief SPSC rings: the producer only writes head, the consumer only writes tail, and both are
+ *        free-running uint8_t, so head - tail is the depth. A barrier orders the slot write before
+ *        the head store (and the slot read before the tail store); no interrupt masking is needed.
+ */
+#include "app_event.h"
+#include "app_scheduler.h"
+#include "main.h"
+#include <string.h>
+
+#define QUEUE_MASK      (APP_EVENT_QUEUE_LEN - 1u)
+
+_Static_assert((APP_EVENT_QUEUE_LEN & QUEUE_MASK) == 0u && APP_EVENT_QUEUE_LEN <= 128u,
+               "APP_EVENT_QUEUE_LEN must be a power of 2 that fits the uint8_t indices");
+
+typedef struct {
+	app_event_t buf[APP_EVENT_QUEUE_LEN];
+	volatile uint8_t head;      /* ISR writes */
+	volatile uint8_t tail;      /* main loop writes */
+	app_event_stats_t stats;    /* ISR writes */
+} event_queue_t;
+
+static event_queue_t queues[APP_EV_SRC_COUNT];
+static app_event_handler_t handlers[APP_EV_COUNT];
+
+void AppEvent_Init(void)
+{
+	memset(queues, 0, sizeof(queues));
+	memset(handlers, 0, sizeof(handlers));
+}
+
+void AppEvent_SetHandler(app_event_type_t type, app_event_handler_t handler)
+{
+	if (type < APP_EV_COUNT) handlers[type] = handler;
+}
+
+int AppEvent_Post(app_event_src_t src, app_event_type_t type, uint16_t arg)
+{
+	if (src >= APP_EV_SRC_COUNT) return -1;
+	event_queue_t *q = &queues[src];
+	uint8_t head = q->head;
+	uint8_t depth = (uint8_t)(head - q->tail);
+	if (depth >= APP_EVENT_QUEUE_LEN) {
+		q->stats.dropped++;
+		return -1;
+	}
+	q->buf[head & QUEUE_MASK].type = (uint8_t)type;
+	q->buf[head & QUEUE_MASK].arg = arg;
+	__DMB();
+	q->head = (uint8_t)(head + 1u);
+	q->stats.posted++;
+	if (depth + 1u > q->stats.max_depth) q->stats.max_depth = (uint8_t)(depth + 1u);
+	return 0;
+}
+
+uint16_t AppEvent_Dispatch(void)
+{
+	uint16_t n = 0;
+	for (int s = 0; s < APP_EV_SRC_COUNT; s++) {
+		event_queue_t *q = &queues[s];
+		uint8_t tail = q->tail;
+		while (tail != q->head) {
+			__DMB();
+			app_event_t ev = q->buf[tail & QUEUE_MASK];
+			__DMB();
+			tail = (uint8_t)(tail + 1u);
+			q->tail = tail;
+			if (ev.type < APP_EV_COUNT && handlers[ev.type]) handlers[ev.type](&ev);
+			n++;
+		}
+	}
+	return n;
+}
+
+uint8_t AppEvent_Pending(void)
+{
+	for (int s = 0; s < APP_EV_SRC_COUNT; s++) {
+		if (queues[s].head != queues[s].tail) return 1;
+	}
+	return 0;
+}
+
+void AppEvent_Idle(void)
+{
+#if APP_EVENT_IDLE_WFI
+	/* With PRIMASK set an interrupt still ends WFI but runs only after __enable_irq, so one that
+	 * comes between the check and WFI cannot be slept through */
+	__disable_irq();
+	if (!AppEvent_Pending() && AppScheduler_MsToNextDeadline() != 0)
+		__WFI();
+	__enable_irq();
+#endif
+}
+
+void AppEvent_GetStats(app_event_src_t src, app_event_stats_t *out)
+{
+	if (src >= APP_EV_SRC_COUNT || out == NULL) return;
+	*out = queues[src].stats;
+}
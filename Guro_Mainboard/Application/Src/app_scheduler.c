@@ -1,41 +1,89 @@
 /**
  * @file app_scheduler.c
  * @brief 1ms-base task flags. Call AppScheduler_Update() from main loop (uses HAL_GetTick()).
+ *        Periodic tasks sit in order[] by deadline, earliest first, so Update only looks at the
+ *        tasks that are due. Deadlines advance on the period grid (due += period), not from when
+ *        Update ran, so a late pass does not shift later releases.
  */
 #include "app_scheduler.h"
 #include "main.h"
 
-static uint32_t tick_count;
-static uint32_t next_run[TASK_COUNT];
-static uint8_t  task_due[TASK_COUNT];
+static uint32_t due[TASK_COUNT];
+static uint32_t period[TASK_COUNT];
+static volatile uint8_t task_due[TASK_COUNT];
+static uint8_t periodic_due[TASK_COUNT];  /* the pending release includes a periodic one */
+static uint8_t order[TASK_COUNT];      /* periodic tasks by deadline */
+static uint8_t order_count;
+static app_task_stats_t stats[TASK_COUNT];
 
 static const uint32_t period_ms[TASK_COUNT] = {
-	10,   /* UPSTREAM_POLL */
-	10,   /* DOWNSTREAM_MODBUS */
-	100,  /* AGGREGATE_UPDATE */
-	500   /* UPSTREAM_SEND_STATUS */
+	10,   /* UPSTREAM_POLL; also released by USART2 receive events */
+	1,    /* DOWNSTREAM_MODBUS: next request goes out as soon as a response is in */
+	100,  /* AGGREGATE_UPDATE: age tick (DIRTY_AGE_TICK) */
+	500,  /* UPSTREAM_SEND_STATUS; event-only in the RTU build, which has no status report */
+	5,    /* MAIN_IO_SCAN: DI edge -> aggregator within 5 ms */
+	10,   /* LED_STATUS: pulses of 30 ms and more */
+	1,    /* GATEWAY_ACTIONS: timed_io wheel runs in 1 ms slots */
+	20    /* AGGREGATOR: liveness only; changes release it on the pass they are marked */
 };
 
+/* Deadlines are all within 2^31 ms of each other, so the signed difference orders them */
+static void order_insert(uint8_t id)
+{
+	uint8_t i = order_count;
+	while (i > 0 && (int32_t)(due[id] - due[order[i - 1]]) < 0) {
+		order[i] = order[i - 1];
+		i--;
+	}
+	order[i] = id;
+	order_count++;
+}
+
+static void order_remove(uint8_t id)
+{
+	uint8_t i = 0;
+	while (i < order_count && order[i] != id) i++;
+	if (i == order_count) return;
+	for (; i + 1u < order_count; i++)
+		order[i] = order[i + 1u];
+	order_count--;
+}
+
 void AppScheduler_Init(void)
 {
-	tick_count = HAL_GetTick();
+	uint32_t now = HAL_GetTick();
+	order_count = 0;
 	for (int i = 0; i < TASK_COUNT; i++) {
-		next_run[i] = tick_count;
 		task_due[i] = 0;
+		periodic_due[i] = 0;
+		period[i] = period_ms[i];
+		due[i] = now;
+		stats[i] = (app_task_stats_t){ 0 };
+		if (period[i]) order_insert((uint8_t)i);
 	}
 }
 
 void AppScheduler_Update(void)
 {
 	uint32_t now = HAL_GetTick();
-	if (now < tick_count) return;
-	tick_count = now;
 
-	for (int i = 0; i < TASK_COUNT; i++) {
-		if (now >= next_run[i]) {
-			task_due[i] = 1;
-			next_run[i] = now + period_ms[i];
-		}
+	while (order_count) {
+		uint8_t id = order[0];
+		int32_t late = (int32_t)(now - due[id]);
+		if (late < 0) break;
+
+		if (periodic_due[id]) stats[id].missed++;
+		periodic_due[id] = 1;
+		task_due[id] = 1;
+		if ((uint32_t)late > stats[id].max_late_ms)
+			stats[id].max_late_ms = (late > 0xFFFF) ? 0xFFFFu : (uint16_t)late;
+
+		/* Next deadline on the grid; periods that passed entirely were missed */
+		uint32_t skipped = (uint32_t)late / period[id];
+		stats[id].missed += skipped;
+		due[id] += (skipped + 1u) * period[id];
+		order_remove(id);
+		order_insert(id);
 	}
 }
 
@@ -44,5 +92,41 @@ uint8_t AppScheduler_IsDue(app_task_id_t id)
 	if (id >= TASK_COUNT) return 0;
 	if (!task_due[id]) return 0;
 	task_due[id] = 0;
+	periodic_due[id] = 0;
+	stats[id].runs++;
 	return 1;
 }
+
+void AppScheduler_Trigger(app_task_id_t id)
+{
+	if (id >= TASK_COUNT) return;
+	task_due[id] = 1;
+	stats[id].triggered++;
+}
+
+void AppScheduler_SetPeriod(app_task_id_t id, uint32_t ms)
+{
+	if (id >= TASK_COUNT) return;
+	order_remove((uint8_t)id);
+	period[id] = ms;
+	if (ms) {
+		due[id] = HAL_GetTick() + ms;
+		order_insert((uint8_t)id);
+	}
+}
+
+uint32_t AppScheduler_MsToNextDeadline(void)
+{
+	for (int i = 0; i < TASK_COUNT; i++) {
+		if (task_due[i]) return 0;
+	}
+	if (!order_count) return APP_SCHEDULER_NO_DEADLINE;
+	int32_t left = (int32_t)(due[order[0]] - HAL_GetTick());
+	return (left > 0) ? (uint32_t)left : 0;
+}
+
+void AppScheduler_GetStats(app_task_id_t id, app_task_stats_t *out)
+{
+	if (id >= TASK_COUNT || out == NULL) return;
+	*out = stats[id];
+}
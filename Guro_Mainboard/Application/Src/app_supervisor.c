@@ -0,0 +1,142 @@
+/**
+ * @file app_supervisor.c
+ * @brief Check-in deadlines, windowed WWDG refresh and the reset-surviving record.
+ *        The record sits in .noinit (see the linker scripts), so startup neither loads nor clears
+ *        it; a magic pair tells a kept record from power-on garbage or another build's layout.
+ *        The WWDG early-wakeup interrupt comes one count (1.56 ms) before the reset and closes
+ *        the record: a starved task was already noted by Update, otherwise the loop had stalled.
+ */
+#include "app_supervisor.h"
+#include "main.h"
+#include <string.h>
+
+#define SUP_MAGIC       0x53555056u     /* "SUPV" */
+
+extern WWDG_HandleTypeDef hwwdg;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t size;
+	uint32_t wwdg_resets;
+	app_sup_record_t rec;       /* live: written every pass */
+	uint32_t magic_inv;
+} sup_keep_t;
+
+static sup_keep_t keep __attribute__((section(".noinit")));
+
+/* Longest a task may go without checking in: a few periods, and below the 98 ms WWDG timeout so
+ * a starved task is caught by the supervisor rather than by a stalled loop */
+static const uint16_t deadline_ms[APP_SUP_TASK_COUNT] = {
+	20,   /* DOWNSTREAM: 1 ms task, a master transaction blocks for at most a frame */
+	50,   /* UPSTREAM: 10 ms task */
+	50,   /* AGGREGATOR: 20 ms task, or sooner on a dirty mark */
+	20    /* GATEWAY_ACTIONS: 1 ms task */
+};
+
+static uint32_t last_seen[APP_SUP_TASK_COUNT];
+static uint32_t last_pass;
+static uint32_t starve_events;
+static uint8_t  reset_flags;
+static app_sup_record_t prev;
+
+static void gap_add(app_sup_record_t *r, uint32_t gap)
+{
+	uint8_t b = 0;
+	while (b < APP_SUP_GAP_BUCKETS - 1u && gap >= (1u << b)) b++;
+	if (r->gap_hist[b] != 0xFFFFu) r->gap_hist[b]++;
+	if (gap > 0xFFFFu) gap = 0xFFFFu;
+	if (gap > r->max_gap_ms) r->max_gap_ms = (uint16_t)gap;
+}
+
+static uint8_t read_reset_flags(void)
+{
+	uint32_t csr = RCC->CSR;
+	uint8_t f = 0;
+	if (csr & RCC_CSR_WWDGRSTF) f |= APP_SUP_RESET_WWDG;
+	if (csr & RCC_CSR_IWDGRSTF) f |= APP_SUP_RESET_IWDG;
+	if (csr & RCC_CSR_SFTRSTF) f |= APP_SUP_RESET_SW;
+	if (csr & (RCC_CSR_PORRSTF | RCC_CSR_BORRSTF)) f |= APP_SUP_RESET_POWER;
+	if (csr & RCC_CSR_PINRSTF) f |= APP_SUP_RESET_PIN;
+	__HAL_RCC_CLEAR_RESET_FLAGS();
+	return f;
+}
+
+void AppSupervisor_Init(void)
+{
+	uint32_t now = HAL_GetTick();
+	reset_flags = read_reset_flags();
+	if ((reset_flags & APP_SUP_RESET_POWER) || keep.magic != SUP_MAGIC || keep.magic_inv != ~SUP_MAGIC ||
+	    keep.size != sizeof(keep)) {
+		memset(&keep, 0, sizeof(keep));
+		keep.magic = SUP_MAGIC;
+		keep.magic_inv = ~SUP_MAGIC;
+		keep.size = sizeof(keep);
+		memset(&prev, 0, sizeof(prev));
+	} else {
+		prev = keep.rec;
+	}
+	if (reset_flags & APP_SUP_RESET_WWDG) keep.wwdg_resets++;
+	memset(&keep.rec, 0, sizeof(keep.rec));
+	keep.rec.last_checkin = 0xFFu;
+	for (int i = 0; i < APP_SUP_TASK_COUNT; i++)
+		last_seen[i] = now;
+	last_pass = now;
+	starve_events = 0;
+}
+
+void AppSupervisor_CheckIn(app_sup_task_t id)
+{
+	if (id >= APP_SUP_TASK_COUNT) return;
+	last_seen[id] = HAL_GetTick();
+	keep.rec.last_checkin = (uint8_t)id;
+}
+
+void AppSupervisor_Update(void)
+{
+	uint32_t now = HAL_GetTick();
+	gap_add(&keep.rec, now - last_pass);
+	last_pass = now;
+	keep.rec.uptime_ms = now;
+
+	uint8_t starved = 0;
+	for (int i = 0; i < APP_SUP_TASK_COUNT; i++) {
+		if (now - last_seen[i] > deadline_ms[i]) starved |= (uint8_t)(1u << i);
+	}
+	if (starved) {
+		/* No refresh: the WWDG resets unless the task catches up in time */
+		starve_events++;
+		keep.rec.cause = APP_SUP_CAUSE_STARVED;
+		keep.rec.starved_mask = starved;
+		return;
+	}
+	keep.rec.cause = APP_SUP_CAUSE_NONE;
+	keep.rec.starved_mask = 0;
+	/* Refreshing above the window is itself a reset */
+	if ((hwwdg.Instance->CR & WWDG_CR_T) < hwwdg.Init.Window)
+		HAL_WWDG_Refresh(&hwwdg);
+}
+
+/* WWDG IRQ: the counter reached 0x40, reset follows */
+void HAL_WWDG_EarlyWakeupCallback(WWDG_HandleTypeDef *hwwdg)
+{
+	(void)hwwdg;
+	uint32_t now = HAL_GetTick();
+	if (keep.rec.cause == APP_SUP_CAUSE_NONE) {
+		keep.rec.cause = APP_SUP_CAUSE_STALL;
+		for (int i = 0; i < APP_SUP_TASK_COUNT; i++) {
+			if (now - last_seen[i] > deadline_ms[i]) keep.rec.starved_mask |= (uint8_t)(1u << i);
+		}
+	}
+	gap_add(&keep.rec, now - last_pass);     /* the pass that never finished */
+	keep.rec.uptime_ms = now;
+}
+
+void AppSupervisor_GetReport(app_sup_report_t *out)
+{
+	if (out == NULL) return;
+	out->reset_flags = reset_flags;
+	out->wwdg_resets = keep.wwdg_resets;
+	out->starve_events = starve_events;
+	out->prev = prev;
+	out->now = keep.rec;
+}
@@ -61,7 +61,7 @@ void LED_Status_Init(void)
 void LED_Status_Tick_1ms(void)
 {
 	uint32_t now = HAL_GetTick();
-	uint32_t elapsed = (now >= last_tick) ? (now - last_tick) : 0;
+	uint32_t elapsed = now - last_tick;
 	if (elapsed == 0) return;
 	last_tick = now;
 
@@ -0,0 +1,120 @@
+/**
+ * @file profiler.c
+ * @brief Probe figures on DWT->CYCCNT (84 MHz: wraps after 51 s, far beyond any one probe).
+ *        The utilisation window is timed with HAL_GetTick(), so it stays right if the counter
+ *        stops while the core sleeps; busy time is the sum of the top-level probes in it.
+ */
+#include "profiler.h"
+
+#if PROFILER_ENABLED
+
+#include <string.h>
+
+typedef struct {
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+	uint16_t hist[PROFILER_HIST_BUCKETS];
+} Probe_t;
+
+static Probe_t probes[PROF_COUNT];
+static uint32_t loop_start;         /* CYCCNT at the top of the pass */
+static uint8_t  loop_started;
+static uint32_t window_start_ms;
+static uint64_t window_busy;
+static uint16_t utilisation;
+
+static uint8_t hist_bucket(uint32_t cycles)
+{
+	if (cycles < 256u) return 0;
+	uint32_t b = ((31u - __CLZ(cycles)) - 8u) / 2u + 1u;
+	return (uint8_t)((b < PROFILER_HIST_BUCKETS) ? b : PROFILER_HIST_BUCKETS - 1u);
+}
+
+void Profiler_Clear(void)
+{
+	memset(probes, 0, sizeof(probes));
+	for (int i = 0; i < PROF_COUNT; i++)
+		probes[i].min = 0xFFFFFFFFu;
+	loop_started = 0;
+	window_start_ms = HAL_GetTick();
+	window_busy = 0;
+	utilisation = 0;
+}
+
+void Profiler_Init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	Profiler_Clear();
+}
+
+void Profiler_Record(Profiler_ProbeId_t id, uint32_t cycles)
+{
+	Probe_t *p = &probes[id];
+	p->count++;
+	p->sum += cycles;
+	if (cycles < p->min) p->min = cycles;
+	if (cycles > p->max) p->max = cycles;
+	uint16_t *h = &p->hist[hist_bucket(cycles)];
+	if (*h != 0xFFFFu) (*h)++;
+	if (!((PROFILER_NOT_BUSY_MASK >> id) & 1u)) window_busy += cycles;
+}
+
+void Profiler_Loop(void)
+{
+	uint32_t now = DWT->CYCCNT;
+	if (loop_started) Profiler_Record(PROF_LOOP, now - loop_start);
+	loop_start = now;
+	loop_started = 1;
+
+	uint32_t elapsed_ms = HAL_GetTick() - window_start_ms;
+	if (elapsed_ms < PROFILER_WINDOW_MS) return;
+	uint64_t window = (uint64_t)elapsed_ms * (SystemCoreClock / 1000u);
+	uint64_t permille = window_busy * 1000u / window;
+	utilisation = (uint16_t)((permille > 1000u) ? 1000u : permille);
+	window_start_ms += elapsed_ms;
+	window_busy = 0;
+}
+
+uint8_t Profiler_ProbeCount(void)
+{
+	return PROF_COUNT;
+}
+
+int Profiler_GetProbe(Profiler_ProbeId_t id, Profiler_Probe_t *out)
+{
+	if ((unsigned)id >= PROF_COUNT || out == NULL) return -1;
+	const Probe_t *p = &probes[id];
+	out->count = p->count;
+	out->min_cycles = p->count ? p->min : 0;
+	out->max_cycles = p->max;
+	out->mean_cycles = p->count ? (uint32_t)(p->sum / p->count) : 0;
+	memcpy(out->hist, p->hist, sizeof(out->hist));
+	return 0;
+}
+
+uint16_t Profiler_GetUtilisation(void)
+{
+	return utilisation;
+}
+
+uint16_t Profiler_CpuMHz(void)
+{
+	return (uint16_t)(SystemCoreClock / 1000000u);
+}
+
+#else /* !PROFILER_ENABLED */
+
+void Profiler_Init(void) {}
+void Profiler_Record(Profiler_ProbeId_t id, uint32_t cycles) { (void)id; (void)cycles; }
+void Profiler_Loop(void) {}
+void Profiler_Clear(void) {}
+uint8_t Profiler_ProbeCount(void) { return 0; }
+int Profiler_GetProbe(Profiler_ProbeId_t id, Profiler_Probe_t *out) { (void)id; (void)out; return -1; }
+uint16_t Profiler_GetUtilisation(void) { return 0; }
+uint16_t Profiler_CpuMHz(void) { return 0; }
+
+#endif /* PROFILER_ENABLED */
@@ -0,0 +1,97 @@
+/**
+ * @file uart_dispatch.c
+ * @brief Overrides the weak HAL UART callbacks and routes them by handle:
+ *        USART1 = downstream Modbus master, USART2 = upstream PC link (Modbus RTU slave or the
+ *        legacy frame protocol, per UPSTREAM_LINK_RTU).
+ *        The callbacks run in interrupt context and only post events (app_event.h); the handlers
+ *        below run from AppEvent_Dispatch() in the main loop and release the task that owns the port.
+ *        The legacy link's per-byte reception stays in its own byte ring.
+ */
+#include "uart_dispatch.h"
+#include "app_event.h"
+#include "main.h"
+#include "modbus_master.h"
+#include "upstream_pc_protocol.h"
+#include "upstream_rtu.h"
+#include "app_scheduler.h"
+
+extern UART_HandleTypeDef huart1;
+extern UART_HandleTypeDef huart2;
+
+static void on_downstream_rx(const app_event_t *ev)
+{
+	ModbusMaster_UART_RxEventCallback(ev->arg);
+	AppScheduler_Trigger(TASK_DOWNSTREAM_MODBUS);
+}
+
+static void on_upstream_rx(const app_event_t *ev)
+{
+#if UPSTREAM_LINK_RTU
+	UpstreamRTU_UART_RxEventCallback(ev->arg);
+#else
+	(void)ev;
+#endif
+	AppScheduler_Trigger(TASK_UPSTREAM_POLL);
+}
+
+static void on_upstream_tx_done(const app_event_t *ev)
+{
+	(void)ev;
+#if UPSTREAM_LINK_RTU
+	UpstreamRTU_TxCpltCallback();
+#else
+	UpstreamPC_TxCpltCallback();
+#endif
+}
+
+static void on_upstream_error(const app_event_t *ev)
+{
+	(void)ev;
+#if UPSTREAM_LINK_RTU
+	UpstreamRTU_ErrorCallback();
+#else
+	UpstreamPC_ErrorCallback();
+#endif
+	AppScheduler_Trigger(TASK_UPSTREAM_POLL);
+}
+
+void UartDispatch_Init(void)
+{
+	AppEvent_SetHandler(APP_EV_DOWNSTREAM_RX, on_downstream_rx);
+	AppEvent_SetHandler(APP_EV_UPSTREAM_RX, on_upstream_rx);
+	AppEvent_SetHandler(APP_EV_UPSTREAM_TX_DONE, on_upstream_tx_done);
+	AppEvent_SetHandler(APP_EV_UPSTREAM_ERROR, on_upstream_error);
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+	/* Half-transfer events come in the middle of a long DMA frame; the type is only valid here */
+	if (HAL_UARTEx_GetRxEventType(huart) == HAL_UART_RXEVENT_HT) return;
+	if (huart == &huart1)
+		(void)AppEvent_Post(APP_EV_SRC_DOWNSTREAM, APP_EV_DOWNSTREAM_RX, Size);
+	else if (huart == &huart2)
+		(void)AppEvent_Post(APP_EV_SRC_UPSTREAM, APP_EV_UPSTREAM_RX, Size);
+}
+
+#if !UPSTREAM_LINK_RTU
+/* Legacy PC link receives byte by byte: into its ring here, so the next byte is armed at once */
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+	if (huart == &huart2) {
+		UpstreamPC_UART_RxCpltCallback();
+		AppScheduler_Trigger(TASK_UPSTREAM_POLL);
+	}
+}
+#endif
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+	if (huart == &huart2)
+		(void)AppEvent_Post(APP_EV_SRC_UPSTREAM, APP_EV_UPSTREAM_TX_DONE, 0);
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+	if (huart == &huart2)
+		(void)AppEvent_Post(APP_EV_SRC_UPSTREAM, APP_EV_UPSTREAM_ERROR, 0);
+}
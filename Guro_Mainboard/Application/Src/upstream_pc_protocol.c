@@ -1,121 +1,336 @@
 /**
  * @file upstream_pc_protocol.c
- * @brief USART2 upstream: ReceiveToIdle_IT, frame parser, non-blocking TX. Overrides HAL UART callbacks for huart2.
+ * @brief USART2 upstream: per-byte RX into a ring, incremental COBS/CRC16 frame parser, non-blocking TX.
+ *        HAL UART callbacks are routed here by uart_dispatch.c.
+ *        The RX ISR only queues bytes; UpstreamPC_Poll() feeds each one to the decoder exactly once, so a
+ *        frame split over several polls, or several frames in one burst, need no idle line to separate them.
+ *        Status goes out as TLV frames cut from a serialized status image: keyframes carry every
+ *        field, delta frames the fields that differ from the image the PC last acknowledged or from
+ *        any frame sent since (so a value that changed and changed back is still resent).
  */
 #include "upstream_pc_protocol.h"
 #include "main.h"
 #include "led_status.h"
+#include "modbus_rtu.h"
 #include <string.h>
 
 extern UART_HandleTypeDef huart2;
 
+/* Status image, little-endian; each TLV field is a slice of it */
+#define IMG_TIMESTAMP       0u      /* 4 */
+#define IMG_ENV_TEMP        4u      /* 2 */
+#define IMG_ENV_RH          6u      /* 2 */
+#define IMG_MAIN_DI         8u
+#define IMG_MAIN_DO         9u
+#define IMG_ERROR_FLAGS     10u     /* 2 */
+#define IMG_STALE_MASK      12u
+#define IMG_HPSB_COILS      13u
+#define IMG_HPSB_DISCRETE   14u
+#define IMG_HPSB_STATUS     15u     /* 2 */
+#define IMG_HPSB_ALARM      17u     /* 2 */
+#define IMG_HPSB_SENSE      19u     /* 3 x 2 */
+#define IMG_LPSB(n)         (25u + (n) * 3u)    /* coils bitmap, alarm reg (2) */
+#define IMG_LPSB_SENSE(n)   (34u + (n) * 6u)    /* 3 x 2 */
+#define IMG_SIZE            52u
+
+_Static_assert(SLAVE_LPSB_MAPPED_COUNT == 3u && SLAVE_LPSB_PORT_COUNT == 3u, "status image assumes 3 LPSB x 3 ports");
+_Static_assert(IMG_LPSB(SLAVE_LPSB_MAPPED_COUNT) == IMG_LPSB_SENSE(0) &&
+               IMG_LPSB_SENSE(SLAVE_LPSB_MAPPED_COUNT) == IMG_SIZE, "status image layout");
+
+typedef struct {
+	uint8_t tag;
+	uint8_t ofs;
+	uint8_t len;
+	uint8_t trigger;        /* a change sends a frame right away in event mode */
+} status_field_t;
+
+static const status_field_t status_fields[] = {
+	{ UPSTREAM_TAG_TIMESTAMP,     IMG_TIMESTAMP,      4, 0 },
+	{ UPSTREAM_TAG_ENV_TEMP,      IMG_ENV_TEMP,       2, 0 },
+	{ UPSTREAM_TAG_ENV_RH,        IMG_ENV_RH,         2, 0 },
+	{ UPSTREAM_TAG_MAIN_DI,       IMG_MAIN_DI,        1, 1 },
+	{ UPSTREAM_TAG_MAIN_DO,       IMG_MAIN_DO,        1, 1 },
+	{ UPSTREAM_TAG_ERROR_FLAGS,   IMG_ERROR_FLAGS,    2, 1 },
+	{ UPSTREAM_TAG_STALE_MASK,    IMG_STALE_MASK,     1, 1 },
+	{ UPSTREAM_TAG_HPSB_COILS,    IMG_HPSB_COILS,     1, 1 },
+	{ UPSTREAM_TAG_HPSB_DISCRETE, IMG_HPSB_DISCRETE,  1, 1 },
+	{ UPSTREAM_TAG_HPSB_STATUS,   IMG_HPSB_STATUS,    2, 1 },
+	{ UPSTREAM_TAG_HPSB_ALARM,    IMG_HPSB_ALARM,     2, 1 },
+	{ UPSTREAM_TAG_HPSB_SENSE,    IMG_HPSB_SENSE,     6, 0 },
+	{ UPSTREAM_TAG_LPSB(0),       IMG_LPSB(0),        3, 1 },
+	{ UPSTREAM_TAG_LPSB(1),       IMG_LPSB(1),        3, 1 },
+	{ UPSTREAM_TAG_LPSB(2),       IMG_LPSB(2),        3, 1 },
+	{ UPSTREAM_TAG_LPSB_SENSE(0), IMG_LPSB_SENSE(0),  6, 0 },
+	{ UPSTREAM_TAG_LPSB_SENSE(1), IMG_LPSB_SENSE(1),  6, 0 },
+	{ UPSTREAM_TAG_LPSB_SENSE(2), IMG_LPSB_SENSE(2),  6, 0 },
+};
+#define STATUS_FIELD_COUNT  (sizeof(status_fields) / sizeof(status_fields[0]))
+
+/* Body: ver type seq base | tag len value ... | CRC16. On the wire: 0x00 | COBS(body) | 0x00,
+ * COBS adding one code byte per 254 bytes of body. */
+#define FRAME_HEAD          4u
+#define FRAME_BODY_MAX      (FRAME_HEAD + 2u * STATUS_FIELD_COUNT + IMG_SIZE + 2u)
+#define FRAME_KEY_LEN       (1u + FRAME_BODY_MAX + (FRAME_BODY_MAX + 253u) / 254u + 1u)
+_Static_assert(FRAME_KEY_LEN <= UPSTREAM_TX_BUF_SIZE, "keyframe does not fit UPSTREAM_TX_BUF_SIZE");
+/* 10 bits per byte at 9600 baud (USART2 in main.c) */
+_Static_assert(FRAME_KEY_LEN * 10u * 1000u / 9600u < UPSTREAM_EVENT_MIN_GAP_MS,
+               "UPSTREAM_EVENT_MIN_GAP_MS shorter than a keyframe");
+_Static_assert(UPSTREAM_RX_RING_SIZE <= 128u && (UPSTREAM_RX_RING_SIZE & (UPSTREAM_RX_RING_SIZE - 1u)) == 0u,
+               "rx ring indices are free-running uint8_t");
+_Static_assert(UPSTREAM_RX_BUF_SIZE <= 255u, "rx_len is uint8_t");
+_Static_assert(UPSTREAM_REPLY_QUEUE_LEN <= 128u && (UPSTREAM_REPLY_QUEUE_LEN & (UPSTREAM_REPLY_QUEUE_LEN - 1u)) == 0u,
+               "reply queue indices are free-running uint8_t");
+_Static_assert((256u % UPSTREAM_DELTA_HISTORY) == 0u, "sent[] slot = seq % UPSTREAM_DELTA_HISTORY must survive seq wrap");
+
+/* Images of the last frames sent, for delta bases and acknowledgements */
+typedef struct {
+	uint8_t valid;
+	uint8_t seq;
+	uint8_t img[IMG_SIZE];
+} sent_frame_t;
+
+static uint8_t rx_byte;                 /* HAL_UART_Receive_IT target */
+static uint8_t rx_ring[UPSTREAM_RX_RING_SIZE];
+static volatile uint8_t rx_head;        /* ISR writes */
+static volatile uint8_t rx_tail;        /* UpstreamPC_Poll reads */
+static volatile uint8_t rx_armed;
+/* Decoder state for the frame in progress */
 static uint8_t rx_buf[UPSTREAM_RX_BUF_SIZE];
+static uint8_t rx_len;
+static uint8_t rx_code;                 /* code byte of the current COBS block */
+static uint8_t rx_left;                 /* data bytes still to come in that block */
+static uint8_t rx_drop;                 /* frame too long: skip to the next delimiter */
+static uint8_t body[FRAME_BODY_MAX];
 static uint8_t tx_buf[UPSTREAM_TX_BUF_SIZE];
-static volatile uint8_t rx_ready;
 static uint8_t tx_busy;
+static uint8_t reply_queue[UPSTREAM_REPLY_QUEUE_LEN][3];   /* type id result */
+static uint8_t reply_head;
+static uint8_t reply_tail;
 static upstream_cmd_cb_t cmd_cb;
+static upstream_report_mode_t report_mode;
+static uint8_t tx_seq;                  /* seq of the next frame */
+static uint8_t sent_once;
+static uint32_t last_tx_ms;
+static uint32_t last_key_ms;
+static uint8_t cur_img[IMG_SIZE];
+static sent_frame_t sent[UPSTREAM_DELTA_HISTORY];
+static uint8_t acked_valid;
+static uint8_t acked_seq;
+static uint8_t acked_img[IMG_SIZE];
 
-static uint8_t xor_checksum(const uint8_t *p, size_t n)
+static void start_rx(void)
 {
-	uint8_t chk = 0;
-	while (n--) chk ^= *p++;
-	return chk;
+	rx_armed = (HAL_UART_Receive_IT(&huart2, &rx_byte, 1) == HAL_OK) ? 1 : 0;
+}
+
+static void rx_frame_reset(void)
+{
+	rx_len = 0;
+	rx_left = 0;
+	rx_code = 0xFFu;                    /* no implied zero before the first block */
+	rx_drop = 0;
 }
 
 void UpstreamPC_Init(void)
 {
-	rx_ready = 0;
+	rx_head = 0;
+	rx_tail = 0;
+	rx_frame_reset();
 	tx_busy = 0;
+	reply_head = 0;
+	reply_tail = 0;
 	cmd_cb = NULL;
-	(void)HAL_UARTEx_ReceiveToIdle_IT(&huart2, rx_buf, UPSTREAM_RX_BUF_SIZE);
+	report_mode = UPSTREAM_REPORT_MODE_DEFAULT;
+	tx_seq = 0;
+	sent_once = 0;
+	acked_valid = 0;
+	memset(sent, 0, sizeof(sent));
+	start_rx();
 }
 
-void UpstreamPC_UART_RxEventCallback(uint16_t Size)
+/* Called from HAL for every received byte: queue it and re-arm. A full ring drops the byte; the frame
+ * it belonged to then fails its CRC. */
+void UpstreamPC_UART_RxCpltCallback(void)
 {
-	if (Size > 0 && Size <= UPSTREAM_RX_BUF_SIZE)
-		rx_ready = (uint8_t)Size;
+	uint8_t head = rx_head;
+	if ((uint8_t)(head - rx_tail) < UPSTREAM_RX_RING_SIZE) {
+		rx_ring[head & (UPSTREAM_RX_RING_SIZE - 1u)] = rx_byte;
+		__DMB();
+		rx_head = (uint8_t)(head + 1u);
+	}
+	start_rx();
 }
 
-static void parse_frame(uint8_t len)
+static const sent_frame_t *find_sent(uint8_t seq)
 {
-	if (len < 4) return; /* STX CMD CHK ETX minimum */
-	if (rx_buf[0] != UPSTREAM_STX || rx_buf[len - 1] != UPSTREAM_ETX) return;
-	uint8_t chk = xor_checksum(rx_buf + 1, (size_t)(len - 2));
-	if (chk != rx_buf[len - 2]) return;
+	for (uint8_t i = 0; i < UPSTREAM_DELTA_HISTORY; i++) {
+		if (sent[i].valid && sent[i].seq == seq) return &sent[i];
+	}
+	return NULL;
+}
+
+/* The PC has applied frame seq: its image becomes the delta base. Older acks are ignored. */
+static void handle_ack(uint8_t seq)
+{
+	const sent_frame_t *f = find_sent(seq);
+	if (!f) return;
+	if (acked_valid && (int8_t)(seq - acked_seq) <= 0) return;
+	memcpy(acked_img, f->img, IMG_SIZE);
+	acked_seq = seq;
+	acked_valid = 1;
+}
+
+/* Decoded frame in rx_buf: cmd payload... CRC16 */
+static void handle_frame(void)
+{
+	if (rx_len < 3u) return;
+	uint16_t crc = (uint16_t)(rx_buf[rx_len - 2u] | (rx_buf[rx_len - 1u] << 8));
+	if (ModbusRTU_CRC16(rx_buf, (size_t)(rx_len - 2u)) != crc) return;
 
 	LED_Status_OnRS485Activity();
-	uint8_t cmd = rx_buf[1];
-	uint8_t payload_len = len - 4; /* between CMD and CHK */
-	const uint8_t *payload = payload_len > 0 ? &rx_buf[2] : NULL;
+	uint8_t cmd = rx_buf[0];
+	uint8_t payload_len = (uint8_t)(rx_len - 3u);
+	const uint8_t *payload = payload_len > 0 ? &rx_buf[1] : NULL;
+	if (cmd == UPSTREAM_CMD_ACK) {
+		if (payload_len == 1) handle_ack(payload[0]);
+		return;
+	}
 	if (cmd_cb) cmd_cb(cmd, payload, payload_len);
 }
 
+static uint8_t rx_put(uint8_t b)
+{
+	if (rx_len >= UPSTREAM_RX_BUF_SIZE) {
+		rx_drop = 1;
+		return 0;
+	}
+	rx_buf[rx_len++] = b;
+	return 1;
+}
+
+/* COBS decode one byte. Each block is a code byte n followed by n-1 data bytes; a block with n < 0xFF
+ * stands for its data plus a zero, except the last one in the frame. */
+static void rx_decode(uint8_t b)
+{
+	if (b == UPSTREAM_FRAME_DELIM) {
+		/* Frame is complete only if its last block was; empty frames (back-to-back delimiters) are skipped */
+		if (!rx_drop && rx_left == 0 && rx_len > 0) handle_frame();
+		rx_frame_reset();
+		return;
+	}
+	if (rx_drop) return;
+	if (rx_left == 0) {
+		if (rx_code != 0xFFu && !rx_put(0)) return;
+		rx_code = b;
+		rx_left = (uint8_t)(b - 1u);
+	} else {
+		if (!rx_put(b)) return;
+		rx_left--;
+	}
+}
+
+static void send_reply(void);
+
 void UpstreamPC_Poll(void)
 {
-	if (rx_ready) {
-		uint8_t len = rx_ready;
-		rx_ready = 0;
-		parse_frame(len);
-		(void)HAL_UARTEx_ReceiveToIdle_IT(&huart2, rx_buf, UPSTREAM_RX_BUF_SIZE);
+	while (rx_tail != rx_head) {
+		__DMB();
+		uint8_t b = rx_ring[rx_tail & (UPSTREAM_RX_RING_SIZE - 1u)];
+		__DMB();
+		rx_tail = (uint8_t)(rx_tail + 1u);
+		rx_decode(b);
 	}
+	/* Reception stops after an overrun or a failed re-arm */
+	if (!rx_armed)
+		start_rx();
+	if (!tx_busy && reply_tail != reply_head)
+		send_reply();
 }
 
-/* Serialize aggregated_status into tx_buf: STX LEN [bytes...] CHK ETX. LEN = payload byte count. */
-static int build_status_frame(const aggregated_status_t *s, uint8_t *out, size_t out_size)
+static inline void put16(uint8_t *img, uint8_t ofs, uint16_t v)
 {
-	if (!s || out_size < 8) return -1;
-	size_t i = 0;
-	out[i++] = UPSTREAM_STX;
-	uint8_t *len_ptr = &out[i++];
-	out[i++] = (uint8_t)(s->timestamp_ms >> 0);
-	out[i++] = (uint8_t)(s->timestamp_ms >> 8);
-	out[i++] = (uint8_t)(s->timestamp_ms >> 16);
-	out[i++] = (uint8_t)(s->timestamp_ms >> 24);
-	out[i++] = (uint8_t)(s->env_temp_cx10 >> 0);
-	out[i++] = (uint8_t)(s->env_temp_cx10 >> 8);
-	out[i++] = (uint8_t)(s->env_rh_x10 >> 0);
-	out[i++] = (uint8_t)(s->env_rh_x10 >> 8);
-	out[i++] = s->main_di;
-	out[i++] = s->main_do;
-	out[i++] = s->hpsb_coils;
-	out[i++] = s->hpsb_discrete;
-	out[i++] = (uint8_t)(s->hpsb_status_reg >> 0);
-	out[i++] = (uint8_t)(s->hpsb_status_reg >> 8);
-	out[i++] = (uint8_t)(s->hpsb_alarm_reg >> 0);
-	out[i++] = (uint8_t)(s->hpsb_alarm_reg >> 8);
-	/* Backward-compatible compact LPSB summary:
-	 * - lpsb_coils: LPSB1 coils[0..2] packed into bits[0..2]
-	 * - lpsb_discrete/status_reg: not modeled in aggregated_status_t -> 0
-	 * - lpsb_alarm_reg: use LPSB1 alarm reg
-	 */
-	uint8_t  lpsb_coils = 0;
-	lpsb_coils |= (s->lpsb1_coils[0] ? (1u << 0) : 0);
-	lpsb_coils |= (s->lpsb1_coils[1] ? (1u << 1) : 0);
-	lpsb_coils |= (s->lpsb1_coils[2] ? (1u << 2) : 0);
-	uint8_t  lpsb_discrete = 0;
-	uint16_t lpsb_status_reg = 0;
-	uint16_t lpsb_alarm_reg = s->lpsb1_alarm_reg;
-	out[i++] = lpsb_coils;
-	out[i++] = lpsb_discrete;
-	out[i++] = (uint8_t)(lpsb_status_reg >> 0);
-	out[i++] = (uint8_t)(lpsb_status_reg >> 8);
-	out[i++] = (uint8_t)(lpsb_alarm_reg >> 0);
-	out[i++] = (uint8_t)(lpsb_alarm_reg >> 8);
-	out[i++] = (uint8_t)(s->error_flags >> 0);
-	out[i++] = (uint8_t)(s->error_flags >> 8);
-	if (i + 3 > out_size) return -1;
-	*len_ptr = (uint8_t)(i - 2);
-	uint8_t chk = xor_checksum(&out[1], (size_t)(i - 1));
-	out[i++] = chk;
-	out[i++] = UPSTREAM_ETX;
-	return (int)i;
+	img[ofs] = (uint8_t)(v >> 0);
+	img[ofs + 1] = (uint8_t)(v >> 8);
 }
 
-int UpstreamPC_SendStatus(const aggregated_status_t *status)
+static void build_image(const aggregated_status_t *s, uint8_t *img)
+{
+	put16(img, IMG_TIMESTAMP, (uint16_t)(s->timestamp_ms >> 0));
+	put16(img, IMG_TIMESTAMP + 2, (uint16_t)(s->timestamp_ms >> 16));
+	put16(img, IMG_ENV_TEMP, (uint16_t)s->env_temp_cx10);
+	put16(img, IMG_ENV_RH, s->env_rh_x10);
+	img[IMG_MAIN_DI] = s->main_di;
+	img[IMG_MAIN_DO] = s->main_do;
+	put16(img, IMG_ERROR_FLAGS, s->error_flags);
+	img[IMG_STALE_MASK] = s->stale_mask;
+	img[IMG_HPSB_COILS] = s->hpsb_coils;
+	img[IMG_HPSB_DISCRETE] = s->hpsb_discrete;
+	put16(img, IMG_HPSB_STATUS, s->hpsb_status_reg);
+	put16(img, IMG_HPSB_ALARM, s->hpsb_alarm_reg);
+	for (uint8_t p = 0; p < 3u; p++)
+		put16(img, (uint8_t)(IMG_HPSB_SENSE + p * 2u), s->hpsb_sense_raw[p]);
+	for (uint8_t n = 0; n < SLAVE_LPSB_MAPPED_COUNT; n++) {
+		uint8_t coils = 0;
+		for (uint8_t p = 0; p < SLAVE_LPSB_PORT_COUNT; p++) {
+			if (s->lpsb_coils[n][p]) coils |= (uint8_t)(1u << p);
+			put16(img, (uint8_t)(IMG_LPSB_SENSE(n) + p * 2u), s->lpsb_sense_raw[n][p]);
+		}
+		img[IMG_LPSB(n)] = coils;
+		put16(img, (uint8_t)(IMG_LPSB(n) + 1u), s->lpsb_alarm_reg[n]);
+	}
+}
+
+static inline uint8_t field_differs(const status_field_t *f, const uint8_t *a, const uint8_t *b)
+{
+	return memcmp(a + f->ofs, b + f->ofs, f->len) != 0;
+}
+
+/* Delta against the acked image and every frame sent after it (all still in sent[]) */
+static uint8_t field_in_delta(const status_field_t *f)
+{
+	if (field_differs(f, cur_img, acked_img)) return 1;
+	for (uint8_t i = 0; i < UPSTREAM_DELTA_HISTORY; i++) {
+		if (sent[i].valid && (int8_t)(sent[i].seq - acked_seq) > 0 && field_differs(f, cur_img, sent[i].img))
+			return 1;
+	}
+	return 0;
+}
+
+/* COBS-encode n bytes of src into dst (no delimiters); returns the encoded length */
+static size_t cobs_encode(const uint8_t *src, size_t n, uint8_t *dst)
+{
+	size_t code_at = 0;
+	size_t o = 1;
+	uint8_t code = 1;
+	for (size_t i = 0; i < n; i++) {
+		if (src[i] != 0) {
+			dst[o++] = src[i];
+			code++;
+		}
+		if (src[i] == 0 || code == 0xFFu) {
+			dst[code_at] = code;
+			code_at = o++;
+			code = 1;
+		}
+	}
+	dst[code_at] = code;
+	return o;
+}
+
+/* CRC n bytes of body and frame them into tx_buf; returns the frame length.
+ * Leading delimiter flushes whatever partial frame the PC may be holding. */
+static int encode_body(size_t n)
+{
+	ModbusRTU_AppendCRC(body, n);
+	size_t o = 0;
+	tx_buf[o++] = UPSTREAM_FRAME_DELIM;
+	o += cobs_encode(body, n + 2u, &tx_buf[o]);
+	tx_buf[o++] = UPSTREAM_FRAME_DELIM;
+	return (int)o;
+}
+
+static int start_tx(int len)
 {
-	if (tx_busy) return -1;
-	int len = build_status_frame(status, tx_buf, UPSTREAM_TX_BUF_SIZE);
-	if (len <= 0) return -1;
 	tx_busy = 1;
 	if (HAL_UART_Transmit_IT(&huart2, tx_buf, (uint16_t)len) != HAL_OK) {
 		tx_busy = 0;
@@ -124,6 +339,101 @@ int UpstreamPC_SendStatus(const aggregated_status_t *status)
 	return 0;
 }
 
+/* Frame of cur_img into tx_buf; returns its length */
+static int build_status_frame(uint8_t key)
+{
+	size_t i = 0;
+	body[i++] = UPSTREAM_FRAME_VERSION;
+	body[i++] = key ? UPSTREAM_FRAME_KEY : UPSTREAM_FRAME_DELTA;
+	body[i++] = tx_seq;
+	body[i++] = key ? tx_seq : acked_seq;
+	for (uint8_t k = 0; k < STATUS_FIELD_COUNT; k++) {
+		const status_field_t *f = &status_fields[k];
+		if (!key && !field_in_delta(f)) continue;
+		body[i++] = f->tag;
+		body[i++] = f->len;
+		memcpy(&body[i], &cur_img[f->ofs], f->len);
+		i += f->len;
+	}
+	return encode_body(i);
+}
+
+static void send_reply(void)
+{
+	const uint8_t *r = reply_queue[reply_tail & (UPSTREAM_REPLY_QUEUE_LEN - 1u)];
+	body[0] = UPSTREAM_FRAME_VERSION;
+	memcpy(&body[1], r, 3);
+	if (start_tx(encode_body(4)) == 0)
+		reply_tail = (uint8_t)(reply_tail + 1u);
+}
+
+int UpstreamPC_QueueReply(uint8_t type, uint8_t id, uint8_t result)
+{
+	if ((uint8_t)(reply_head - reply_tail) >= UPSTREAM_REPLY_QUEUE_LEN) return -1;
+	uint8_t *r = reply_queue[reply_head & (UPSTREAM_REPLY_QUEUE_LEN - 1u)];
+	r[0] = type;
+	r[1] = id;
+	r[2] = result;
+	reply_head = (uint8_t)(reply_head + 1u);
+	return 0;
+}
+
+/* Keyframe when there is no base, the PC is too far behind for sent[] to cover, or one is due */
+static uint8_t need_keyframe(uint32_t now)
+{
+	if (!acked_valid || !sent_once) return 1;
+	if ((uint8_t)(tx_seq - 1u - acked_seq) > UPSTREAM_DELTA_HISTORY) return 1;
+	return (now - last_key_ms) >= UPSTREAM_KEYFRAME_MS;
+}
+
+static int send_frame(void)
+{
+	uint32_t now = HAL_GetTick();
+	uint8_t key = need_keyframe(now);
+	if (start_tx(build_status_frame(key)) != 0) return -1;
+	sent_frame_t *f = &sent[tx_seq % UPSTREAM_DELTA_HISTORY];
+	f->valid = 1;
+	f->seq = tx_seq;
+	memcpy(f->img, cur_img, IMG_SIZE);
+	last_tx_ms = now;
+	if (key) last_key_ms = now;
+	sent_once = 1;
+	tx_seq++;
+	return 0;
+}
+
+int UpstreamPC_SendStatus(const aggregated_status_t *status)
+{
+	if (tx_busy || !status) return -1;
+	build_image(status, cur_img);
+	return send_frame();
+}
+
+int UpstreamPC_Report(const aggregated_status_t *status, uint8_t periodic_due)
+{
+	if (report_mode == UPSTREAM_REPORT_PERIODIC)
+		return (periodic_due && UpstreamPC_SendStatus(status) == 0) ? 1 : 0;
+
+	if (tx_busy || !status) return 0;
+	uint32_t since = HAL_GetTick() - last_tx_ms;
+	if (sent_once && since < UPSTREAM_EVENT_MIN_GAP_MS) return 0;
+	build_image(status, cur_img);
+	if (sent_once && since < UPSTREAM_EVENT_HEARTBEAT_MS) {
+		/* Compare with the last frame sent */
+		const uint8_t *last = sent[(uint8_t)(tx_seq - 1u) % UPSTREAM_DELTA_HISTORY].img;
+		uint8_t changed = 0;
+		for (uint8_t k = 0; k < STATUS_FIELD_COUNT && !changed; k++)
+			changed = status_fields[k].trigger && field_differs(&status_fields[k], cur_img, last);
+		if (!changed) return 0;
+	}
+	return (send_frame() == 0) ? 1 : 0;
+}
+
+void UpstreamPC_SetReportMode(upstream_report_mode_t mode)
+{
+	report_mode = mode;
+}
+
 void UpstreamPC_SetCommandCallback(upstream_cmd_cb_t cb)
 {
 	cmd_cb = cb;
@@ -136,15 +446,11 @@ void UpstreamPC_TxCpltCallback(void)
 	LED_Status_OnRS485Activity();
 }
 
-/* Override weak HAL callbacks for USART2 (PC link). */
-void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+/* Overrun aborts the byte reception (re-armed from UpstreamPC_Poll); noise/framing errors leave it running */
+void UpstreamPC_ErrorCallback(void)
 {
-	if (huart == &huart2)
-		UpstreamPC_UART_RxEventCallback(Size);
-}
-
-void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
-{
-	if (huart == &huart2)
-		UpstreamPC_TxCpltCallback();
+	if (huart2.RxState == HAL_UART_STATE_READY)
+		rx_armed = 0;
+	if (huart2.gState == HAL_UART_STATE_READY)
+		tx_busy = 0;
 }
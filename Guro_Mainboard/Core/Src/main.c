@@ -22,12 +22,25 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "app_scheduler.h"
+#include "app_event.h"
+#include "app_supervisor.h"
+#include "uart_dispatch.h"
+#include "profiler.h"
 #include "aggregator.h"
 #include "aggregated_status.h"
 #include "upstream_pc_protocol.h"
+#include "upstream_cmd.h"
+#include "upstream_rtu.h"
 #include "modbus_master.h"
+#include "modbus_baud.h"
+#include "bus_enum.h"
+#include "capture_fetch.h"
 #include "gateway_actions.h"
+#include "timed_io.h"
+#include "remote_output.h"
 #include "led_status.h"
+#include "dirty_flags.h"
+#include "io_map.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -110,10 +123,29 @@ int main(void)
   MX_USART1_UART_Init();
   MX_USART2_UART_Init();
   /* USER CODE BEGIN 2 */
+  AppSupervisor_Init();
+  Profiler_Init();
+  AppEvent_Init();
+  UartDispatch_Init();
   AppScheduler_Init();
+#if UPSTREAM_LINK_RTU
+  /* No status report to send: a release nobody takes would keep the loop from idling */
+  AppScheduler_SetPeriod(TASK_UPSTREAM_SEND_STATUS, 0);
+#endif
   ModbusMaster_Init();
+  BusEnum_Init();
+  ModbusBaud_Init();
+  CaptureFetch_Init();
+  TimedIO_Init();
+  RemoteOut_Init();
   AggregatedStatus_Clear(&aggregated_status);
+  Aggregator_Init();
+#if UPSTREAM_LINK_RTU
+  UpstreamRTU_Init(&aggregated_status);
+#else
   UpstreamPC_Init();
+  UpstreamCmd_Init();
+#endif
   LED_Status_Init();
   /* USER CODE END 2 */
 
@@ -124,18 +156,79 @@ int main(void)
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
-    LED_Status_Tick_1ms();
+    PROFILE_LOOP();
+    PROFILE_BEGIN(PROF_EVENT_DISPATCH);
+    AppEvent_Dispatch();
+    PROFILE_END(PROF_EVENT_DISPATCH);
+    PROFILE_BEGIN(PROF_SCHEDULER);
     AppScheduler_Update();
-
-    if (AppScheduler_IsDue(TASK_UPSTREAM_POLL))
+    PROFILE_END(PROF_SCHEDULER);
+
+#if UPSTREAM_LINK_RTU
+    if (AppScheduler_IsDue(TASK_UPSTREAM_POLL)) {
+      PROFILE_BEGIN(PROF_TASK_UPSTREAM_POLL);
+      UpstreamRTU_Poll();
+      AppSupervisor_CheckIn(APP_SUP_UPSTREAM);
+      PROFILE_END(PROF_TASK_UPSTREAM_POLL);
+    }
+#else
+    if (AppScheduler_IsDue(TASK_UPSTREAM_POLL)) {
+      PROFILE_BEGIN(PROF_TASK_UPSTREAM_POLL);
+      PROFILE_BEGIN(PROF_UPSTREAM_PC_POLL);
       UpstreamPC_Poll();
-    if (AppScheduler_IsDue(TASK_DOWNSTREAM_MODBUS))
+      PROFILE_END(PROF_UPSTREAM_PC_POLL);
+      UpstreamCmd_Poll();
+      AppSupervisor_CheckIn(APP_SUP_UPSTREAM);
+      PROFILE_END(PROF_TASK_UPSTREAM_POLL);
+    }
+#endif
+    if (AppScheduler_IsDue(TASK_DOWNSTREAM_MODBUS)) {
+      PROFILE_BEGIN(PROF_TASK_DOWNSTREAM_MODBUS);
+      PROFILE_BEGIN(PROF_MODBUS_MASTER_POLL);
       ModbusMaster_Poll();
-    if (AppScheduler_IsDue(TASK_AGGREGATE_UPDATE))
+      PROFILE_END(PROF_MODBUS_MASTER_POLL);
+      BusEnum_Poll();
+      ModbusBaud_Poll();
+      CaptureFetch_Poll();
+      AppSupervisor_CheckIn(APP_SUP_DOWNSTREAM);
+      PROFILE_END(PROF_TASK_DOWNSTREAM_MODBUS);
+    }
+    if (AppScheduler_IsDue(TASK_MAIN_IO_SCAN)) {
+      PROFILE_BEGIN(PROF_TASK_MAIN_IO_SCAN);
+      IO_Main_ScanDI();
+      PROFILE_END(PROF_TASK_MAIN_IO_SCAN);
+    }
+    if (AppScheduler_IsDue(TASK_AGGREGATE_UPDATE)) {
+      PROFILE_BEGIN(PROF_TASK_AGGREGATE_UPDATE);
+      DirtyFlags_Mark(DIRTY_AGE_TICK);
+      PROFILE_END(PROF_TASK_AGGREGATE_UPDATE);
+    }
+    if (AppScheduler_IsDue(TASK_LED_STATUS)) {
+      PROFILE_BEGIN(PROF_LED_TICK);
+      LED_Status_Tick_1ms();
+      PROFILE_END(PROF_LED_TICK);
+    }
+    if (AppScheduler_IsDue(TASK_GATEWAY_ACTIONS)) {
+      PROFILE_BEGIN(PROF_GATEWAY_ACTIONS);
+      Gateway_Action_Update();
+      AppSupervisor_CheckIn(APP_SUP_GATEWAY_ACTIONS);
+      PROFILE_END(PROF_GATEWAY_ACTIONS);
+    }
+    /* Whatever the tasks above marked is aggregated on this pass */
+    if (DirtyFlags_Any()) AppScheduler_Trigger(TASK_AGGREGATOR);
+    if (AppScheduler_IsDue(TASK_AGGREGATOR)) {
+      PROFILE_BEGIN(PROF_AGGREGATOR);
       Aggregator_Update(&aggregated_status);
-    Gateway_Action_Update();
-    if (AppScheduler_IsDue(TASK_UPSTREAM_SEND_STATUS))
-      UpstreamPC_SendStatus(&aggregated_status);
+      AppSupervisor_CheckIn(APP_SUP_AGGREGATOR);
+      PROFILE_END(PROF_AGGREGATOR);
+    }
+#if !UPSTREAM_LINK_RTU
+    PROFILE_BEGIN(PROF_UPSTREAM_REPORT);
+    UpstreamPC_Report(&aggregated_status, AppScheduler_IsDue(TASK_UPSTREAM_SEND_STATUS));
+    PROFILE_END(PROF_UPSTREAM_REPORT);
+#endif
+    AppSupervisor_Update();
+    AppEvent_Idle();
   }
   /* USER CODE END 3 */
 }
@@ -330,16 +423,17 @@ static void MX_WWDG_Init(void)
 
   /* USER CODE END WWDG_Init 1 */
   hwwdg.Instance = WWDG;
-  hwwdg.Init.Prescaler = WWDG_PRESCALER_1;
-  hwwdg.Init.Window = 64;
-  hwwdg.Init.Counter = 64;
-  hwwdg.Init.EWIMode = WWDG_EWI_DISABLE;
+  hwwdg.Init.Prescaler = WWDG_PRESCALER_8;
+  hwwdg.Init.Window = 96;
+  hwwdg.Init.Counter = 127;
+  hwwdg.Init.EWIMode = WWDG_EWI_ENABLE;
   if (HAL_WWDG_Init(&hwwdg) != HAL_OK)
   {
     Error_Handler();
   }
   /* USER CODE BEGIN WWDG_Init 2 */
-
+  /* Counter stops while the core is halted by the debugger */
+  __HAL_DBGMCU_FREEZE_WWDG();
   /* USER CODE END WWDG_Init 2 */
 
 }
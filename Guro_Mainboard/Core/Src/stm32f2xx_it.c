@@ -22,6 +22,7 @@
 #include "stm32f2xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "upstream_rtu.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -55,6 +56,7 @@
 /* USER CODE END 0 */
 
 /* External variables --------------------------------------------------------*/
+extern WWDG_HandleTypeDef hwwdg;
 extern UART_HandleTypeDef huart1;
 extern UART_HandleTypeDef huart2;
 /* USER CODE BEGIN EV */
@@ -199,6 +201,20 @@ void SysTick_Handler(void)
 /* please refer to the startup file (startup_stm32f2xx.s).                    */
 /******************************************************************************/
 
+/**
+  * @brief This function handles Window watchdog interrupt.
+  */
+void WWDG_IRQHandler(void)
+{
+  /* USER CODE BEGIN WWDG_IRQn 0 */
+
+  /* USER CODE END WWDG_IRQn 0 */
+  HAL_WWDG_IRQHandler(&hwwdg);
+  /* USER CODE BEGIN WWDG_IRQn 1 */
+
+  /* USER CODE END WWDG_IRQn 1 */
+}
+
 /**
   * @brief This function handles USART1 global interrupt.
   */
@@ -229,4 +245,20 @@ void USART2_IRQHandler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles DMA1 stream5 global interrupt (USART2 RX, upstream RTU).
+  */
+void DMA1_Stream5_IRQHandler(void)
+{
+  UpstreamRTU_DMA_RxIRQHandler();
+}
+
+/**
+  * @brief This function handles DMA1 stream6 global interrupt (USART2 TX, upstream RTU).
+  */
+void DMA1_Stream6_IRQHandler(void)
+{
+  UpstreamRTU_DMA_TxIRQHandler();
+}
+
 /* USER CODE END 1 */
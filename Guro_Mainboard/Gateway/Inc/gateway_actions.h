@@ -1,7 +1,7 @@
 /**
  * @file gateway_actions.h
- * @brief Non-blocking gateway actions: door pulse (300ms), output toggle.
- *        Call Gateway_Action_Update() from main loop (e.g. every 1ms).
+ * @brief Non-blocking gateway actions: door pulse (300ms default), output toggle.
+ *        Call Gateway_Action_Update() from main loop (e.g. every 1ms); it services every timed_io output.
  */
 #ifndef GATEWAY_ACTIONS_H
 #define GATEWAY_ACTIONS_H
@@ -14,8 +14,16 @@ extern "C" {
 
 void Gateway_Action_Update(void);
 
-/** Returns 1 if any downstream WriteCoil failed since last clear; does not clear. Clear via ClearDownstreamWriteFailAlarm (e.g. on PC read of 1x0880). */
+/** Energize main relay 1/2 for pulse_ms (0 = 300 ms); a request while the pulse runs restarts it. */
+void Gateway_Action_PulseMainDoor1(uint16_t pulse_ms);
+void Gateway_Action_PulseMainDoor2(uint16_t pulse_ms);
+/** Returns 1 while the pulse on door 1 or 2 is running. */
+uint8_t Gateway_Action_IsDoorPulseActive(uint8_t door);
+
+/** Returns 1 if any downstream coil write failed since last clear; does not clear. Clear via ClearDownstreamWriteFailAlarm (e.g. on PC read of 1x0880). */
 uint8_t Gateway_Action_PollDownstreamWriteFail(void);
+/** Raise the downstream write-fail alarm (remote_output.c, on a write not echoed). */
+void Gateway_Action_ReportDownstreamWriteFail(void);
 /** Clear the downstream write-fail alarm (e.g. after PC read of 1x0880 or auto after N seconds). */
 void Gateway_Action_ClearDownstreamWriteFailAlarm(void);
 
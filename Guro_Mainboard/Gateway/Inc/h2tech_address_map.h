@@ -1,7 +1,10 @@
 /**
  * @file h2tech_address_map.h
- * @brief H2TECH address mapping: table-driven 1x discrete/coil for upstream Modbus Slave.
+ * @brief H2TECH address mapping: table-driven 1x discrete inputs and 3x/4x registers for the
+ *        upstream Modbus Slave.
  *        H2TECH PDF "1xNNNN" = DEC logical address NNNN; Modbus start_addr = (NNNN - 1).
+ *        3x/4x rows are keyed by the register number of CURRENT_REG_MAP.md, which is the Modbus
+ *        start_addr itself (4x2000 -> start_addr 2000).
  */
 #pragma once
 #include <stdint.h>
@@ -26,10 +29,31 @@ typedef enum {
     H2_RW_WRITE = 1
 } H2_Rw_t;
 
+/* For 3x/4x rows H2_RW_WRITE means read/write */
 typedef enum {
     H2_SRC_AGG_BIT = 0,
     H2_SRC_ACTION_PULSE,
-    H2_SRC_CONST0
+    H2_SRC_CONST0,
+    /* Registers; arg as noted */
+    H2_SRC_AGG_U16,             /* arg = offsetof(aggregated_status_t, field) */
+    H2_SRC_AGG_U8,              /* arg = offsetof(aggregated_status_t, field) */
+    H2_SRC_LPSB_COILS,          /* arg = n: bit p = lpsb_coils[n][p] */
+    H2_SRC_MAIN_DI,             /* live MAIN DI bitmap */
+    H2_SRC_MAIN_DO,             /* live MAIN DO bitmap */
+    H2_SRC_LINK_STAT,           /* arg = H2_LINK_ARG(board, stat): low 16 bits of the counter */
+    H2_SRC_CAPTURE_INFO,        /* arg = register offset in the 4x2200 capture block */
+    H2_SRC_CAPTURE_OFFSET,
+    H2_SRC_1X_MODE,
+    H2_SRC_PROFILE,             /* arg = register offset in the 4x2500 profiler block */
+    H2_SRC_PROFILE_SELECT,
+    H2_SRC_SUPERVISOR,          /* arg = register offset in the 4x2600 supervisor block */
+    H2_SRC_SLAVE_EVENT,         /* arg = register offset in the 4x2700 slave event block */
+    H2_SRC_TIMED_IO_SELECT,
+    H2_SRC_TIMED_IO,            /* arg = register offset in the 4x2800 timed output block */
+    H2_SRC_REMOTE_OUT_SELECT,
+    H2_SRC_REMOTE_OUT,          /* arg = register offset in the 4x2900 remote coil block */
+    H2_SRC_SCHED_SELECT,
+    H2_SRC_SCHED                /* arg = register offset in the 4x2950 scheduler block */
 } H2_Source_t;
 
 typedef enum {
@@ -37,15 +61,37 @@ typedef enum {
     H2_ACT_PULSE_MAIN_DOOR1,
     H2_ACT_PULSE_MAIN_DOOR2,
     H2_ACT_TOGGLE_OUTPUT,
-    H2_ACT_PULSE_OUTPUT
+    H2_ACT_PULSE_OUTPUT,
+    /* Register writes, carried out by upstream_slave_h2tech.c */
+    H2_ACT_WRITE_DO_BITMAP,
+    H2_ACT_CAPTURE_START,
+    H2_ACT_CAPTURE_OFFSET,
+    H2_ACT_SET_1X_MODE,
+    H2_ACT_PROFILE_CLEAR,
+    H2_ACT_PROFILE_SELECT,
+    H2_ACT_EVENT_ACK,
+    H2_ACT_TIMED_IO_SELECT,
+    H2_ACT_REMOTE_OUT_SELECT,
+    H2_ACT_REMOTE_OUT_CLEAR,
+    H2_ACT_SCHED_SELECT
 } H2_Action_t;
 
+/* H2_SRC_LINK_STAT: board 0 = HPSB, 1 + n = LPSB n; stat = ModbusLinkStats_t field */
+typedef enum {
+    H2_LINK_OK = 0,
+    H2_LINK_TIMEOUT,
+    H2_LINK_BAD_FRAME,
+    H2_LINK_EXCEPTION
+} H2_LinkStat_t;
+#define H2_LINK_ARG(board, stat)    ((uint16_t)(((board) << 2) | (stat)))
+
 typedef struct {
     uint16_t h2_dec;
     H2_Area_t area;
     H2_Rw_t   rw;
     H2_Source_t src;
     uint16_t agg_bit_index;
+    uint16_t arg;               /* register sources, see H2_Source_t */
     H2_Action_t action;
     const char* name;
 } H2_MapEntry_t;
@@ -102,9 +148,25 @@ typedef enum {
     AGG_BIT_COUNT
 } AggBitIndex_t;
 
+/* Mapped extents: 1x0821..0898, 3x3000..3044, 4x2000..2956 */
 const H2_MapEntry_t* H2Map_FindByDec(H2_Area_t area, uint16_t h2_dec);
+/* First of the count entries h2_dec..h2_dec+count-1 (consecutive in the table, so the caller can
+ * index it), NULL unless every one of them is mapped. */
+const H2_MapEntry_t* H2Map_FindRun(H2_Area_t area, uint16_t h2_dec, uint16_t count);
+/* Read value of count consecutive entries (from H2Map_FindRun) into out bits out_bit.., LSB-first.
+ * Stretches mapped to consecutive agg bits are copied from the agg image up to 8 bits at a time;
+ * CONST0 and write-only entries read 0. Other bits of out are kept. */
+void H2Map_ReadRunBits(const H2_MapEntry_t* e, uint16_t count, uint8_t* out, uint16_t out_bit);
+/* Gap-tolerant read of h2_dec..h2_dec+count-1 into out bits 0.., LSB-first: addresses missing from
+ * the table read 0. false if the span leaves the mapped extent of the area; 1x only. */
+bool H2Map_ReadSpanBits(H2_Area_t area, uint16_t h2_dec, uint16_t count, uint8_t* out);
 bool H2Map_ReadAggBit(uint16_t agg_bit_index);
 void H2Map_WriteAggBit(uint16_t agg_bit_index, bool v);
+/* agg bits [first, first + count) = bits 0..count-1 of bits (count <= 32), a byte at a time */
+void H2Map_WriteAggBits(uint16_t first, uint16_t count, uint32_t bits);
+/* true if H2Map_ApplyWrite(e, ...) would accept the entry; lets a multi-coil write check its whole
+ * range before carrying out any of it */
+bool H2Map_CanApplyWrite(const H2_MapEntry_t* e);
 bool H2Map_ApplyWrite(const H2_MapEntry_t* e, bool value, uint16_t pulse_ms);
 
 /* Modbus start_addr -> H2TECH dec: h2_dec = start_addr + 1 */
@@ -0,0 +1,66 @@
+/**
+ * @file remote_output.h
+ * @brief MAIN board: confirmed transactions for the LPSB coils driven by the PC.
+ *        A request sets the coil's target; one FC05 at a time carries it to the slave (master job
+ *        slot), the echo moves it on the bus, and the next coil poll after the echo confirms it.
+ *        Toggles flip the pending target, not the polled image, so repeated clicks fold into one
+ *        write (or none, if they cancel out). Main-loop context only.
+ */
+#ifndef REMOTE_OUTPUT_H
+#define REMOTE_OUTPUT_H
+
+#include "io_map.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define REMOTE_OUT_COUNT            (SLAVE_LPSB_MAPPED_COUNT * SLAVE_LPSB_PORT_COUNT)
+#define REMOTE_OUT_CONFIRM_MS       2000u   /* echo not followed by a coil poll: give up confirming */
+#define REMOTE_OUT_HIST_BUCKETS     12u     /* 0, 1, 2-3, 4-7, ... 512-1023, >= 1024 ms */
+
+/* Latency stages of one transaction */
+typedef enum {
+    REMOTE_OUT_LAT_QUEUE = 0,   /* first request -> FC05 accepted by the master */
+    REMOTE_OUT_LAT_ECHO,        /* -> echo received */
+    REMOTE_OUT_LAT_CONFIRM,     /* -> next coil poll shows the state */
+    REMOTE_OUT_LAT_TOTAL,       /* first request -> confirmed */
+    REMOTE_OUT_LAT_COUNT
+} RemoteOut_Latency_t;
+
+typedef struct {
+    uint16_t bucket[REMOTE_OUT_HIST_BUCKETS];   /* saturating counts */
+    uint16_t max_ms;
+} RemoteOut_Hist_t;
+
+typedef struct {
+    uint32_t requests;
+    uint32_t coalesced;         /* requests folded into a transaction already open */
+    uint32_t writes;            /* FC05 echoed */
+    uint32_t failed;            /* FC05 timeout / exception / bad echo */
+    uint32_t mismatch;          /* confirming poll showed another state */
+    uint32_t unconfirmed;       /* no coil poll within REMOTE_OUT_CONFIRM_MS */
+} RemoteOut_Stats_t;
+
+void RemoteOut_Init(void);
+/* Run the transactions; call every main-loop pass */
+void RemoteOut_Update(void);
+
+/* LPSB n (0-based) coil p. Return -1 on a bad index. */
+int  RemoteOut_Toggle(uint8_t n, uint8_t p);
+int  RemoteOut_Set(uint8_t n, uint8_t p, uint8_t value);
+/* 1 while a change to the coil is not yet confirmed */
+uint8_t RemoteOut_IsBusy(uint8_t n, uint8_t p);
+/* State the last transaction confirmed (the polled image when it opened, if it failed) */
+uint8_t RemoteOut_GetState(uint8_t n, uint8_t p);
+
+void RemoteOut_GetStats(RemoteOut_Stats_t *out);
+void RemoteOut_GetHistogram(RemoteOut_Latency_t stage, RemoteOut_Hist_t *out);
+void RemoteOut_ClearMetrics(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REMOTE_OUTPUT_H */
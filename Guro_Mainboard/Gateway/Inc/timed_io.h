@@ -0,0 +1,69 @@
+/**
+ * @file timed_io.h
+ * @brief MAIN board: timed outputs on the local DOs and the LPSB coils - pulses, delayed writes and
+ *        step sequences - all serviced from TimedIO_Tick() on a hashed timer wheel.
+ *        One timer per output channel; starting a new action on a channel replaces the pending one.
+ *        Remote coils are handed to remote_output (RemoteOut_Set), which carries them to the slave
+ *        and confirms them against the coil poll, so timed and PC writes share one transaction.
+ *        Main-loop context only.
+ */
+#ifndef TIMED_IO_H
+#define TIMED_IO_H
+
+#include "io_map.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Channels: MAIN DO relays, then LPSB n coil p */
+#define TIMED_IO_DO(ch)             ((uint8_t)(ch))
+#define TIMED_IO_LPSB_COIL(n, p)    ((uint8_t)(MAIN_DO_COUNT + (n) * SLAVE_LPSB_PORT_COUNT + (p)))
+#define TIMED_IO_CH_COUNT           (MAIN_DO_COUNT + SLAVE_LPSB_MAPPED_COUNT * SLAVE_LPSB_PORT_COUNT)
+
+#define TIMED_IO_WHEEL_SLOTS        64u     /* 1 ms per slot, power of 2 */
+#define TIMED_IO_KEEP               0xFFu   /* step value: leave the output as it is */
+
+typedef enum {
+    TIMED_IO_RETRIGGER = 0,     /* restart the pulse from now */
+    TIMED_IO_EXTEND,            /* add to the running pulse's remaining time */
+    TIMED_IO_IGNORE             /* keep the running action, drop the request */
+} TimedIO_Mode_t;
+
+/* Sequence step: set value (0/1 or TIMED_IO_KEEP), then wait hold_ms before the next step.
+ * The last step's hold_ms is not used. */
+typedef struct {
+    uint8_t  value;
+    uint16_t hold_ms;
+} TimedIO_Step_t;
+
+/* Lateness = time from a step's due tick to the write being issued (remote: handed to RemoteOut) */
+typedef struct {
+    uint32_t steps;             /* outputs written */
+    uint32_t failed;            /* remote writes refused by RemoteOut (once per step, retried every
+                                 * tick) or not confirmed at the coil */
+    uint16_t last_late_ms;
+    uint16_t max_late_ms;
+} TimedIO_Stats_t;
+
+void TimedIO_Init(void);
+/* Advance the wheel to HAL_GetTick() and fire what is due; call every main-loop pass */
+void TimedIO_Tick(void);
+
+/* Output on now, off after ms (> 0). Returns -1 on a bad channel, or in IGNORE mode while active. */
+int  TimedIO_Pulse(uint8_t ch, uint16_t ms, TimedIO_Mode_t mode);
+/* Write value after ms */
+int  TimedIO_SetAfter(uint8_t ch, uint8_t value, uint16_t ms);
+/* Run n steps; steps must stay valid until the sequence ends (static const tables) */
+int  TimedIO_Sequence(uint8_t ch, const TimedIO_Step_t *steps, uint8_t n);
+void TimedIO_Cancel(uint8_t ch);
+/* 1 while an action has steps left to run */
+uint8_t TimedIO_IsActive(uint8_t ch);
+void TimedIO_GetStats(uint8_t ch, TimedIO_Stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMED_IO_H */
@@ -0,0 +1,33 @@
+/**
+ * @file upstream_cmd.h
+ * @brief MAIN board: command layer of the legacy PC link (upstream_pc_protocol.c).
+ *        Commands are checked and queued as they arrive and acknowledged as soon as the reply queue
+ *        has room (a resent id still queued is re-acknowledged, not queued twice); they are then
+ *        carried out in order, one at a time, and each gets a completion reply when done. Sub-board
+ *        writes go through the Modbus master job slot and complete when the slave has echoed them.
+ *        Main-loop context only.
+ */
+#ifndef UPSTREAM_CMD_H
+#define UPSTREAM_CMD_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UPSTREAM_CMD_QUEUE_LEN      8u
+
+/* Clear the queue and register as the UpstreamPC command callback */
+void UpstreamCmd_Init(void);
+/* Start the next command and send completions; call after UpstreamPC_Poll() */
+void UpstreamCmd_Poll(void);
+
+/* UpstreamPC command callback: data = id args... */
+void UpstreamCmd_Handle(uint8_t cmd, const uint8_t *data, uint8_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPSTREAM_CMD_H */
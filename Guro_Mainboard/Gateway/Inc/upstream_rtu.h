@@ -0,0 +1,49 @@
+/**
+ * @file upstream_rtu.h
+ * @brief MAIN board: Modbus RTU slave transport for the PC link on USART2.
+ *        DMA receive ended by the idle line; address and CRC are checked in the RX buffer and the
+ *        request is handed to UpstreamSlave_HandleRequest() in place. The response PDU is built
+ *        straight into the TX buffer behind the address byte, the CRC is appended there and the
+ *        frame goes out by DMA. Main-loop context except for the *Callback / *IRQHandler entries.
+ */
+#ifndef UPSTREAM_RTU_H
+#define UPSTREAM_RTU_H
+
+#include "aggregated_status.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* PC link protocol on USART2, chosen at build time: 1 = Modbus RTU slave (this module, what the
+ * PC test tool speaks), 0 = legacy COBS status frames (upstream_pc_protocol.c) */
+#ifndef UPSTREAM_LINK_RTU
+#define UPSTREAM_LINK_RTU           1
+#endif
+
+/* MAIN's unit ID on the PC link; matches the PC test tool default (MAIN_SLAVE_ID_DEFAULT) */
+#ifndef UPSTREAM_RTU_UNIT_ID
+#define UPSTREAM_RTU_UNIT_ID        9u
+#endif
+/* Largest frames: FC16 with 123 registers (255 B) in, FC03/04 with 125 registers (255 B) out */
+#define UPSTREAM_RTU_RX_BUF_SIZE    256u
+#define UPSTREAM_RTU_TX_BUF_SIZE    256u
+
+/* Set up the USART2 DMA streams (DMA1 stream 5 RX, stream 6 TX, channel 4) and start receiving.
+ * agg is the image the register reads are served from. */
+void UpstreamRTU_Init(const aggregated_status_t *agg);
+/* Handle a received frame, if any, and keep reception armed */
+void UpstreamRTU_Poll(void);
+
+void UpstreamRTU_UART_RxEventCallback(uint16_t Size);
+void UpstreamRTU_TxCpltCallback(void);
+void UpstreamRTU_ErrorCallback(void);
+void UpstreamRTU_DMA_RxIRQHandler(void);
+void UpstreamRTU_DMA_TxIRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPSTREAM_RTU_H */
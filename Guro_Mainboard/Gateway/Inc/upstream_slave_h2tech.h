@@ -14,7 +14,7 @@ extern "C" {
 
 /**
  * Handle one Modbus request from PC (H2TECH addresses).
- * @param fc         Modbus function code (01..04 read, 05/06/15/16 write).
+ * @param fc         Modbus function code (02/03/04 read, 05/06/15/16 write; 01 -> 0x01).
  * @param start_addr H2TECH logical start address (e.g. 821).
  * @param count      Number of coils/discrete/registers.
  * @param write_data For FC05/06/15/16, payload; else NULL.
@@ -25,7 +25,12 @@ extern "C" {
  *
  * Exception handling:
  * - If any address in [start_addr, start_addr+count) not in translation table -> 0x02.
- * - If FC not supported -> 0x01. If rw violation or bad value -> 0x03.
+ *   In gap-tolerant mode FC02 reads such addresses as 0 instead, as long as the range stays inside
+ *   the mapped 1x extent (0821..0898).
+ * - If FC not supported -> 0x01. If rw violation or bad value/count -> 0x03.
+ * - FC03/04 read any sub-range of one mapped register run; FC16 checks the whole range is writable
+ *   before writing.
+ * - Capture start (4x2200) while a fetch is running -> 0x06.
  * Exception response format: response[0]=FC|0x80, response[1]=exception_code; return 2.
  */
 int UpstreamSlave_HandleRequest(uint8_t fc, uint16_t start_addr, uint16_t count,
@@ -33,6 +38,11 @@ int UpstreamSlave_HandleRequest(uint8_t fc, uint16_t start_addr, uint16_t count,
                                 const void *p_agg,
                                 uint8_t *response, uint16_t resp_max);
 
+/* 1x read mode, also settable by the PC through 4x2400. Strict (0) at boot; a dispatcher serving a
+ * second upstream unit id can switch it per request. */
+void    UpstreamSlave_SetGapTolerant(uint8_t on);
+uint8_t UpstreamSlave_IsGapTolerant(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -3,9 +3,12 @@
  * @brief H2TECH table-driven mapping: g_agg_bits image and g_map entries.
  *        Concrete mapping: 0821~0836, 0853~0860, 0869~0880, 0885~0891, 0892~0898.
  *        0899/0900 not in table -> exception 0x02.
+ *        Registers: 4x2000~2013, 2100~2101, 2200~2206, 2300~2315, 2400, 2500~2519, 2600~2616, 2700~2710, 2800~2806, 2900~2919, 2950~2956; 3x3000~3044.
+ *        Lookup is O(1): a dense per-address index per area generated from the row lists at compile time.
  */
 #include <stddef.h>
 #include "h2tech_address_map.h"
+#include "aggregated_status.h"
 
 static volatile uint8_t g_agg_bits[(AGG_BIT_COUNT + 7) / 8] = {0};
 
@@ -32,78 +35,438 @@ void H2Map_WriteAggBit(uint16_t agg_bit_index, bool v) {
     bit_set(g_agg_bits, agg_bit_index, v);
 }
 
-#define H2E(_area, _dec, _rw, _src, _agg_bit, _act, _label) \
-    { .h2_dec=(_dec), .area=(_area), .rw=(_rw), .src=(_src), .agg_bit_index=(_agg_bit), .action=(_act), .name=(_label) }
-
-static const H2_MapEntry_t g_map[] = {
-    /* 1x0821~0836 : ON/OFF 1~16 status (READ) */
-    H2E(H2_AREA_1X, 821, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ONOFF_1,  H2_ACT_NONE, "ONOFF_1_DOOR1"),
-    H2E(H2_AREA_1X, 822, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ONOFF_2,  H2_ACT_NONE, "ONOFF_2_DOOR2"),
-    H2E(H2_AREA_1X, 823, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ONOFF_3,  H2_ACT_NONE, "ONOFF_3_HPSB_CH1"),
-    H2E(H2_AREA_1X, 824, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ONOFF_4,  H2_ACT_NONE, "ONOFF_4_HPSB_CH2"),
-    H2E(H2_AREA_1X, 825, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ONOFF_5,  H2_ACT_NONE, "ONOFF_5_HPSB_CH3"),
-    H2E(H2_AREA_1X, 826, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ONOFF_6,  H2_ACT_NONE, "ONOFF_6_LPSB1_CH1"),
-    H2E(H2_AREA_1X, 827, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ONOFF_7,  H2_ACT_NONE, "ONOFF_7_LPSB1_CH2"),
-    H2E(H2_AREA_1X, 828, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ONOFF_8,  H2_ACT_NONE, "ONOFF_8_LPSB1_CH3"),
-    H2E(H2_AREA_1X, 829, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ONOFF_9,  H2_ACT_NONE, "ONOFF_9_LPSB2_CH1"),
-    H2E(H2_AREA_1X, 830, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ONOFF_10, H2_ACT_NONE, "ONOFF_10_LPSB2_CH2"),
-    H2E(H2_AREA_1X, 831, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ONOFF_11, H2_ACT_NONE, "ONOFF_11_LPSB2_CH3"),
-    H2E(H2_AREA_1X, 832, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ONOFF_12, H2_ACT_NONE, "ONOFF_12_LPSB3_CH1"),
-    H2E(H2_AREA_1X, 833, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ONOFF_13, H2_ACT_NONE, "ONOFF_13_LPSB3_CH2"),
-    H2E(H2_AREA_1X, 834, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ONOFF_14, H2_ACT_NONE, "ONOFF_14_LPSB3_CH3"),
-    H2E(H2_AREA_1X, 835, H2_RW_READ, H2_SRC_CONST0, 0,               H2_ACT_NONE, "ONOFF_15_RESERVED"),
-    H2E(H2_AREA_1X, 836, H2_RW_READ, H2_SRC_CONST0, 0,               H2_ACT_NONE, "ONOFF_16_RESERVED"),
-
-    /* 1x0853~0860 : Door sensors (READ) */
-    H2E(H2_AREA_1X, 853, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_DOOR_MAG_1, H2_ACT_NONE, "DOOR_MAG_1"),
-    H2E(H2_AREA_1X, 854, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_DOOR_MAG_2, H2_ACT_NONE, "DOOR_MAG_2"),
-    H2E(H2_AREA_1X, 855, H2_RW_READ, H2_SRC_CONST0,  0,                 H2_ACT_NONE, "DOOR_MAG_3_UNUSED"),
-    H2E(H2_AREA_1X, 856, H2_RW_READ, H2_SRC_CONST0,  0,                 H2_ACT_NONE, "DOOR_MAG_4_UNUSED"),
-    H2E(H2_AREA_1X, 857, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_DOOR_BTN_1, H2_ACT_NONE, "DOOR_BTN_1"),
-    H2E(H2_AREA_1X, 858, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_DOOR_BTN_2, H2_ACT_NONE, "DOOR_BTN_2"),
-    H2E(H2_AREA_1X, 859, H2_RW_READ, H2_SRC_CONST0,  0,                 H2_ACT_NONE, "DOOR_BTN_3_UNUSED"),
-    H2E(H2_AREA_1X, 860, H2_RW_READ, H2_SRC_CONST0,  0,                 H2_ACT_NONE, "DOOR_BTN_4_UNUSED"),
-
-    /* 1x0869~0880 : Alarm 1~12 (READ) */
-    H2E(H2_AREA_1X, 869, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ALM_1,  H2_ACT_NONE, "ALM_1_HPSB_COMM"),
-    H2E(H2_AREA_1X, 870, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ALM_2,  H2_ACT_NONE, "ALM_2_LPSB_ANY_COMM"),
-    H2E(H2_AREA_1X, 871, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ALM_3,  H2_ACT_NONE, "ALM_3_SHTC3_FAIL"),
-    H2E(H2_AREA_1X, 872, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ALM_4,  H2_ACT_NONE, "ALM_4_DOOR_SENSOR_FAULT"),
-    H2E(H2_AREA_1X, 873, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ALM_5,  H2_ACT_NONE, "ALM_5_HPSB_OC1"),
-    H2E(H2_AREA_1X, 874, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ALM_6,  H2_ACT_NONE, "ALM_6_HPSB_OC2"),
-    H2E(H2_AREA_1X, 875, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ALM_7,  H2_ACT_NONE, "ALM_7_HPSB_OC3"),
-    H2E(H2_AREA_1X, 876, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ALM_8,  H2_ACT_NONE, "ALM_8_LPSB1_OC_ANY"),
-    H2E(H2_AREA_1X, 877, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ALM_9,  H2_ACT_NONE, "ALM_9_LPSB2_OC_ANY"),
-    H2E(H2_AREA_1X, 878, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ALM_10, H2_ACT_NONE, "ALM_10_LPSB3_OC_ANY"),
-    H2E(H2_AREA_1X, 879, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ALM_11, H2_ACT_NONE, "ALM_11_PC_LINK_FAIL"),
-    H2E(H2_AREA_1X, 880, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_ALM_12, H2_ACT_NONE, "ALM_12_DOWNSTREAM_WRITE_FAIL"),
-
-    /* 1x0885~0891 : ON/OFF 1~7 command/extra (READ) */
-    H2E(H2_AREA_1X, 885, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_CMD_ONOFF_1, H2_ACT_NONE, "CMD_ONOFF_1"),
-    H2E(H2_AREA_1X, 886, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_CMD_ONOFF_2, H2_ACT_NONE, "CMD_ONOFF_2"),
-    H2E(H2_AREA_1X, 887, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_CMD_ONOFF_3, H2_ACT_NONE, "CMD_ONOFF_3"),
-    H2E(H2_AREA_1X, 888, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_CMD_ONOFF_4, H2_ACT_NONE, "CMD_ONOFF_4"),
-    H2E(H2_AREA_1X, 889, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_CMD_ONOFF_5, H2_ACT_NONE, "CMD_ONOFF_5"),
-    H2E(H2_AREA_1X, 890, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_CMD_ONOFF_6, H2_ACT_NONE, "CMD_ONOFF_6"),
-    H2E(H2_AREA_1X, 891, H2_RW_READ, H2_SRC_AGG_BIT, AGG_BIT_CMD_ONOFF_7, H2_ACT_NONE, "CMD_ONOFF_7"),
-
-    /* 1x0892~0898 : Virtual buttons / Door open control (WRITE). 0899/0900 not in table -> 0x02 */
-    H2E(H2_AREA_1X, 892, H2_RW_WRITE, H2_SRC_ACTION_PULSE, 0, H2_ACT_PULSE_OUTPUT, "VB_ONOFF_8"),
-    H2E(H2_AREA_1X, 893, H2_RW_WRITE, H2_SRC_ACTION_PULSE, 0, H2_ACT_PULSE_OUTPUT, "VB_ONOFF_9"),
-    H2E(H2_AREA_1X, 894, H2_RW_WRITE, H2_SRC_ACTION_PULSE, 0, H2_ACT_PULSE_OUTPUT, "VB_ONOFF_10"),
-    H2E(H2_AREA_1X, 895, H2_RW_WRITE, H2_SRC_ACTION_PULSE, 0, H2_ACT_PULSE_OUTPUT, "VB_ONOFF_11"),
-    H2E(H2_AREA_1X, 896, H2_RW_WRITE, H2_SRC_ACTION_PULSE, 0, H2_ACT_PULSE_OUTPUT, "VB_ONOFF_12"),
-    H2E(H2_AREA_1X, 897, H2_RW_WRITE, H2_SRC_ACTION_PULSE, 0, H2_ACT_PULSE_MAIN_DOOR1, "DOOR_OPEN_CTRL_1"),
-    H2E(H2_AREA_1X, 898, H2_RW_WRITE, H2_SRC_ACTION_PULSE, 0, H2_ACT_PULSE_MAIN_DOOR2, "DOOR_OPEN_CTRL_2"),
+void H2Map_WriteAggBits(uint16_t first, uint16_t count, uint32_t bits) {
+    if (first >= AGG_BIT_COUNT) return;
+    if (count > AGG_BIT_COUNT - first) count = (uint16_t)(AGG_BIT_COUNT - first);
+    if (count > 32u) count = 32u;
+    while (count) {
+        uint16_t byte = first >> 3;
+        uint8_t  off  = (uint8_t)(first & 7u);
+        uint8_t  n    = (uint8_t)((8u - off < count) ? 8u - off : count);
+        uint8_t  mask = (uint8_t)(((1u << n) - 1u) << off);
+        g_agg_bits[byte] = (uint8_t)((g_agg_bits[byte] & (uint8_t)~mask) | ((uint8_t)(bits << off) & mask));
+        bits >>= n;
+        first = (uint16_t)(first + n);
+        count = (uint16_t)(count - n);
+    }
+}
+
+/* dst bits [dst_bit, dst_bit + len) = src bits [src_bit, src_bit + len); one output byte per step */
+static void copy_bits(uint8_t* dst, uint16_t dst_bit, const volatile uint8_t* src, uint16_t src_bit, uint16_t len) {
+    while (len) {
+        uint8_t  d_off = (uint8_t)(dst_bit & 7u);
+        uint8_t  s_off = (uint8_t)(src_bit & 7u);
+        uint8_t  n     = (uint8_t)((8u - d_off < len) ? 8u - d_off : len);
+        uint16_t win   = src[src_bit >> 3];
+        if (s_off + n > 8u) win |= (uint16_t)(src[(src_bit >> 3) + 1u] << 8);
+        uint8_t  mask  = (uint8_t)(((1u << n) - 1u) << d_off);
+        uint8_t* d     = &dst[dst_bit >> 3];
+        *d = (uint8_t)((*d & (uint8_t)~mask) | ((uint8_t)((win >> s_off) << d_off) & mask));
+        dst_bit = (uint16_t)(dst_bit + n);
+        src_bit = (uint16_t)(src_bit + n);
+        len     = (uint16_t)(len - n);
+    }
+}
+
+/* One row per mapped 1x address: X(dec, rw, src, agg_bit, action, label), ascending.
+ * g_map, its dense index and the run table below are all generated from this list. */
+#define H2_MAP_1X(X) \
+    /* 1x0821~0836 : ON/OFF 1~16 status (READ) */ \
+    X(821, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ONOFF_1,      H2_ACT_NONE,             "ONOFF_1_DOOR1") \
+    X(822, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ONOFF_2,      H2_ACT_NONE,             "ONOFF_2_DOOR2") \
+    X(823, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ONOFF_3,      H2_ACT_NONE,             "ONOFF_3_HPSB_CH1") \
+    X(824, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ONOFF_4,      H2_ACT_NONE,             "ONOFF_4_HPSB_CH2") \
+    X(825, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ONOFF_5,      H2_ACT_NONE,             "ONOFF_5_HPSB_CH3") \
+    X(826, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ONOFF_6,      H2_ACT_NONE,             "ONOFF_6_LPSB1_CH1") \
+    X(827, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ONOFF_7,      H2_ACT_NONE,             "ONOFF_7_LPSB1_CH2") \
+    X(828, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ONOFF_8,      H2_ACT_NONE,             "ONOFF_8_LPSB1_CH3") \
+    X(829, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ONOFF_9,      H2_ACT_NONE,             "ONOFF_9_LPSB2_CH1") \
+    X(830, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ONOFF_10,     H2_ACT_NONE,             "ONOFF_10_LPSB2_CH2") \
+    X(831, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ONOFF_11,     H2_ACT_NONE,             "ONOFF_11_LPSB2_CH3") \
+    X(832, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ONOFF_12,     H2_ACT_NONE,             "ONOFF_12_LPSB3_CH1") \
+    X(833, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ONOFF_13,     H2_ACT_NONE,             "ONOFF_13_LPSB3_CH2") \
+    X(834, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ONOFF_14,     H2_ACT_NONE,             "ONOFF_14_LPSB3_CH3") \
+    X(835, H2_RW_READ,  H2_SRC_CONST0,       0,                    H2_ACT_NONE,             "ONOFF_15_RESERVED") \
+    X(836, H2_RW_READ,  H2_SRC_CONST0,       0,                    H2_ACT_NONE,             "ONOFF_16_RESERVED") \
+    /* 1x0853~0860 : Door sensors (READ) */ \
+    X(853, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_DOOR_MAG_1,   H2_ACT_NONE,             "DOOR_MAG_1") \
+    X(854, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_DOOR_MAG_2,   H2_ACT_NONE,             "DOOR_MAG_2") \
+    X(855, H2_RW_READ,  H2_SRC_CONST0,       0,                    H2_ACT_NONE,             "DOOR_MAG_3_UNUSED") \
+    X(856, H2_RW_READ,  H2_SRC_CONST0,       0,                    H2_ACT_NONE,             "DOOR_MAG_4_UNUSED") \
+    X(857, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_DOOR_BTN_1,   H2_ACT_NONE,             "DOOR_BTN_1") \
+    X(858, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_DOOR_BTN_2,   H2_ACT_NONE,             "DOOR_BTN_2") \
+    X(859, H2_RW_READ,  H2_SRC_CONST0,       0,                    H2_ACT_NONE,             "DOOR_BTN_3_UNUSED") \
+    X(860, H2_RW_READ,  H2_SRC_CONST0,       0,                    H2_ACT_NONE,             "DOOR_BTN_4_UNUSED") \
+    /* 1x0869~0880 : Alarm 1~12 (READ) */ \
+    X(869, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ALM_1,        H2_ACT_NONE,             "ALM_1_HPSB_COMM") \
+    X(870, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ALM_2,        H2_ACT_NONE,             "ALM_2_LPSB_ANY_COMM") \
+    X(871, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ALM_3,        H2_ACT_NONE,             "ALM_3_SHTC3_FAIL") \
+    X(872, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ALM_4,        H2_ACT_NONE,             "ALM_4_DOOR_SENSOR_FAULT") \
+    X(873, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ALM_5,        H2_ACT_NONE,             "ALM_5_HPSB_OC1") \
+    X(874, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ALM_6,        H2_ACT_NONE,             "ALM_6_HPSB_OC2") \
+    X(875, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ALM_7,        H2_ACT_NONE,             "ALM_7_HPSB_OC3") \
+    X(876, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ALM_8,        H2_ACT_NONE,             "ALM_8_LPSB1_OC_ANY") \
+    X(877, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ALM_9,        H2_ACT_NONE,             "ALM_9_LPSB2_OC_ANY") \
+    X(878, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ALM_10,       H2_ACT_NONE,             "ALM_10_LPSB3_OC_ANY") \
+    X(879, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ALM_11,       H2_ACT_NONE,             "ALM_11_PC_LINK_FAIL") \
+    X(880, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_ALM_12,       H2_ACT_NONE,             "ALM_12_DOWNSTREAM_WRITE_FAIL") \
+    /* 1x0885~0891 : ON/OFF 1~7 command/extra (READ) */ \
+    X(885, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_CMD_ONOFF_1,  H2_ACT_NONE,             "CMD_ONOFF_1") \
+    X(886, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_CMD_ONOFF_2,  H2_ACT_NONE,             "CMD_ONOFF_2") \
+    X(887, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_CMD_ONOFF_3,  H2_ACT_NONE,             "CMD_ONOFF_3") \
+    X(888, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_CMD_ONOFF_4,  H2_ACT_NONE,             "CMD_ONOFF_4") \
+    X(889, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_CMD_ONOFF_5,  H2_ACT_NONE,             "CMD_ONOFF_5") \
+    X(890, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_CMD_ONOFF_6,  H2_ACT_NONE,             "CMD_ONOFF_6") \
+    X(891, H2_RW_READ,  H2_SRC_AGG_BIT,      AGG_BIT_CMD_ONOFF_7,  H2_ACT_NONE,             "CMD_ONOFF_7") \
+    /* 1x0892~0898 : Virtual buttons / Door open control (WRITE). 0899/0900 not in table -> 0x02 */ \
+    X(892, H2_RW_WRITE, H2_SRC_ACTION_PULSE, 0,                    H2_ACT_PULSE_OUTPUT,     "VB_ONOFF_8") \
+    X(893, H2_RW_WRITE, H2_SRC_ACTION_PULSE, 0,                    H2_ACT_PULSE_OUTPUT,     "VB_ONOFF_9") \
+    X(894, H2_RW_WRITE, H2_SRC_ACTION_PULSE, 0,                    H2_ACT_PULSE_OUTPUT,     "VB_ONOFF_10") \
+    X(895, H2_RW_WRITE, H2_SRC_ACTION_PULSE, 0,                    H2_ACT_PULSE_OUTPUT,     "VB_ONOFF_11") \
+    X(896, H2_RW_WRITE, H2_SRC_ACTION_PULSE, 0,                    H2_ACT_PULSE_OUTPUT,     "VB_ONOFF_12") \
+    X(897, H2_RW_WRITE, H2_SRC_ACTION_PULSE, 0,                    H2_ACT_PULSE_MAIN_DOOR1, "DOOR_OPEN_CTRL_1") \
+    X(898, H2_RW_WRITE, H2_SRC_ACTION_PULSE, 0,                    H2_ACT_PULSE_MAIN_DOOR2, "DOOR_OPEN_CTRL_2")
+
+/* Register rows: X(reg, rw, src, arg, action, label), ascending; arg per H2_Source_t.
+ * Register numbers must not collide with 1x addresses or each other (one H2_IDX_<dec> per row). */
+#define AGG_OFF(_field) offsetof(aggregated_status_t, _field)
+
+#define H2_MAP_4X(X) \
+    /* 4x2000~2013 : per-port current raw; 2012/2013 MAIN door currents (none) */ \
+    X(2000, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(hpsb_sense_raw[0]),            H2_ACT_NONE,               "HPSB_CUR_1") \
+    X(2001, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(hpsb_sense_raw[1]),            H2_ACT_NONE,               "HPSB_CUR_2") \
+    X(2002, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(hpsb_sense_raw[2]),            H2_ACT_NONE,               "HPSB_CUR_3") \
+    X(2003, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_sense_raw[0][0]),         H2_ACT_NONE,               "LPSB1_CUR_1") \
+    X(2004, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_sense_raw[0][1]),         H2_ACT_NONE,               "LPSB1_CUR_2") \
+    X(2005, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_sense_raw[0][2]),         H2_ACT_NONE,               "LPSB1_CUR_3") \
+    X(2006, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_sense_raw[1][0]),         H2_ACT_NONE,               "LPSB2_CUR_1") \
+    X(2007, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_sense_raw[1][1]),         H2_ACT_NONE,               "LPSB2_CUR_2") \
+    X(2008, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_sense_raw[1][2]),         H2_ACT_NONE,               "LPSB2_CUR_3") \
+    X(2009, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_sense_raw[2][0]),         H2_ACT_NONE,               "LPSB3_CUR_1") \
+    X(2010, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_sense_raw[2][1]),         H2_ACT_NONE,               "LPSB3_CUR_2") \
+    X(2011, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_sense_raw[2][2]),         H2_ACT_NONE,               "LPSB3_CUR_3") \
+    X(2012, H2_RW_READ, H2_SRC_CONST0,         0,                                     H2_ACT_NONE,               "DOOR1_CUR_NONE") \
+    X(2013, H2_RW_READ, H2_SRC_CONST0,         0,                                     H2_ACT_NONE,               "DOOR2_CUR_NONE") \
+    /* 4x2100~2101 : MAIN DI bitmap, DO bitmap (R/W, bits 0..3) */ \
+    X(2100, H2_RW_READ, H2_SRC_MAIN_DI,        0,                                     H2_ACT_NONE,               "MAIN_DI") \
+    X(2101, H2_RW_WRITE, H2_SRC_MAIN_DO,        0,                                     H2_ACT_WRITE_DO_BITMAP,    "MAIN_DO") \
+    /* 4x2200~2206 : waveform capture control and info (4x2210 sample readout is not a table row) */ \
+    X(2200, H2_RW_WRITE, H2_SRC_CAPTURE_INFO,   0,                                     H2_ACT_CAPTURE_START,      "CAPTURE_CTRL") \
+    X(2201, H2_RW_WRITE, H2_SRC_CAPTURE_OFFSET, 0,                                     H2_ACT_CAPTURE_OFFSET,     "CAPTURE_OFFSET") \
+    X(2202, H2_RW_READ, H2_SRC_CAPTURE_INFO,   2,                                     H2_ACT_NONE,               "CAPTURE_COUNT") \
+    X(2203, H2_RW_READ, H2_SRC_CAPTURE_INFO,   3,                                     H2_ACT_NONE,               "CAPTURE_PERIOD_US") \
+    X(2204, H2_RW_READ, H2_SRC_CAPTURE_INFO,   4,                                     H2_ACT_NONE,               "CAPTURE_PRETRIG") \
+    X(2205, H2_RW_READ, H2_SRC_CAPTURE_INFO,   5,                                     H2_ACT_NONE,               "CAPTURE_SEQ") \
+    X(2206, H2_RW_READ, H2_SRC_CAPTURE_INFO,   6,                                     H2_ACT_NONE,               "CAPTURE_SLAVE_STATUS") \
+    /* 4x2300~2315 : data age, 2300 + board * 4 + area */ \
+    X(2300, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(data_age_ms[0][0]),            H2_ACT_NONE,               "AGE_HPSB_DI") \
+    X(2301, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(data_age_ms[0][1]),            H2_ACT_NONE,               "AGE_HPSB_COIL") \
+    X(2302, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(data_age_ms[0][2]),            H2_ACT_NONE,               "AGE_HPSB_HOLD") \
+    X(2303, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(data_age_ms[0][3]),            H2_ACT_NONE,               "AGE_HPSB_INPUT") \
+    X(2304, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(data_age_ms[1][0]),            H2_ACT_NONE,               "AGE_LPSB1_DI") \
+    X(2305, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(data_age_ms[1][1]),            H2_ACT_NONE,               "AGE_LPSB1_COIL") \
+    X(2306, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(data_age_ms[1][2]),            H2_ACT_NONE,               "AGE_LPSB1_HOLD") \
+    X(2307, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(data_age_ms[1][3]),            H2_ACT_NONE,               "AGE_LPSB1_INPUT") \
+    X(2308, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(data_age_ms[2][0]),            H2_ACT_NONE,               "AGE_LPSB2_DI") \
+    X(2309, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(data_age_ms[2][1]),            H2_ACT_NONE,               "AGE_LPSB2_COIL") \
+    X(2310, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(data_age_ms[2][2]),            H2_ACT_NONE,               "AGE_LPSB2_HOLD") \
+    X(2311, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(data_age_ms[2][3]),            H2_ACT_NONE,               "AGE_LPSB2_INPUT") \
+    X(2312, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(data_age_ms[3][0]),            H2_ACT_NONE,               "AGE_LPSB3_DI") \
+    X(2313, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(data_age_ms[3][1]),            H2_ACT_NONE,               "AGE_LPSB3_COIL") \
+    X(2314, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(data_age_ms[3][2]),            H2_ACT_NONE,               "AGE_LPSB3_HOLD") \
+    X(2315, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(data_age_ms[3][3]),            H2_ACT_NONE,               "AGE_LPSB3_INPUT") \
+    /* 4x2400 : 1x read mode (R/W) */ \
+    X(2400, H2_RW_WRITE, H2_SRC_1X_MODE,        0,                                     H2_ACT_SET_1X_MODE,        "CFG_1X_MODE") \
+    /* 4x2500~2519 : main-loop profiler, figures of the probe selected by 4x2500 (profiler.h) */ \
+    X(2500, H2_RW_WRITE, H2_SRC_PROFILE_SELECT, 0,                                     H2_ACT_PROFILE_SELECT,     "PROF_SELECT") \
+    X(2501, H2_RW_WRITE, H2_SRC_PROFILE,        1,                                     H2_ACT_PROFILE_CLEAR,      "PROF_CTRL") \
+    X(2502, H2_RW_READ, H2_SRC_PROFILE,        2,                                     H2_ACT_NONE,               "PROF_UTIL_X10") \
+    X(2503, H2_RW_READ, H2_SRC_PROFILE,        3,                                     H2_ACT_NONE,               "PROF_CPU_MHZ") \
+    X(2504, H2_RW_READ, H2_SRC_PROFILE,        4,                                     H2_ACT_NONE,               "PROF_COUNT_HI") \
+    X(2505, H2_RW_READ, H2_SRC_PROFILE,        5,                                     H2_ACT_NONE,               "PROF_COUNT_LO") \
+    X(2506, H2_RW_READ, H2_SRC_PROFILE,        6,                                     H2_ACT_NONE,               "PROF_MIN_HI") \
+    X(2507, H2_RW_READ, H2_SRC_PROFILE,        7,                                     H2_ACT_NONE,               "PROF_MIN_LO") \
+    X(2508, H2_RW_READ, H2_SRC_PROFILE,        8,                                     H2_ACT_NONE,               "PROF_MAX_HI") \
+    X(2509, H2_RW_READ, H2_SRC_PROFILE,        9,                                     H2_ACT_NONE,               "PROF_MAX_LO") \
+    X(2510, H2_RW_READ, H2_SRC_PROFILE,        10,                                    H2_ACT_NONE,               "PROF_MEAN_HI") \
+    X(2511, H2_RW_READ, H2_SRC_PROFILE,        11,                                    H2_ACT_NONE,               "PROF_MEAN_LO") \
+    X(2512, H2_RW_READ, H2_SRC_PROFILE,        12,                                    H2_ACT_NONE,               "PROF_HIST_0") \
+    X(2513, H2_RW_READ, H2_SRC_PROFILE,        13,                                    H2_ACT_NONE,               "PROF_HIST_1") \
+    X(2514, H2_RW_READ, H2_SRC_PROFILE,        14,                                    H2_ACT_NONE,               "PROF_HIST_2") \
+    X(2515, H2_RW_READ, H2_SRC_PROFILE,        15,                                    H2_ACT_NONE,               "PROF_HIST_3") \
+    X(2516, H2_RW_READ, H2_SRC_PROFILE,        16,                                    H2_ACT_NONE,               "PROF_HIST_4") \
+    X(2517, H2_RW_READ, H2_SRC_PROFILE,        17,                                    H2_ACT_NONE,               "PROF_HIST_5") \
+    X(2518, H2_RW_READ, H2_SRC_PROFILE,        18,                                    H2_ACT_NONE,               "PROF_HIST_6") \
+    X(2519, H2_RW_READ, H2_SRC_PROFILE,        19,                                    H2_ACT_NONE,               "PROF_HIST_7") \
+    /* 4x2600~2616 : task supervisor / WWDG, previous boot's record and this boot's loop gaps */ \
+    X(2600, H2_RW_READ, H2_SRC_SUPERVISOR,     0,                                     H2_ACT_NONE,               "SUP_RESET_FLAGS") \
+    X(2601, H2_RW_READ, H2_SRC_SUPERVISOR,     1,                                     H2_ACT_NONE,               "SUP_WWDG_RESETS") \
+    X(2602, H2_RW_READ, H2_SRC_SUPERVISOR,     2,                                     H2_ACT_NONE,               "SUP_STARVE_EVENTS") \
+    X(2603, H2_RW_READ, H2_SRC_SUPERVISOR,     3,                                     H2_ACT_NONE,               "SUP_PREV_CAUSE") \
+    X(2604, H2_RW_READ, H2_SRC_SUPERVISOR,     4,                                     H2_ACT_NONE,               "SUP_PREV_STARVED") \
+    X(2605, H2_RW_READ, H2_SRC_SUPERVISOR,     5,                                     H2_ACT_NONE,               "SUP_PREV_LAST_TASK") \
+    X(2606, H2_RW_READ, H2_SRC_SUPERVISOR,     6,                                     H2_ACT_NONE,               "SUP_PREV_UPTIME_S") \
+    X(2607, H2_RW_READ, H2_SRC_SUPERVISOR,     7,                                     H2_ACT_NONE,               "SUP_PREV_MAX_GAP_MS") \
+    X(2608, H2_RW_READ, H2_SRC_SUPERVISOR,     8,                                     H2_ACT_NONE,               "SUP_MAX_GAP_MS") \
+    X(2609, H2_RW_READ, H2_SRC_SUPERVISOR,     9,                                     H2_ACT_NONE,               "SUP_GAP_HIST_0") \
+    X(2610, H2_RW_READ, H2_SRC_SUPERVISOR,     10,                                    H2_ACT_NONE,               "SUP_GAP_HIST_1") \
+    X(2611, H2_RW_READ, H2_SRC_SUPERVISOR,     11,                                    H2_ACT_NONE,               "SUP_GAP_HIST_2") \
+    X(2612, H2_RW_READ, H2_SRC_SUPERVISOR,     12,                                    H2_ACT_NONE,               "SUP_GAP_HIST_3") \
+    X(2613, H2_RW_READ, H2_SRC_SUPERVISOR,     13,                                    H2_ACT_NONE,               "SUP_GAP_HIST_4") \
+    X(2614, H2_RW_READ, H2_SRC_SUPERVISOR,     14,                                    H2_ACT_NONE,               "SUP_GAP_HIST_5") \
+    X(2615, H2_RW_READ, H2_SRC_SUPERVISOR,     15,                                    H2_ACT_NONE,               "SUP_GAP_HIST_6") \
+    X(2616, H2_RW_READ, H2_SRC_SUPERVISOR,     16,                                    H2_ACT_NONE,               "SUP_GAP_HIST_7") \
+    /* 4x2700~2710 : slave events drained by FC24, oldest first; write 2700 = its log number to ack */ \
+    X(2700, H2_RW_WRITE, H2_SRC_SLAVE_EVENT,    0,                                     H2_ACT_EVENT_ACK,          "EVT_LOG_SEQ") \
+    X(2701, H2_RW_READ, H2_SRC_SLAVE_EVENT,    1,                                     H2_ACT_NONE,               "EVT_PENDING") \
+    X(2702, H2_RW_READ, H2_SRC_SLAVE_EVENT,    2,                                     H2_ACT_NONE,               "EVT_SLAVE_ID") \
+    X(2703, H2_RW_READ, H2_SRC_SLAVE_EVENT,    3,                                     H2_ACT_NONE,               "EVT_SEQ") \
+    X(2704, H2_RW_READ, H2_SRC_SLAVE_EVENT,    4,                                     H2_ACT_NONE,               "EVT_TYPE_INDEX") \
+    X(2705, H2_RW_READ, H2_SRC_SLAVE_EVENT,    5,                                     H2_ACT_NONE,               "EVT_VALUE") \
+    X(2706, H2_RW_READ, H2_SRC_SLAVE_EVENT,    6,                                     H2_ACT_NONE,               "EVT_SLAVE_TICK") \
+    X(2707, H2_RW_READ, H2_SRC_SLAVE_EVENT,    7,                                     H2_ACT_NONE,               "EVT_LOST_HPSB") \
+    X(2708, H2_RW_READ, H2_SRC_SLAVE_EVENT,    8,                                     H2_ACT_NONE,               "EVT_LOST_LPSB1") \
+    X(2709, H2_RW_READ, H2_SRC_SLAVE_EVENT,    9,                                     H2_ACT_NONE,               "EVT_LOST_LPSB2") \
+    X(2710, H2_RW_READ, H2_SRC_SLAVE_EVENT,    10,                                    H2_ACT_NONE,               "EVT_LOST_LPSB3") \
+    /* 4x2800~2806 : timed outputs (timed_io.h), figures of the channel selected by 4x2800 */ \
+    X(2800, H2_RW_WRITE, H2_SRC_TIMED_IO_SELECT, 0,                                    H2_ACT_TIMED_IO_SELECT,    "TIO_SELECT") \
+    X(2801, H2_RW_READ, H2_SRC_TIMED_IO,       1,                                     H2_ACT_NONE,               "TIO_CH_COUNT") \
+    X(2802, H2_RW_READ, H2_SRC_TIMED_IO,       2,                                     H2_ACT_NONE,               "TIO_STEPS_HI") \
+    X(2803, H2_RW_READ, H2_SRC_TIMED_IO,       3,                                     H2_ACT_NONE,               "TIO_STEPS_LO") \
+    X(2804, H2_RW_READ, H2_SRC_TIMED_IO,       4,                                     H2_ACT_NONE,               "TIO_FAILED") \
+    X(2805, H2_RW_READ, H2_SRC_TIMED_IO,       5,                                     H2_ACT_NONE,               "TIO_LAST_LATE_MS") \
+    X(2806, H2_RW_READ, H2_SRC_TIMED_IO,       6,                                     H2_ACT_NONE,               "TIO_MAX_LATE_MS") \
+    /* 4x2900~2919 : remote coil transactions (remote_output.h), histogram of the stage selected by 4x2900 */ \
+    X(2900, H2_RW_WRITE, H2_SRC_REMOTE_OUT_SELECT, 0,                                  H2_ACT_REMOTE_OUT_SELECT,  "RO_SELECT") \
+    X(2901, H2_RW_WRITE, H2_SRC_REMOTE_OUT,     1,                                     H2_ACT_REMOTE_OUT_CLEAR,   "RO_REQUESTS") \
+    X(2902, H2_RW_READ, H2_SRC_REMOTE_OUT,     2,                                     H2_ACT_NONE,               "RO_COALESCED") \
+    X(2903, H2_RW_READ, H2_SRC_REMOTE_OUT,     3,                                     H2_ACT_NONE,               "RO_WRITES") \
+    X(2904, H2_RW_READ, H2_SRC_REMOTE_OUT,     4,                                     H2_ACT_NONE,               "RO_FAILED") \
+    X(2905, H2_RW_READ, H2_SRC_REMOTE_OUT,     5,                                     H2_ACT_NONE,               "RO_MISMATCH") \
+    X(2906, H2_RW_READ, H2_SRC_REMOTE_OUT,     6,                                     H2_ACT_NONE,               "RO_UNCONFIRMED") \
+    X(2907, H2_RW_READ, H2_SRC_REMOTE_OUT,     7,                                     H2_ACT_NONE,               "RO_HIST_MAX_MS") \
+    X(2908, H2_RW_READ, H2_SRC_REMOTE_OUT,     8,                                     H2_ACT_NONE,               "RO_HIST_0") \
+    X(2909, H2_RW_READ, H2_SRC_REMOTE_OUT,     9,                                     H2_ACT_NONE,               "RO_HIST_1") \
+    X(2910, H2_RW_READ, H2_SRC_REMOTE_OUT,     10,                                    H2_ACT_NONE,               "RO_HIST_2") \
+    X(2911, H2_RW_READ, H2_SRC_REMOTE_OUT,     11,                                    H2_ACT_NONE,               "RO_HIST_3") \
+    X(2912, H2_RW_READ, H2_SRC_REMOTE_OUT,     12,                                    H2_ACT_NONE,               "RO_HIST_4") \
+    X(2913, H2_RW_READ, H2_SRC_REMOTE_OUT,     13,                                    H2_ACT_NONE,               "RO_HIST_5") \
+    X(2914, H2_RW_READ, H2_SRC_REMOTE_OUT,     14,                                    H2_ACT_NONE,               "RO_HIST_6") \
+    X(2915, H2_RW_READ, H2_SRC_REMOTE_OUT,     15,                                    H2_ACT_NONE,               "RO_HIST_7") \
+    X(2916, H2_RW_READ, H2_SRC_REMOTE_OUT,     16,                                    H2_ACT_NONE,               "RO_HIST_8") \
+    X(2917, H2_RW_READ, H2_SRC_REMOTE_OUT,     17,                                    H2_ACT_NONE,               "RO_HIST_9") \
+    X(2918, H2_RW_READ, H2_SRC_REMOTE_OUT,     18,                                    H2_ACT_NONE,               "RO_HIST_10") \
+    X(2919, H2_RW_READ, H2_SRC_REMOTE_OUT,     19,                                    H2_ACT_NONE,               "RO_HIST_11") \
+    /* 4x2950~2956 : scheduler tasks (app_scheduler.h), figures of the task selected by 4x2950 */ \
+    X(2950, H2_RW_WRITE, H2_SRC_SCHED_SELECT,   0,                                     H2_ACT_SCHED_SELECT,       "SCHED_SELECT") \
+    X(2951, H2_RW_READ, H2_SRC_SCHED,          1,                                     H2_ACT_NONE,               "SCHED_TASK_COUNT") \
+    X(2952, H2_RW_READ, H2_SRC_SCHED,          2,                                     H2_ACT_NONE,               "SCHED_RUNS_HI") \
+    X(2953, H2_RW_READ, H2_SRC_SCHED,          3,                                     H2_ACT_NONE,               "SCHED_RUNS_LO") \
+    X(2954, H2_RW_READ, H2_SRC_SCHED,          4,                                     H2_ACT_NONE,               "SCHED_MISSED") \
+    X(2955, H2_RW_READ, H2_SRC_SCHED,          5,                                     H2_ACT_NONE,               "SCHED_TRIGGERED") \
+    X(2956, H2_RW_READ, H2_SRC_SCHED,          6,                                     H2_ACT_NONE,               "SCHED_MAX_LATE_MS")
+
+#define H2_MAP_3X(X) \
+    /* 3x3000~3005 : environment, MAIN IO, summary flags */ \
+    X(3000, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(env_temp_cx10),                H2_ACT_NONE,               "ENV_TEMP_CX10") \
+    X(3001, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(env_rh_x10),                   H2_ACT_NONE,               "ENV_RH_X10") \
+    X(3002, H2_RW_READ, H2_SRC_MAIN_DI,        0,                                     H2_ACT_NONE,               "MAIN_DI") \
+    X(3003, H2_RW_READ, H2_SRC_MAIN_DO,        0,                                     H2_ACT_NONE,               "MAIN_DO") \
+    X(3004, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(error_flags),                  H2_ACT_NONE,               "ERROR_FLAGS") \
+    X(3005, H2_RW_READ, H2_SRC_AGG_U8,         AGG_OFF(stale_mask),                   H2_ACT_NONE,               "STALE_MASK") \
+    /* 3x3006~3012 : HPSB coils, discrete, status, alarm, currents */ \
+    X(3006, H2_RW_READ, H2_SRC_AGG_U8,         AGG_OFF(hpsb_coils),                   H2_ACT_NONE,               "HPSB_COILS") \
+    X(3007, H2_RW_READ, H2_SRC_AGG_U8,         AGG_OFF(hpsb_discrete),                H2_ACT_NONE,               "HPSB_DISCRETE") \
+    X(3008, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(hpsb_status_reg),              H2_ACT_NONE,               "HPSB_STATUS") \
+    X(3009, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(hpsb_alarm_reg),               H2_ACT_NONE,               "HPSB_ALARM") \
+    X(3010, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(hpsb_sense_raw[0]),            H2_ACT_NONE,               "HPSB_CUR_1") \
+    X(3011, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(hpsb_sense_raw[1]),            H2_ACT_NONE,               "HPSB_CUR_2") \
+    X(3012, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(hpsb_sense_raw[2]),            H2_ACT_NONE,               "HPSB_CUR_3") \
+    /* 3x3013~3027 : LPSB1~3, 5 each: coils, alarm, currents */ \
+    X(3013, H2_RW_READ, H2_SRC_LPSB_COILS,     0,                                     H2_ACT_NONE,               "LPSB1_COILS") \
+    X(3014, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_alarm_reg[0]),            H2_ACT_NONE,               "LPSB1_ALARM") \
+    X(3015, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_sense_raw[0][0]),         H2_ACT_NONE,               "LPSB1_CUR_1") \
+    X(3016, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_sense_raw[0][1]),         H2_ACT_NONE,               "LPSB1_CUR_2") \
+    X(3017, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_sense_raw[0][2]),         H2_ACT_NONE,               "LPSB1_CUR_3") \
+    X(3018, H2_RW_READ, H2_SRC_LPSB_COILS,     1,                                     H2_ACT_NONE,               "LPSB2_COILS") \
+    X(3019, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_alarm_reg[1]),            H2_ACT_NONE,               "LPSB2_ALARM") \
+    X(3020, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_sense_raw[1][0]),         H2_ACT_NONE,               "LPSB2_CUR_1") \
+    X(3021, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_sense_raw[1][1]),         H2_ACT_NONE,               "LPSB2_CUR_2") \
+    X(3022, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_sense_raw[1][2]),         H2_ACT_NONE,               "LPSB2_CUR_3") \
+    X(3023, H2_RW_READ, H2_SRC_LPSB_COILS,     2,                                     H2_ACT_NONE,               "LPSB3_COILS") \
+    X(3024, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_alarm_reg[2]),            H2_ACT_NONE,               "LPSB3_ALARM") \
+    X(3025, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_sense_raw[2][0]),         H2_ACT_NONE,               "LPSB3_CUR_1") \
+    X(3026, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_sense_raw[2][1]),         H2_ACT_NONE,               "LPSB3_CUR_2") \
+    X(3027, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(lpsb_sense_raw[2][2]),         H2_ACT_NONE,               "LPSB3_CUR_3") \
+    /* 3x3028~3043 : downstream link statistics, 3028 + board * 4 + stat */ \
+    X(3028, H2_RW_READ, H2_SRC_LINK_STAT,      H2_LINK_ARG(0, H2_LINK_OK),            H2_ACT_NONE,               "LINK_HPSB_OK") \
+    X(3029, H2_RW_READ, H2_SRC_LINK_STAT,      H2_LINK_ARG(0, H2_LINK_TIMEOUT),       H2_ACT_NONE,               "LINK_HPSB_TIMEOUT") \
+    X(3030, H2_RW_READ, H2_SRC_LINK_STAT,      H2_LINK_ARG(0, H2_LINK_BAD_FRAME),     H2_ACT_NONE,               "LINK_HPSB_BAD_FRAME") \
+    X(3031, H2_RW_READ, H2_SRC_LINK_STAT,      H2_LINK_ARG(0, H2_LINK_EXCEPTION),     H2_ACT_NONE,               "LINK_HPSB_EXCEPTION") \
+    X(3032, H2_RW_READ, H2_SRC_LINK_STAT,      H2_LINK_ARG(1, H2_LINK_OK),            H2_ACT_NONE,               "LINK_LPSB1_OK") \
+    X(3033, H2_RW_READ, H2_SRC_LINK_STAT,      H2_LINK_ARG(1, H2_LINK_TIMEOUT),       H2_ACT_NONE,               "LINK_LPSB1_TIMEOUT") \
+    X(3034, H2_RW_READ, H2_SRC_LINK_STAT,      H2_LINK_ARG(1, H2_LINK_BAD_FRAME),     H2_ACT_NONE,               "LINK_LPSB1_BAD_FRAME") \
+    X(3035, H2_RW_READ, H2_SRC_LINK_STAT,      H2_LINK_ARG(1, H2_LINK_EXCEPTION),     H2_ACT_NONE,               "LINK_LPSB1_EXCEPTION") \
+    X(3036, H2_RW_READ, H2_SRC_LINK_STAT,      H2_LINK_ARG(2, H2_LINK_OK),            H2_ACT_NONE,               "LINK_LPSB2_OK") \
+    X(3037, H2_RW_READ, H2_SRC_LINK_STAT,      H2_LINK_ARG(2, H2_LINK_TIMEOUT),       H2_ACT_NONE,               "LINK_LPSB2_TIMEOUT") \
+    X(3038, H2_RW_READ, H2_SRC_LINK_STAT,      H2_LINK_ARG(2, H2_LINK_BAD_FRAME),     H2_ACT_NONE,               "LINK_LPSB2_BAD_FRAME") \
+    X(3039, H2_RW_READ, H2_SRC_LINK_STAT,      H2_LINK_ARG(2, H2_LINK_EXCEPTION),     H2_ACT_NONE,               "LINK_LPSB2_EXCEPTION") \
+    X(3040, H2_RW_READ, H2_SRC_LINK_STAT,      H2_LINK_ARG(3, H2_LINK_OK),            H2_ACT_NONE,               "LINK_LPSB3_OK") \
+    X(3041, H2_RW_READ, H2_SRC_LINK_STAT,      H2_LINK_ARG(3, H2_LINK_TIMEOUT),       H2_ACT_NONE,               "LINK_LPSB3_TIMEOUT") \
+    X(3042, H2_RW_READ, H2_SRC_LINK_STAT,      H2_LINK_ARG(3, H2_LINK_BAD_FRAME),     H2_ACT_NONE,               "LINK_LPSB3_BAD_FRAME") \
+    X(3043, H2_RW_READ, H2_SRC_LINK_STAT,      H2_LINK_ARG(3, H2_LINK_EXCEPTION),     H2_ACT_NONE,               "LINK_LPSB3_EXCEPTION") \
+    /* 3x3044 : aggregator diagnostics */ \
+    X(3044, H2_RW_READ, H2_SRC_AGG_U16,        AGG_OFF(torn_snapshots),               H2_ACT_NONE,               "TORN_SNAPSHOTS")
+
+/* Runs of consecutive addresses per area: R(first, last) */
+#define H2_RUNS_1X(R) \
+    R(821, 836) \
+    R(853, 860) \
+    R(869, 880) \
+    R(885, 898)
+
+#define H2_RUNS_4X(R) \
+    R(2000, 2013) \
+    R(2100, 2101) \
+    R(2200, 2206) \
+    R(2300, 2315) \
+    R(2400, 2400) \
+    R(2500, 2519) \
+    R(2600, 2616) \
+    R(2700, 2710) \
+    R(2800, 2806) \
+    R(2900, 2919) \
+    R(2950, 2956)
+
+#define H2_RUNS_3X(R) \
+    R(3000, 3044)
+
+#define H2_1X_DEC_MIN   821u
+#define H2_1X_DEC_MAX   898u
+#define H2_4X_DEC_MIN   2000u
+#define H2_4X_DEC_MAX   2956u
+#define H2_3X_DEC_MIN   3000u
+#define H2_3X_DEC_MAX   3044u
+#define H2_SPAN(_a)     (H2_##_a##_DEC_MAX - H2_##_a##_DEC_MIN + 1u)
+
+_Static_assert(SLAVE_LPSB_MAPPED_COUNT == 3u && SLAVE_LPSB_PORT_COUNT == 3u &&
+               AGG_AGE_SLAVE_COUNT * SLAVE_AREA_COUNT == 16u, "H2_MAP_4X/3X rows assume 3 LPSB x 3 ports");
+
+#define H2E(_area, _dec, _rw, _src, _agg_bit, _arg, _act, _label) \
+    { .h2_dec=(_dec), .area=(_area), .rw=(_rw), .src=(_src), .agg_bit_index=(_agg_bit), .arg=(uint16_t)(_arg), \
+      .action=(_act), .name=(_label) }
+
+#define H2_ROW_1X(_dec, _rw, _src, _agg_bit, _act, _label) H2E(H2_AREA_1X, _dec, _rw, _src, _agg_bit, 0, _act, _label),
+#define H2_ROW_4X(_dec, _rw, _src, _arg, _act, _label)     H2E(H2_AREA_4X, _dec, _rw, _src, 0, _arg, _act, _label),
+#define H2_ROW_3X(_dec, _rw, _src, _arg, _act, _label)     H2E(H2_AREA_3X, _dec, _rw, _src, 0, _arg, _act, _label),
+static const H2_MapEntry_t g_map[] = { H2_MAP_1X(H2_ROW_1X) H2_MAP_4X(H2_ROW_4X) H2_MAP_3X(H2_ROW_3X) };
+
+/* Position of each row in g_map; an address listed twice fails here (H2_IDX_<dec> redefined) */
+#define H2_IDX(_dec, ...) H2_IDX_##_dec,
+enum { H2_MAP_1X(H2_IDX) H2_MAP_4X(H2_IDX) H2_MAP_3X(H2_IDX) H2_MAP_COUNT };
+
+/* Dense index per area over its DEC_MIN..MAX: g_map position + 1, 0 = not mapped */
+#define H2_DENSE(_min, _dec)    [(_dec) - (_min)] = (uint8_t)(H2_IDX_##_dec + 1),
+#define H2_DENSE_1X(_dec, ...)  H2_DENSE(H2_1X_DEC_MIN, _dec)
+#define H2_DENSE_4X(_dec, ...)  H2_DENSE(H2_4X_DEC_MIN, _dec)
+#define H2_DENSE_3X(_dec, ...)  H2_DENSE(H2_3X_DEC_MIN, _dec)
+static const uint8_t g_index_1x[H2_SPAN(1X)] = { H2_MAP_1X(H2_DENSE_1X) };
+static const uint8_t g_index_4x[H2_SPAN(4X)] = { H2_MAP_4X(H2_DENSE_4X) };
+static const uint8_t g_index_3x[H2_SPAN(3X)] = { H2_MAP_3X(H2_DENSE_3X) };
+
+/* Per address: offset of the last address of its run, so a whole request range is one compare */
+#define H2_RUN_END(_min, _first, _last) [(_first) - (_min) ... (_last) - (_min)] = (uint16_t)((_last) - (_min)),
+#define H2_RUN_END_1X(_first, _last)    H2_RUN_END(H2_1X_DEC_MIN, _first, _last)
+#define H2_RUN_END_4X(_first, _last)    H2_RUN_END(H2_4X_DEC_MIN, _first, _last)
+#define H2_RUN_END_3X(_first, _last)    H2_RUN_END(H2_3X_DEC_MIN, _first, _last)
+static const uint16_t g_run_end_1x[H2_SPAN(1X)] = { H2_RUNS_1X(H2_RUN_END_1X) };
+static const uint16_t g_run_end_4x[H2_SPAN(4X)] = { H2_RUNS_4X(H2_RUN_END_4X) };
+static const uint16_t g_run_end_3x[H2_SPAN(3X)] = { H2_RUNS_3X(H2_RUN_END_3X) };
+
+/* Rows are ascending, so a run is gap-free iff its positions are as far apart as its addresses,
+ * and the runs cover the lists iff their lengths add up to H2_MAP_COUNT */
+#define H2_RUN_CHECK(_first, _last) \
+    _Static_assert(H2_IDX_##_last - H2_IDX_##_first == (_last) - (_first), "H2 map run " #_first "~" #_last " has a gap");
+H2_RUNS_1X(H2_RUN_CHECK)
+H2_RUNS_4X(H2_RUN_CHECK)
+H2_RUNS_3X(H2_RUN_CHECK)
+#define H2_RUN_LEN(_first, _last) + ((_last) - (_first) + 1)
+_Static_assert(0 H2_RUNS_1X(H2_RUN_LEN) H2_RUNS_4X(H2_RUN_LEN) H2_RUNS_3X(H2_RUN_LEN) == H2_MAP_COUNT,
+               "H2_RUNS_* do not cover the H2_MAP_* rows");
+_Static_assert(H2_IDX_821 == 0 && H2_IDX_898 + 1 == H2_IDX_2000 && H2_IDX_2956 + 1 == H2_IDX_3000 &&
+               H2_IDX_3044 == H2_MAP_COUNT - 1, "H2_*_DEC_MIN/MAX out of step with the row lists");
+_Static_assert(H2_MAP_COUNT < 0xFF, "index entries are uint8_t");
+
+typedef struct {
+    const uint8_t*  index;
+    const uint16_t* run_end;
+    uint16_t        min;
+    uint16_t        max;
+} H2_AreaIndex_t;
+
+static const H2_AreaIndex_t g_areas[] = {
+    [H2_AREA_1X] = { g_index_1x, g_run_end_1x, H2_1X_DEC_MIN, H2_1X_DEC_MAX },
+    [H2_AREA_0X] = { NULL, NULL, 0, 0 },
+    [H2_AREA_3X] = { g_index_3x, g_run_end_3x, H2_3X_DEC_MIN, H2_3X_DEC_MAX },
+    [H2_AREA_4X] = { g_index_4x, g_run_end_4x, H2_4X_DEC_MIN, H2_4X_DEC_MAX },
 };
 
+static inline const H2_AreaIndex_t* area_index(H2_Area_t area) {
+    if ((unsigned)area >= sizeof(g_areas) / sizeof(g_areas[0]) || !g_areas[area].index) return NULL;
+    return &g_areas[area];
+}
+
 const H2_MapEntry_t* H2Map_FindByDec(H2_Area_t area, uint16_t h2_dec) {
-    for (unsigned i = 0; i < (sizeof(g_map) / sizeof(g_map[0])); i++) {
-        if (g_map[i].area == area && g_map[i].h2_dec == h2_dec) {
-            return &g_map[i];
+    const H2_AreaIndex_t* a = area_index(area);
+    if (!a || h2_dec < a->min || h2_dec > a->max) return NULL;
+    uint8_t pos = a->index[h2_dec - a->min];
+    return pos ? &g_map[pos - 1u] : NULL;
+}
+
+const H2_MapEntry_t* H2Map_FindRun(H2_Area_t area, uint16_t h2_dec, uint16_t count) {
+    const H2_MapEntry_t* e = H2Map_FindByDec(area, h2_dec);
+    if (!e) return NULL;
+    const H2_AreaIndex_t* a = &g_areas[area];
+    if ((uint32_t)h2_dec + count - 1u > a->min + (uint32_t)a->run_end[h2_dec - a->min]) return NULL;
+    return e;
+}
+
+bool H2Map_ReadSpanBits(H2_Area_t area, uint16_t h2_dec, uint16_t count, uint8_t* out) {
+    if (area != H2_AREA_1X || count == 0 || h2_dec < H2_1X_DEC_MIN ||
+        (uint32_t)h2_dec + count - 1u > H2_1X_DEC_MAX) return false;
+    uint16_t i = 0;
+    while (i < count) {
+        uint16_t off = (uint16_t)(h2_dec + i - H2_1X_DEC_MIN);
+        uint8_t  pos = g_index_1x[off];
+        if (!pos) {                     /* gap */
+            bit_set((volatile uint8_t*)out, i, false);
+            i++;
+            continue;
         }
+        uint16_t n = (uint16_t)(g_run_end_1x[off] - off + 1u);
+        if (n > count - i) n = (uint16_t)(count - i);
+        H2Map_ReadRunBits(&g_map[pos - 1u], n, out, i);
+        i = (uint16_t)(i + n);
+    }
+    return true;
+}
+
+void H2Map_ReadRunBits(const H2_MapEntry_t* e, uint16_t count, uint8_t* out, uint16_t out_bit) {
+    uint16_t i = 0;
+    while (i < count) {
+        if (e[i].src != H2_SRC_AGG_BIT || e[i].agg_bit_index >= AGG_BIT_COUNT) {
+            bit_set((volatile uint8_t*)out, (uint16_t)(out_bit + i), false);
+            i++;
+            continue;
+        }
+        uint16_t agg = e[i].agg_bit_index;
+        uint16_t n = 1;
+        while (i + n < count && e[i + n].src == H2_SRC_AGG_BIT && e[i + n].agg_bit_index == agg + n &&
+               agg + n < AGG_BIT_COUNT)
+            n++;
+        copy_bits(out, (uint16_t)(out_bit + i), g_agg_bits, agg, n);
+        i = (uint16_t)(i + n);
     }
-    return NULL;
 }
 
 __attribute__((weak)) void Gateway_Action_PulseMainDoor1(uint16_t pulse_ms) { (void)pulse_ms; }
@@ -112,9 +475,21 @@ __attribute__((weak)) void Gateway_Action_PulseOutputByOnOffIndex(uint8_t onoff_
     (void)onoff_index_1based; (void)pulse_ms;
 }
 
+bool H2Map_CanApplyWrite(const H2_MapEntry_t* e) {
+    if (!e || e->rw != H2_RW_WRITE) return false;
+    switch (e->action) {
+    case H2_ACT_PULSE_MAIN_DOOR1:
+    case H2_ACT_PULSE_MAIN_DOOR2:
+        return true;
+    case H2_ACT_PULSE_OUTPUT:
+        return e->h2_dec >= 892 && e->h2_dec <= 896;
+    default:
+        return false;
+    }
+}
+
 bool H2Map_ApplyWrite(const H2_MapEntry_t* e, bool value, uint16_t pulse_ms) {
-    if (!e) return false;
-    if (e->rw != H2_RW_WRITE) return false;
+    if (!H2Map_CanApplyWrite(e)) return false;
     if (!value) return true;
 
     switch (e->action) {
@@ -125,12 +500,8 @@ bool H2Map_ApplyWrite(const H2_MapEntry_t* e, bool value, uint16_t pulse_ms) {
         Gateway_Action_PulseMainDoor2(pulse_ms);
         return true;
     case H2_ACT_PULSE_OUTPUT:
-        if (e->h2_dec >= 892 && e->h2_dec <= 896) {
-            uint8_t onoff_index = (uint8_t)(e->h2_dec - 884);
-            Gateway_Action_PulseOutputByOnOffIndex(onoff_index, pulse_ms);
-            return true;
-        }
-        return false;
+        Gateway_Action_PulseOutputByOnOffIndex((uint8_t)(e->h2_dec - 884), pulse_ms);
+        return true;
     default:
         return false;
     }
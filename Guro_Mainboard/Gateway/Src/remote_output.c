@@ -0,0 +1,225 @@
+/**
+ * @file remote_output.c
+ * @brief MAIN board: LPSB coil transactions. Per coil: IDLE -> QUEUED (target differs from the
+ *        confirmed state) -> ON_BUS (FC05 job submitted) -> ECHOED (slave echoed it) -> confirmed
+ *        by the first coil poll stamped after the echo. Requests made while a write is out only
+ *        move the target; once it is confirmed the coil goes round again if the target differs.
+ */
+#include "remote_output.h"
+#include "gateway_actions.h"
+#include "modbus_master.h"
+#include "modbus_table.h"
+#include "main.h"
+#include <string.h>
+
+#define NIL     0xFFu
+
+typedef enum {
+    RC_IDLE = 0,
+    RC_QUEUED,
+    RC_ON_BUS,
+    RC_ECHOED
+} RemoteCoilPhase_t;
+
+typedef struct {
+    uint8_t  phase;
+    uint8_t  confirmed;         /* last state confirmed by a poll (or echo, when polls stop) */
+    uint8_t  target;
+    uint8_t  written;           /* value of the FC05 out or echoed */
+    uint8_t  next_req;          /* a request arrived after the write went out */
+    uint32_t t_req;             /* first request of the transaction */
+    uint32_t t_next_req;
+    uint32_t t_bus;
+    uint32_t t_echo;
+} RemoteCoil_t;
+
+static RemoteCoil_t coils[REMOTE_OUT_COUNT];
+static uint8_t job_coil = NIL;
+static RemoteOut_Stats_t stats;
+static RemoteOut_Hist_t hist[REMOTE_OUT_LAT_COUNT];
+
+static inline SlaveId_t coil_slave(uint8_t i)
+{
+    return SLAVE_ID_LPSB(i / SLAVE_LPSB_PORT_COUNT);
+}
+
+static inline uint16_t coil_bit(uint8_t i)
+{
+    return (uint16_t)(i % SLAVE_LPSB_PORT_COUNT);
+}
+
+static void hist_add(RemoteOut_Latency_t stage, uint32_t ms)
+{
+    RemoteOut_Hist_t *h = &hist[stage];
+    uint8_t b = 0;
+    while (b < REMOTE_OUT_HIST_BUCKETS - 1u && ms >= (1u << b)) b++;
+    if (h->bucket[b] != 0xFFFFu) h->bucket[b]++;
+    if (ms > 0xFFFFu) ms = 0xFFFFu;
+    if (ms > h->max_ms) h->max_ms = (uint16_t)ms;
+}
+
+static void job_done(int result, const uint16_t *regs, uint16_t num)
+{
+    (void)regs;
+    (void)num;
+    uint8_t i = job_coil;
+    job_coil = NIL;
+    if (i == NIL) return;
+    RemoteCoil_t *c = &coils[i];
+    uint32_t now = HAL_GetTick();
+    if (result != 0) {
+        /* Drop the transaction; the state stays what the last poll showed */
+        stats.failed++;
+        c->phase = RC_IDLE;
+        c->next_req = 0;
+        Gateway_Action_ReportDownstreamWriteFail();
+        return;
+    }
+    stats.writes++;
+    hist_add(REMOTE_OUT_LAT_ECHO, now - c->t_bus);
+    ModbusTable_SetCoil(coil_slave(i), coil_bit(i), c->written);
+    /* Confirmation needs a coil stamp newer than the one SetCoil just wrote; now was read before
+     * it and may be a tick behind */
+    SlaveSnapshot_t v;
+    c->t_echo = (ModbusTable_GetSnapshot(coil_slave(i), &v) == 0) ? v.stamp[SLAVE_AREA_COIL] : HAL_GetTick();
+    c->phase = RC_ECHOED;
+}
+
+/* Coil state from a poll completed after the echo: 0/1, or -1 if there has been none yet */
+static int polled_after_echo(uint8_t i, const RemoteCoil_t *c)
+{
+    SlaveSnapshot_t v;
+    if (ModbusTable_GetSnapshot(coil_slave(i), &v) != 0) return -1;
+    uint32_t stamp = v.stamp[SLAVE_AREA_COIL];
+    if (stamp == 0 || (int32_t)(stamp - c->t_echo) <= 0) return -1;
+    return (int)((v.head->coils >> coil_bit(i)) & 1u);
+}
+
+static void finish(RemoteCoil_t *c)
+{
+    if (c->next_req && c->target != c->confirmed) {
+        c->t_req = c->t_next_req;
+        c->phase = RC_QUEUED;
+    } else {
+        c->phase = RC_IDLE;
+    }
+    c->next_req = 0;
+}
+
+static void update_coil(uint8_t i, uint32_t now)
+{
+    RemoteCoil_t *c = &coils[i];
+    switch (c->phase) {
+    case RC_QUEUED:
+        if (c->target == c->confirmed) {
+            c->phase = RC_IDLE;         /* requests cancelled out before anything went out */
+            return;
+        }
+        if (job_coil != NIL) return;
+        {
+            PollEntry_t req = { coil_slave(i), POLL_ENTRY_WRITE_COIL, coil_bit(i), 1, c->target };
+            if (ModbusMaster_SubmitJob(&req, job_done) != 0) return;
+        }
+        job_coil = i;
+        c->written = c->target;
+        c->t_bus = now;
+        hist_add(REMOTE_OUT_LAT_QUEUE, now - c->t_req);
+        c->phase = RC_ON_BUS;
+        return;
+    case RC_ECHOED: {
+        int polled = polled_after_echo(i, c);
+        if (polled < 0) {
+            if (now - c->t_echo < REMOTE_OUT_CONFIRM_MS) return;
+            stats.unconfirmed++;
+            c->confirmed = c->written;
+            finish(c);
+            return;
+        }
+        hist_add(REMOTE_OUT_LAT_CONFIRM, now - c->t_echo);
+        hist_add(REMOTE_OUT_LAT_TOTAL, now - c->t_req);
+        if ((uint8_t)polled != c->written) stats.mismatch++;
+        c->confirmed = (uint8_t)polled;
+        finish(c);
+        return;
+    }
+    default:
+        return;
+    }
+}
+
+/* Open a transaction against the polled state, or fold the request into the open one */
+static int request(uint8_t n, uint8_t p, uint8_t toggle, uint8_t value)
+{
+    if (n >= SLAVE_LPSB_MAPPED_COUNT || p >= SLAVE_LPSB_PORT_COUNT) return -1;
+    uint8_t i = (uint8_t)(n * SLAVE_LPSB_PORT_COUNT + p);
+    RemoteCoil_t *c = &coils[i];
+    uint32_t now = HAL_GetTick();
+    stats.requests++;
+    if (c->phase == RC_IDLE) {
+        c->confirmed = ModbusTable_GetCoil(coil_slave(i), coil_bit(i));
+        c->target = toggle ? (uint8_t)!c->confirmed : value;
+        if (c->target == c->confirmed) return 0;
+        c->t_req = now;
+        c->phase = RC_QUEUED;
+        return 0;
+    }
+    stats.coalesced++;
+    c->target = toggle ? (uint8_t)!c->target : value;
+    if (c->phase != RC_QUEUED && !c->next_req) {
+        c->next_req = 1;
+        c->t_next_req = now;
+    }
+    return 0;
+}
+
+void RemoteOut_Init(void)
+{
+    memset(coils, 0, sizeof(coils));
+    job_coil = NIL;
+    RemoteOut_ClearMetrics();
+}
+
+void RemoteOut_Update(void)
+{
+    uint32_t now = HAL_GetTick();
+    for (uint8_t i = 0; i < REMOTE_OUT_COUNT; i++)
+        update_coil(i, now);
+}
+
+int RemoteOut_Toggle(uint8_t n, uint8_t p)
+{
+    return request(n, p, 1, 0);
+}
+
+int RemoteOut_Set(uint8_t n, uint8_t p, uint8_t value)
+{
+    return request(n, p, 0, value ? 1u : 0u);
+}
+
+uint8_t RemoteOut_IsBusy(uint8_t n, uint8_t p)
+{
+    if (n >= SLAVE_LPSB_MAPPED_COUNT || p >= SLAVE_LPSB_PORT_COUNT) return 0;
+    return (coils[n * SLAVE_LPSB_PORT_COUNT + p].phase != RC_IDLE) ? 1 : 0;
+}
+
+uint8_t RemoteOut_GetState(uint8_t n, uint8_t p)
+{
+    if (n >= SLAVE_LPSB_MAPPED_COUNT || p >= SLAVE_LPSB_PORT_COUNT) return 0;
+    return coils[n * SLAVE_LPSB_PORT_COUNT + p].confirmed;
+}
+
+void RemoteOut_GetStats(RemoteOut_Stats_t *out)
+{
+    if (out) *out = stats;
+}
+
+void RemoteOut_GetHistogram(RemoteOut_Latency_t stage, RemoteOut_Hist_t *out)
+{
+    if (out && stage < REMOTE_OUT_LAT_COUNT) *out = hist[stage];
+}
+
+void RemoteOut_ClearMetrics(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    memset(hist, 0, sizeof(hist));
+}
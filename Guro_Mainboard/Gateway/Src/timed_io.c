@@ -0,0 +1,240 @@
+/**
+ * @file timed_io.c
+ * @brief MAIN board: timed outputs on a hashed timer wheel. A channel waiting for its next step is
+ *        linked into slot (due % TIMED_IO_WHEEL_SLOTS); each Tick visits the slots for the
+ *        milliseconds elapsed since the last one and fires the entries that are due, so arming,
+ *        cancelling and expiring are O(1). Later steps are timed from the previous step's due tick,
+ *        not from when it fired, so a late tick does not stretch a sequence. A remote step that
+ *        RemoteOut cannot take yet is counted as failed once and retried on the next tick.
+ */
+#include "timed_io.h"
+#include "remote_output.h"
+#include "main.h"
+#include <string.h>
+
+#define NIL                 0xFFu
+#define SLOT_MASK           (TIMED_IO_WHEEL_SLOTS - 1u)
+
+_Static_assert((TIMED_IO_WHEEL_SLOTS & SLOT_MASK) == 0u, "TIMED_IO_WHEEL_SLOTS must be a power of 2");
+_Static_assert(TIMED_IO_CH_COUNT < NIL, "channel index is uint8_t with NIL");
+
+typedef struct {
+    const TimedIO_Step_t *steps;
+    TimedIO_Step_t own[2];      /* steps of Pulse / SetAfter */
+    uint8_t  n;
+    uint8_t  idx;               /* step that fires at due */
+    uint8_t  armed;
+    uint8_t  next;
+    uint8_t  prev;
+    uint8_t  awaiting;          /* remote write handed to RemoteOut, not yet settled */
+    uint8_t  awaiting_value;
+    uint8_t  retrying;          /* step idx was refused by RemoteOut and is being retried */
+    uint32_t due;               /* tick the step is due at */
+    uint32_t slot_tick;         /* tick whose wheel slot holds the channel */
+    TimedIO_Stats_t stats;
+} Channel_t;
+
+static Channel_t chans[TIMED_IO_CH_COUNT];
+static uint8_t slot_head[TIMED_IO_WHEEL_SLOTS];
+static uint32_t wheel_time;             /* last tick serviced */
+
+static inline uint8_t is_remote(uint8_t ch)
+{
+    return (ch >= MAIN_DO_COUNT) ? 1 : 0;
+}
+
+static void unlink_ch(uint8_t ch)
+{
+    Channel_t *c = &chans[ch];
+    if (!c->armed) return;
+    if (c->prev != NIL) chans[c->prev].next = c->next;
+    else slot_head[c->slot_tick & SLOT_MASK] = c->next;
+    if (c->next != NIL) chans[c->next].prev = c->prev;
+    c->armed = 0;
+}
+
+/* Link ch at due. An overdue entry keeps its due (for the lateness figure) but goes in the next
+ * slot to be visited, which its own slot might not be for a whole lap. */
+static void link_ch(uint8_t ch, uint32_t due, uint32_t now)
+{
+    Channel_t *c = &chans[ch];
+    c->due = due;
+    c->slot_tick = ((int32_t)(due - now) <= 0) ? now + 1u : due;
+    uint8_t s = (uint8_t)(c->slot_tick & SLOT_MASK);
+    c->prev = NIL;
+    c->next = slot_head[s];
+    if (c->next != NIL) chans[c->next].prev = ch;
+    slot_head[s] = ch;
+    c->armed = 1;
+}
+
+static void record(Channel_t *c, uint32_t due, uint32_t now)
+{
+    uint32_t late = now - due;
+    if ((int32_t)late < 0) late = 0;
+    if (late > 0xFFFFu) late = 0xFFFFu;
+    c->stats.steps++;
+    c->stats.last_late_ms = (uint16_t)late;
+    if (late > c->stats.max_late_ms) c->stats.max_late_ms = (uint16_t)late;
+}
+
+/* Settle the remote writes whose transaction has closed: the coil must have been confirmed at the
+ * last value written. A write folded into a later one is judged by that one. */
+static void check_remote(void)
+{
+    for (uint8_t ch = MAIN_DO_COUNT; ch < TIMED_IO_CH_COUNT; ch++) {
+        Channel_t *c = &chans[ch];
+        if (!c->awaiting) continue;
+        uint8_t rel = (uint8_t)(ch - MAIN_DO_COUNT);
+        uint8_t n = (uint8_t)(rel / SLAVE_LPSB_PORT_COUNT), p = (uint8_t)(rel % SLAVE_LPSB_PORT_COUNT);
+        if (RemoteOut_IsBusy(n, p)) continue;
+        c->awaiting = 0;
+        if (RemoteOut_GetState(n, p) != c->awaiting_value) c->stats.failed++;
+    }
+}
+
+/* 0, or -1 when RemoteOut could not take the write (the step is to be retried) */
+static int write_output(uint8_t ch, uint8_t value, uint32_t due, uint32_t now)
+{
+    Channel_t *c = &chans[ch];
+    if (value == TIMED_IO_KEEP) return 0;
+    if (!is_remote(ch)) {
+        IO_Main_WriteDO((MainDoChannel_t)ch, value ? 1u : 0u);
+        record(c, due, now);
+        return 0;
+    }
+    /* RemoteOut folds a newer value into a transaction still open on the coil */
+    uint8_t rel = (uint8_t)(ch - MAIN_DO_COUNT);
+    value = value ? 1u : 0u;
+    if (RemoteOut_Set((uint8_t)(rel / SLAVE_LPSB_PORT_COUNT), (uint8_t)(rel % SLAVE_LPSB_PORT_COUNT), value) != 0) {
+        if (!c->retrying) c->stats.failed++;
+        c->retrying = 1;
+        return -1;
+    }
+    c->retrying = 0;
+    c->awaiting = 1;
+    c->awaiting_value = value;
+    record(c, due, now);
+    return 0;
+}
+
+/* Fire step idx (due at due) and any zero-hold steps after it, then arm for the next one */
+static void run_steps(uint8_t ch, uint32_t due, uint32_t now)
+{
+    Channel_t *c = &chans[ch];
+    while (c->idx < c->n) {
+        const TimedIO_Step_t *s = &c->steps[c->idx];
+        if (write_output(ch, s->value, due, now) != 0) {
+            /* Same step, same due: lateness keeps counting from the original due tick */
+            link_ch(ch, due, now);
+            return;
+        }
+        c->idx++;
+        if (c->idx >= c->n) return;
+        if (s->hold_ms) {
+            link_ch(ch, due + s->hold_ms, now);
+            return;
+        }
+    }
+}
+
+static int start(uint8_t ch, const TimedIO_Step_t *steps, uint8_t n)
+{
+    uint32_t now = HAL_GetTick();
+    Channel_t *c = &chans[ch];
+    unlink_ch(ch);
+    c->steps = steps;
+    c->n = n;
+    c->idx = 0;
+    c->retrying = 0;
+    run_steps(ch, now, now);
+    return 0;
+}
+
+void TimedIO_Init(void)
+{
+    memset(chans, 0, sizeof(chans));
+    memset(slot_head, NIL, sizeof(slot_head));
+    wheel_time = HAL_GetTick();
+}
+
+void TimedIO_Tick(void)
+{
+    uint32_t now = HAL_GetTick();
+    uint32_t elapsed = now - wheel_time;
+    if (elapsed) {
+        /* After a stall longer than a lap, one pass over every slot catches everything up */
+        if (elapsed > TIMED_IO_WHEEL_SLOTS) elapsed = TIMED_IO_WHEEL_SLOTS;
+        for (uint32_t t = now - elapsed + 1u; t != now + 1u; t++) {
+            uint8_t ch = slot_head[t & SLOT_MASK];
+            while (ch != NIL) {
+                uint8_t next = chans[ch].next;
+                if ((int32_t)(now - chans[ch].due) >= 0) {
+                    uint32_t due = chans[ch].due;
+                    unlink_ch(ch);
+                    run_steps(ch, due, now);
+                }
+                ch = next;
+            }
+        }
+        wheel_time = now;
+    }
+    check_remote();
+}
+
+int TimedIO_Pulse(uint8_t ch, uint16_t ms, TimedIO_Mode_t mode)
+{
+    if (ch >= TIMED_IO_CH_COUNT || ms == 0) return -1;
+    Channel_t *c = &chans[ch];
+    if (c->armed) {
+        if (mode == TIMED_IO_IGNORE) return -1;
+        /* Extend only the on-phase of a pulse; anything else restarts */
+        if (mode == TIMED_IO_EXTEND && c->steps == c->own && c->n == 2u && c->own[0].value == 1u
+            && c->idx == 1u && !c->retrying) {
+            uint32_t due = c->due + ms;
+            unlink_ch(ch);
+            link_ch(ch, due, HAL_GetTick());
+            return 0;
+        }
+    }
+    c->own[0].value = 1;
+    c->own[0].hold_ms = ms;
+    c->own[1].value = 0;
+    c->own[1].hold_ms = 0;
+    return start(ch, c->own, 2);
+}
+
+int TimedIO_SetAfter(uint8_t ch, uint8_t value, uint16_t ms)
+{
+    if (ch >= TIMED_IO_CH_COUNT) return -1;
+    Channel_t *c = &chans[ch];
+    c->own[0].value = TIMED_IO_KEEP;
+    c->own[0].hold_ms = ms;
+    c->own[1].value = value;
+    c->own[1].hold_ms = 0;
+    return start(ch, c->own, 2);
+}
+
+int TimedIO_Sequence(uint8_t ch, const TimedIO_Step_t *steps, uint8_t n)
+{
+    if (ch >= TIMED_IO_CH_COUNT || steps == NULL || n == 0) return -1;
+    return start(ch, steps, n);
+}
+
+void TimedIO_Cancel(uint8_t ch)
+{
+    if (ch >= TIMED_IO_CH_COUNT) return;
+    unlink_ch(ch);
+    chans[ch].n = 0;
+}
+
+uint8_t TimedIO_IsActive(uint8_t ch)
+{
+    return (ch < TIMED_IO_CH_COUNT) ? chans[ch].armed : 0;
+}
+
+void TimedIO_GetStats(uint8_t ch, TimedIO_Stats_t *out)
+{
+    if (ch >= TIMED_IO_CH_COUNT || out == NULL) return;
+    *out = chans[ch].stats;
+}
@@ -0,0 +1,207 @@
+/**
+ * @file upstream_cmd.c
+ * @brief MAIN board: bounded FIFO of PC commands. The head command runs until it completes; the
+ *        rest wait, so commands take effect in the order they were sent. A completion is kept at
+ *        the head until the reply queue takes it, so none is lost. ACKs are kept the same way: a
+ *        queued command keeps its ACK pending until the reply queue takes it, and DONE never goes
+ *        out before its ACK. A command whose id is still queued is not run twice; it is re-ACKed.
+ */
+#include "upstream_cmd.h"
+#include "upstream_pc_protocol.h"
+#include "gateway_actions.h"
+#include "modbus_master.h"
+#include "modbus_table.h"
+#include "modbus_cfg.h"
+#include "io_map.h"
+#include <stddef.h>
+
+typedef enum {
+    CMD_PENDING,            /* not started (or the job slot was busy) */
+    CMD_RUNNING,            /* Modbus job in flight */
+    CMD_DONE                /* result set, completion not yet queued */
+} CmdState_t;
+
+typedef struct {
+    uint8_t  id;
+    uint8_t  cmd;
+    uint8_t  slave;
+    uint16_t addr;
+    uint16_t value;
+    uint16_t mask;
+    uint8_t  acked;         /* ACK taken by the reply queue */
+} UpstreamCmd_t;
+
+static UpstreamCmd_t queue[UPSTREAM_CMD_QUEUE_LEN];
+static uint8_t q_head;
+static uint8_t q_count;
+static CmdState_t head_state;
+static uint8_t head_result;
+/* ACK of a rejected command that the reply queue could not take; a later one replaces it */
+static uint8_t nak_pending;
+static uint8_t nak_id;
+static uint8_t nak_result;
+
+static inline uint16_t le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint8_t is_slave(uint8_t slave)
+{
+    return (slave >= SLAVE_ID_FIRST && slave <= SLAVE_ID_LAST) ? 1 : 0;
+}
+
+/* Decode args (after the id) into c; 0 or UPSTREAM_RESULT_BAD_REQUEST */
+static uint8_t decode(uint8_t cmd, const uint8_t *a, uint8_t n, UpstreamCmd_t *c)
+{
+    c->cmd = cmd;
+    switch (cmd) {
+    case UPSTREAM_CMD_WRITE_DO:
+        if (n != 4u) break;
+        c->value = le16(&a[0]);
+        c->mask = le16(&a[2]);
+        return 0;
+    case UPSTREAM_CMD_WRITE_COIL:
+        if (n != 4u || !is_slave(a[0]) || a[3] > 1u) break;
+        c->slave = a[0];
+        c->addr = le16(&a[1]);
+        c->value = a[3];
+        return 0;
+    case UPSTREAM_CMD_DOOR_PULSE:
+        if ((n != 1u && n != 3u) || a[0] < 1u || a[0] > 2u) break;
+        c->slave = a[0];        /* door number */
+        c->value = (n == 3u) ? le16(&a[1]) : 0;
+        return 0;
+    case UPSTREAM_CMD_WRITE_REG:
+        if (n != 5u || (a[0] != MODBUS_BROADCAST_ADDR && !is_slave(a[0]))) break;
+        c->slave = a[0];
+        c->addr = le16(&a[1]);
+        c->value = le16(&a[3]);
+        return 0;
+    default:
+        break;
+    }
+    return UPSTREAM_RESULT_BAD_REQUEST;
+}
+
+static UpstreamCmd_t *find_queued(uint8_t id)
+{
+    for (uint8_t i = 0; i < q_count; i++) {
+        UpstreamCmd_t *c = &queue[(q_head + i) % UPSTREAM_CMD_QUEUE_LEN];
+        if (c->id == id)
+            return c;
+    }
+    return NULL;
+}
+
+/* Queue pending ACKs in command order; stops at the first one the reply queue cannot take */
+static void send_acks(void)
+{
+    if (nak_pending && UpstreamPC_QueueReply(UPSTREAM_REPLY_ACK, nak_id, nak_result) == 0)
+        nak_pending = 0;
+    for (uint8_t i = 0; i < q_count; i++) {
+        UpstreamCmd_t *c = &queue[(q_head + i) % UPSTREAM_CMD_QUEUE_LEN];
+        if (c->acked)
+            continue;
+        if (UpstreamPC_QueueReply(UPSTREAM_REPLY_ACK, c->id, UPSTREAM_RESULT_OK) != 0)
+            return;
+        c->acked = 1;
+    }
+}
+
+void UpstreamCmd_Handle(uint8_t cmd, const uint8_t *data, uint8_t len)
+{
+    if (len < 1u) return;       /* no id to answer with */
+    UpstreamCmd_t c = { 0 };
+    c.id = data[0];
+    uint8_t result = decode(cmd, &data[1], (uint8_t)(len - 1u), &c);
+    if (result == 0) {
+        UpstreamCmd_t *dup = find_queued(c.id);
+        if (dup) {
+            /* PC resent after a lost ACK: answer again, run once */
+            dup->acked = 0;
+            send_acks();
+            return;
+        }
+        if (q_count < UPSTREAM_CMD_QUEUE_LEN) {
+            queue[(q_head + q_count) % UPSTREAM_CMD_QUEUE_LEN] = c;
+            q_count++;
+            send_acks();
+            return;
+        }
+        result = UPSTREAM_RESULT_QUEUE_FULL;
+    }
+    if (UpstreamPC_QueueReply(UPSTREAM_REPLY_ACK, c.id, result) != 0) {
+        nak_pending = 1;
+        nak_id = c.id;
+        nak_result = result;
+    }
+}
+
+static void job_done(int result, const uint16_t *regs, uint16_t num)
+{
+    (void)regs;
+    (void)num;
+    const UpstreamCmd_t *c = &queue[q_head];
+    if (result == 0 && c->cmd == UPSTREAM_CMD_WRITE_COIL)
+        ModbusTable_SetCoil((SlaveId_t)c->slave, c->addr, (uint8_t)c->value);
+    head_result = (result == 0) ? UPSTREAM_RESULT_OK : UPSTREAM_RESULT_FAILED;
+    head_state = CMD_DONE;
+}
+
+static void start(const UpstreamCmd_t *c)
+{
+    switch (c->cmd) {
+    case UPSTREAM_CMD_WRITE_DO: {
+        uint16_t bits = IO_Main_ReadDO_Bitmap();
+        IO_Main_WriteDO_Bitmap((uint16_t)((bits & ~c->mask) | (c->value & c->mask)));
+        head_result = UPSTREAM_RESULT_OK;
+        head_state = CMD_DONE;
+        return;
+    }
+    case UPSTREAM_CMD_DOOR_PULSE:
+        if (c->slave == 1u) Gateway_Action_PulseMainDoor1(c->value);
+        else Gateway_Action_PulseMainDoor2(c->value);
+        head_result = UPSTREAM_RESULT_OK;
+        head_state = CMD_DONE;
+        return;
+    case UPSTREAM_CMD_WRITE_COIL:
+    case UPSTREAM_CMD_WRITE_REG: {
+        PollEntry_t req = { (SlaveId_t)c->slave,
+                            (c->cmd == UPSTREAM_CMD_WRITE_COIL) ? POLL_ENTRY_WRITE_COIL : POLL_ENTRY_WRITE_HOLDING,
+                            c->addr, 1, c->value };
+        /* Slot taken (capture readout, enumeration, baud change): retry on the next poll */
+        if (ModbusMaster_SubmitJob(&req, job_done) == 0)
+            head_state = CMD_RUNNING;
+        return;
+    }
+    default:
+        head_result = UPSTREAM_RESULT_BAD_REQUEST;
+        head_state = CMD_DONE;
+        return;
+    }
+}
+
+void UpstreamCmd_Init(void)
+{
+    q_head = 0;
+    q_count = 0;
+    head_state = CMD_PENDING;
+    nak_pending = 0;
+    UpstreamPC_SetCommandCallback(UpstreamCmd_Handle);
+}
+
+void UpstreamCmd_Poll(void)
+{
+    send_acks();
+    while (q_count) {
+        const UpstreamCmd_t *c = &queue[q_head];
+        if (head_state == CMD_PENDING)
+            start(c);
+        if (head_state != CMD_DONE || !c->acked) return;
+        if (UpstreamPC_QueueReply(UPSTREAM_REPLY_DONE, c->id, head_result) != 0) return;
+        q_head = (uint8_t)((q_head + 1u) % UPSTREAM_CMD_QUEUE_LEN);
+        q_count--;
+        head_state = CMD_PENDING;
+    }
+}
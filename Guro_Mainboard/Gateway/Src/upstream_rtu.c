@@ -0,0 +1,198 @@
+/**
+ * @file upstream_rtu.c
+ * @brief MAIN board: Modbus RTU slave transport on USART2 (PC link). HAL UART callbacks are routed
+ *        here by uart_dispatch.c when UPSTREAM_LINK_RTU is set, as events in main-loop context.
+ *        A frame ends at the first idle line after it (one character time rather than RTU's 3.5);
+ *        the PC is a single master that waits for each response, so that is enough to delimit it.
+ */
+#include "upstream_rtu.h"
+#include "upstream_slave_h2tech.h"
+#include "modbus_rtu.h"
+#include "modbus_cfg.h"
+#include "led_status.h"
+#include "main.h"
+
+extern UART_HandleTypeDef huart2;
+
+#define EX_ILLEGAL_FUNCTION     0x01
+#define EX_ILLEGAL_DATA_VAL     0x03
+#define RTU_MIN_FRAME           4u      /* addr, fc, CRC */
+#define RTU_OVERHEAD            3u      /* addr + CRC around the PDU */
+
+static DMA_HandleTypeDef hdma_rx;
+static DMA_HandleTypeDef hdma_tx;
+static uint8_t rx_buf[UPSTREAM_RTU_RX_BUF_SIZE];
+static uint8_t tx_buf[UPSTREAM_RTU_TX_BUF_SIZE];
+static uint16_t rx_len;                 /* frame waiting in rx_buf, 0 = none */
+static uint8_t  rx_armed;
+static uint8_t  tx_busy;
+static const aggregated_status_t *agg_image;
+
+static void dma_init(void)
+{
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    hdma_rx.Instance = DMA1_Stream5;
+    hdma_rx.Init.Channel = DMA_CHANNEL_4;
+    hdma_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_rx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_rx.Init.Mode = DMA_NORMAL;
+    hdma_rx.Init.Priority = DMA_PRIORITY_LOW;
+    hdma_rx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    (void)HAL_DMA_Init(&hdma_rx);
+    __HAL_LINKDMA(&huart2, hdmarx, hdma_rx);
+
+    hdma_tx.Instance = DMA1_Stream6;
+    hdma_tx.Init = hdma_rx.Init;
+    hdma_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    (void)HAL_DMA_Init(&hdma_tx);
+    __HAL_LINKDMA(&huart2, hdmatx, hdma_tx);
+
+    /* Same priority as the USART2 interrupt */
+    HAL_NVIC_SetPriority(DMA1_Stream5_IRQn, 6, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Stream5_IRQn);
+    HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, 6, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+}
+
+static void start_rx(void)
+{
+    if (HAL_UARTEx_ReceiveToIdle_DMA(&huart2, rx_buf, UPSTREAM_RTU_RX_BUF_SIZE) == HAL_OK)
+        rx_armed = 1;
+}
+
+static inline uint16_t be16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static inline uint8_t is_write_fc(uint8_t fc)
+{
+    return (fc == 0x05 || fc == 0x06 || fc == 0x0F || fc == 0x10) ? 1 : 0;
+}
+
+static inline uint8_t is_supported_fc(uint8_t fc)
+{
+    return (fc >= 0x02 && fc <= 0x06) || fc == 0x0F || fc == 0x10;
+}
+
+/* Checks fc, then the request shape; sets count/data for the handler.
+ * 0, EX_ILLEGAL_FUNCTION (before any length check) or EX_ILLEGAL_DATA_VAL. */
+static uint8_t parse_request(uint8_t fc, uint16_t pdu_len, uint16_t *count, const uint8_t **data)
+{
+    if (!is_supported_fc(fc)) return EX_ILLEGAL_FUNCTION;
+    if (pdu_len < 5u) return EX_ILLEGAL_DATA_VAL;
+    *count = be16(&rx_buf[4]);
+    *data = NULL;
+
+    switch (fc) {
+    case 0x05:
+    case 0x06:
+        *count = 1;
+        *data = &rx_buf[4];
+        return (pdu_len == 5u) ? 0 : EX_ILLEGAL_DATA_VAL;
+    case 0x0F:
+    case 0x10: {
+        if (pdu_len < 6u) return EX_ILLEGAL_DATA_VAL;
+        uint16_t bc = rx_buf[6];
+        uint32_t expect = (fc == 0x0F) ? ((uint32_t)*count + 7u) / 8u : (uint32_t)*count * 2u;
+        if (bc != pdu_len - 6u || bc != expect) return EX_ILLEGAL_DATA_VAL;
+        *data = &rx_buf[7];
+        return 0;
+    }
+    default:
+        /* FC02/03/04 reads */
+        return (pdu_len == 5u) ? 0 : EX_ILLEGAL_DATA_VAL;
+    }
+}
+
+static void handle_frame(uint16_t len)
+{
+    /* Bad CRC or another unit: no response, as RTU requires */
+    if (len < RTU_MIN_FRAME || ModbusRTU_CRC16Check(rx_buf, len) != 0) return;
+    uint8_t unit = rx_buf[0];
+    uint8_t fc = rx_buf[1];
+    if (unit != UPSTREAM_RTU_UNIT_ID && unit != MODBUS_BROADCAST_ADDR) return;
+    if (unit == MODBUS_BROADCAST_ADDR && !is_write_fc(fc)) return;
+    if (tx_busy) return;                /* previous response still going out */
+
+    LED_Status_OnRS485Activity();
+
+    uint16_t count = 0;
+    const uint8_t *data = NULL;
+    uint8_t ex = parse_request(fc, (uint16_t)(len - RTU_OVERHEAD), &count, &data);
+    int n;
+    if (ex) {
+        tx_buf[1] = (uint8_t)(fc | 0x80);
+        tx_buf[2] = ex;
+        n = 2;
+    } else {
+        n = UpstreamSlave_HandleRequest(fc, be16(&rx_buf[2]), count, data, agg_image,
+                                        &tx_buf[1], (uint16_t)(UPSTREAM_RTU_TX_BUF_SIZE - RTU_OVERHEAD));
+    }
+    if (n <= 0 || unit == MODBUS_BROADCAST_ADDR) return;
+
+    tx_buf[0] = UPSTREAM_RTU_UNIT_ID;
+    ModbusRTU_AppendCRC(tx_buf, (size_t)n + 1u);
+    tx_busy = 1;
+    if (HAL_UART_Transmit_DMA(&huart2, tx_buf, (uint16_t)(n + RTU_OVERHEAD)) != HAL_OK)
+        tx_busy = 0;
+}
+
+void UpstreamRTU_Init(const aggregated_status_t *agg)
+{
+    agg_image = agg;
+    rx_len = 0;
+    rx_armed = 0;
+    tx_busy = 0;
+    dma_init();
+    start_rx();
+}
+
+void UpstreamRTU_Poll(void)
+{
+    uint16_t len = rx_len;
+    if (len) {
+        rx_len = 0;
+        handle_frame(len);
+    }
+    /* Re-armed only once the frame in rx_buf has been handled */
+    if (!rx_armed)
+        start_rx();
+}
+
+/* Idle line or buffer full; half-transfer events are dropped before they are posted */
+void UpstreamRTU_UART_RxEventCallback(uint16_t Size)
+{
+    rx_armed = 0;
+    if (Size > 0 && Size <= UPSTREAM_RTU_RX_BUF_SIZE)
+        rx_len = Size;
+}
+
+void UpstreamRTU_TxCpltCallback(void)
+{
+    tx_busy = 0;
+    LED_Status_OnRS485Activity();
+}
+
+/* Overrun or DMA error aborts the reception; noise/framing errors leave it running */
+void UpstreamRTU_ErrorCallback(void)
+{
+    if (huart2.RxState == HAL_UART_STATE_READY)
+        rx_armed = 0;
+    if (huart2.gState == HAL_UART_STATE_READY)
+        tx_busy = 0;
+}
+
+void UpstreamRTU_DMA_RxIRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&hdma_rx);
+}
+
+void UpstreamRTU_DMA_TxIRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&hdma_tx);
+}
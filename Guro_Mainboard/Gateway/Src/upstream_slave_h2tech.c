@@ -1,32 +1,343 @@
 /**
  * @file upstream_slave_h2tech.c
  * @brief Upstream Modbus Slave (PC link): H2TECH table-driven read/write.
- *        FC02: h2_dec = start_addr + 1, H2Map_FindByDec + H2Map_ReadAggBit, LSB-first.
+ *        FC02: h2_dec = start_addr + 1, H2Map_FindRun (whole range) + H2Map_ReadRunBits, LSB-first.
  *        FC05/15: H2Map_ApplyWrite(entry, value, 300ms). Illegal address -> 0x02.
+ *        FC03/04/06/16: 3x/4x registers from the same table (H2Map_FindRun + read_reg/write_reg),
+ *        any sub-range of a mapped run. 4x2210 (capture samples) is the only register outside it.
  */
 #include "upstream_slave_h2tech.h"
 #include "h2tech_address_map.h"
 #include "gateway_actions.h"
 #include "aggregated_status.h"
 #include "io_map.h"
+#include "capture_fetch.h"
+#include "modbus_master.h"
+#include "modbus_table.h"
+#include "profiler.h"
+#include "app_supervisor.h"
+#include "timed_io.h"
+#include "remote_output.h"
+#include "app_scheduler.h"
+#include <string.h>
 
 #define EX_ILLEGAL_FUNCTION  0x01
 #define EX_ILLEGAL_DATA_ADDR 0x02
 #define EX_ILLEGAL_DATA_VAL  0x03  /* Write to read-only */
+#define EX_SLAVE_BUSY        0x06
 #define PULSE_MS_DEFAULT     300u
 
-/* Upstream current block: 4x2000..4x200D (read-only). Modbus start_addr 2000, 14 registers. */
-#define UPSTREAM_CURRENT_START  2000u
-#define UPSTREAM_CURRENT_COUNT  14u
+/* Register and bit counts per request (Modbus limits) */
+#define UPSTREAM_REG_READ_MAX        125u
+#define UPSTREAM_REG_WRITE_MAX       123u
+#define UPSTREAM_BIT_READ_MAX        2000u
+#define UPSTREAM_BIT_WRITE_MAX       1968u
 
-/* MAIN I/O: 4x2100 = DI bitmap (8 bits), 4x2101 = DO bitmap (bits 0..3). */
-#define UPSTREAM_MAIN_IO_DI_REG  2100u
-#define UPSTREAM_MAIN_IO_DO_REG  2101u
-#define UPSTREAM_MAIN_IO_REG_COUNT 2u
+/* Capture sample readout, the one register outside the table */
+#define UPSTREAM_CAPTURE_DATA_REG    2210u
+#define UPSTREAM_CAPTURE_DATA_MAX    64u
+
+static uint16_t capture_offset;     /* 4x2201 */
+static uint8_t  gap_tolerant;       /* 4x2400 */
+static uint8_t  profile_select;     /* 4x2500 */
+static uint8_t  timed_io_select;    /* 4x2800 */
+static uint8_t  remote_out_select;  /* 4x2900 */
+static uint8_t  sched_select;       /* 4x2950 */
+
+static int put_regs(uint8_t fc, const uint16_t *regs, uint16_t count, uint8_t *response, uint16_t resp_max)
+{
+    const uint16_t byte_count = count * 2u;
+    if (resp_max < 2u + byte_count) return -1;
+    response[0] = fc;
+    response[1] = (uint8_t)byte_count;
+    for (uint16_t i = 0; i < count; i++) {
+        response[2 + i * 2]     = (uint8_t)(regs[i] >> 8);
+        response[2 + i * 2 + 1] = (uint8_t)(regs[i] & 0xFF);
+    }
+    return (int)(2 + byte_count);
+}
+
+static int exception(uint8_t fc, uint8_t code, uint8_t *response)
+{
+    response[0] = (uint8_t)(fc | 0x80);
+    response[1] = code;
+    return 2;
+}
+
+/* FC03 4x2210, count 1..64: samples from the 4x2201 offset (channel-major), 0 past the end. Reading
+ * leaves the offset alone, so a PC retry gets the same samples. Capture control and info are table
+ * rows: 4x2200 W = (cmd << 8) | slave_id (CaptureFetchCmd_t), R = (slave_id << 8) | state;
+ * 4x2202..2206 = count, period_us, pretrig, seq, slave status. */
+static int handle_capture_read(uint16_t count, uint8_t *response, uint16_t resp_max)
+{
+    uint16_t regs[UPSTREAM_CAPTURE_DATA_MAX];
+
+    if (count == 0 || count > UPSTREAM_CAPTURE_DATA_MAX)
+        return exception(0x03, EX_ILLEGAL_DATA_VAL, response);
+    uint16_t n = CaptureFetch_ReadSamples(capture_offset, regs, count);
+    for (uint16_t i = n; i < count; i++) regs[i] = 0;
+    return put_regs(0x03, regs, count, response, resp_max);
+}
+
+static uint16_t read_reg(const H2_MapEntry_t *e, const aggregated_status_t *agg)
+{
+    const uint8_t *base = (const uint8_t *)agg;
+
+    switch (e->src) {
+    case H2_SRC_AGG_U16: {
+        uint16_t v;
+        memcpy(&v, base + e->arg, sizeof(v));
+        return v;
+    }
+    case H2_SRC_AGG_U8:
+        return base[e->arg];
+    case H2_SRC_LPSB_COILS: {
+        uint16_t v = 0;
+        for (uint16_t p = 0; p < SLAVE_LPSB_PORT_COUNT; p++)
+            if (agg->lpsb_coils[e->arg][p]) v |= (uint16_t)(1u << p);
+        return v;
+    }
+    case H2_SRC_MAIN_DI:
+        return IO_Main_ReadDI_Bitmap();
+    case H2_SRC_MAIN_DO:
+        return IO_Main_ReadDO_Bitmap();
+    case H2_SRC_LINK_STAT: {
+        uint16_t board = (uint16_t)(e->arg >> 2);
+        ModbusLinkStats_t ls;
+        ModbusMaster_GetLinkStats(board ? SLAVE_ID_LPSB(board - 1u) : SLAVE_ID_HPSB, &ls);
+        switch ((H2_LinkStat_t)(e->arg & 3u)) {
+        case H2_LINK_OK:        return (uint16_t)ls.ok;
+        case H2_LINK_TIMEOUT:   return (uint16_t)ls.timeout;
+        case H2_LINK_BAD_FRAME: return (uint16_t)ls.bad_frame;
+        default:                return (uint16_t)ls.exception;
+        }
+    }
+    case H2_SRC_CAPTURE_INFO: {
+        CaptureFetchInfo_t ci;
+        CaptureFetch_GetInfo(&ci);
+        switch (e->arg) {
+        case 0:  return (uint16_t)(((uint16_t)ci.slave_id << 8) | ci.state);
+        case 2:  return ci.count;
+        case 3:  return ci.period_us;
+        case 4:  return ci.pretrig;
+        case 5:  return ci.seq;
+        case 6:  return ci.slave_status;
+        default: return 0;
+        }
+    }
+    case H2_SRC_CAPTURE_OFFSET:
+        return capture_offset;
+    case H2_SRC_1X_MODE:
+        return gap_tolerant;
+    case H2_SRC_PROFILE_SELECT:
+        return profile_select;
+    case H2_SRC_PROFILE: {
+        /* 2501 = probes compiled in (0: built without PROFILER_ENABLED), 2502 = loop utilisation x10 %,
+         * 2503 = core MHz; then for the probe selected by 2500, high word first: count, min, max,
+         * mean (cycles), and 2512..2519 = histogram */
+        Profiler_Probe_t pr;
+        if (e->arg == 1) return Profiler_ProbeCount();
+        if (e->arg == 2) return Profiler_GetUtilisation();
+        if (e->arg == 3) return Profiler_CpuMHz();
+        if (Profiler_GetProbe((Profiler_ProbeId_t)profile_select, &pr) != 0) return 0;
+        if (e->arg >= 12u) return pr.hist[(e->arg - 12u) % PROFILER_HIST_BUCKETS];
+        const uint32_t v[4] = { pr.count, pr.min_cycles, pr.max_cycles, pr.mean_cycles };
+        uint32_t x = v[((e->arg - 4u) / 2u) & 3u];
+        return (e->arg & 1u) ? (uint16_t)x : (uint16_t)(x >> 16);
+    }
+    case H2_SRC_SUPERVISOR: {
+        app_sup_report_t r;
+        AppSupervisor_GetReport(&r);
+        switch (e->arg) {
+        case 0:  return r.reset_flags;
+        case 1:  return (uint16_t)r.wwdg_resets;
+        case 2:  return (uint16_t)r.starve_events;
+        case 3:  return r.prev.cause;
+        case 4:  return r.prev.starved_mask;
+        case 5:  return r.prev.last_checkin;
+        case 6:  return (uint16_t)(r.prev.uptime_ms / 1000u);
+        case 7:  return r.prev.max_gap_ms;
+        case 8:  return r.now.max_gap_ms;
+        default: return r.now.gap_hist[(e->arg - 9u) % APP_SUP_GAP_BUCKETS];
+        }
+    }
+    case H2_SRC_SLAVE_EVENT: {
+        /* 2700 = log number, 2702..2706 = the oldest event (all 0 when none); reading does not
+         * remove it, only the ack does, so a repeated read returns the same event */
+        SlaveEvent_t ev;
+        uint16_t log_seq;
+        if (e->arg == 1) return ModbusTable_GetSlaveEventCount();
+        if (e->arg >= 7u) {
+            uint16_t board = (uint16_t)(e->arg - 7u);
+            return ModbusTable_GetSlaveEventsLost(board ? SLAVE_ID_LPSB(board - 1u) : SLAVE_ID_HPSB);
+        }
+        if (ModbusTable_PeekSlaveEvent(&ev, &log_seq) != 0) return 0;
+        switch (e->arg) {
+        case 0:  return log_seq;
+        case 2:  return ev.slave_id;
+        case 3:  return ev.seq;
+        case 4:  return (uint16_t)(((uint16_t)ev.type << 8) | ev.index);
+        case 5:  return ev.value;
+        default: return ev.slave_tick;
+        }
+    }
+    case H2_SRC_TIMED_IO_SELECT:
+        return timed_io_select;
+    case H2_SRC_TIMED_IO: {
+        /* 2801 = channel count; then for the channel selected by 2800: steps (high word first),
+         * failed remote writes, last and max lateness (ms) */
+        TimedIO_Stats_t ts;
+        if (e->arg == 1) return TIMED_IO_CH_COUNT;
+        TimedIO_GetStats(timed_io_select, &ts);
+        switch (e->arg) {
+        case 2:  return (uint16_t)(ts.steps >> 16);
+        case 3:  return (uint16_t)ts.steps;
+        case 4:  return (uint16_t)ts.failed;
+        case 5:  return ts.last_late_ms;
+        default: return ts.max_late_ms;
+        }
+    }
+    case H2_SRC_REMOTE_OUT_SELECT:
+        return remote_out_select;
+    case H2_SRC_REMOTE_OUT: {
+        /* 2901..2906 = transaction counters (low 16 bits); 2907..2919 = max and histogram (ms) of
+         * the latency stage selected by 2900 */
+        if (e->arg >= 7u) {
+            RemoteOut_Hist_t h;
+            RemoteOut_GetHistogram((RemoteOut_Latency_t)remote_out_select, &h);
+            if (e->arg == 7u) return h.max_ms;
+            return h.bucket[(e->arg - 8u) % REMOTE_OUT_HIST_BUCKETS];
+        }
+        RemoteOut_Stats_t rs;
+        RemoteOut_GetStats(&rs);
+        const uint32_t v[6] = { rs.requests, rs.coalesced, rs.writes, rs.failed, rs.mismatch, rs.unconfirmed };
+        return (uint16_t)v[(e->arg - 1u) % 6u];
+    }
+    case H2_SRC_SCHED_SELECT:
+        return sched_select;
+    case H2_SRC_SCHED: {
+        /* 2951 = task count; then for the task selected by 2950: runs (high word first), missed
+         * and triggered releases (low 16 bits), worst lateness (ms) */
+        app_task_stats_t st;
+        if (e->arg == 1) return TASK_COUNT;
+        AppScheduler_GetStats((app_task_id_t)sched_select, &st);
+        switch (e->arg) {
+        case 2:  return (uint16_t)(st.runs >> 16);
+        case 3:  return (uint16_t)st.runs;
+        case 4:  return (uint16_t)st.missed;
+        case 5:  return (uint16_t)st.triggered;
+        default: return st.max_late_ms;
+        }
+    }
+    default:
+        return 0;
+    }
+}
+
+/* 0 when write_reg would take value, else the exception code. Nothing is changed, so FC16 can check
+ * a whole range before writing any of it. */
+static uint8_t check_reg(const H2_MapEntry_t *e, uint16_t value)
+{
+    switch (e->action) {
+    case H2_ACT_WRITE_DO_BITMAP:
+    case H2_ACT_CAPTURE_OFFSET:
+        return 0;
+    case H2_ACT_CAPTURE_START:
+        if (CaptureFetch_CanStart((SlaveId_t)(value & 0xFFu), (CaptureFetchCmd_t)(value >> 8)) != 0) {
+            CaptureFetchInfo_t ci;
+            CaptureFetch_GetInfo(&ci);
+            return (ci.state == CAPTURE_FETCH_BUSY) ? EX_SLAVE_BUSY : EX_ILLEGAL_DATA_VAL;
+        }
+        return 0;
+    case H2_ACT_SET_1X_MODE:
+        return (value > 1u) ? EX_ILLEGAL_DATA_VAL : 0;
+    case H2_ACT_PROFILE_SELECT:
+        return (value >= PROF_COUNT) ? EX_ILLEGAL_DATA_VAL : 0;
+    case H2_ACT_PROFILE_CLEAR:
+    case H2_ACT_REMOTE_OUT_CLEAR:
+        return (value != 1u) ? EX_ILLEGAL_DATA_VAL : 0;
+    case H2_ACT_EVENT_ACK:
+        return (ModbusTable_CanAckSlaveEvents(value) < 0) ? EX_ILLEGAL_DATA_VAL : 0;
+    case H2_ACT_TIMED_IO_SELECT:
+        return (value >= TIMED_IO_CH_COUNT) ? EX_ILLEGAL_DATA_VAL : 0;
+    case H2_ACT_REMOTE_OUT_SELECT:
+        return (value >= REMOTE_OUT_LAT_COUNT) ? EX_ILLEGAL_DATA_VAL : 0;
+    case H2_ACT_SCHED_SELECT:
+        return (value >= TASK_COUNT) ? EX_ILLEGAL_DATA_VAL : 0;
+    default:
+        return EX_ILLEGAL_DATA_VAL;
+    }
+}
+
+/* Carry out a register write; 0 or the exception code */
+static uint8_t write_reg(const H2_MapEntry_t *e, uint16_t value)
+{
+    uint8_t ex = check_reg(e, value);
+    if (ex) return ex;
+
+    switch (e->action) {
+    case H2_ACT_WRITE_DO_BITMAP:
+        IO_Main_WriteDO_Bitmap(value & 0x0Fu);     /* bits 0..3 valid; others ignored */
+        break;
+    case H2_ACT_CAPTURE_START:
+        (void)CaptureFetch_Start((SlaveId_t)(value & 0xFFu), (CaptureFetchCmd_t)(value >> 8));
+        capture_offset = 0;
+        break;
+    case H2_ACT_CAPTURE_OFFSET:
+        capture_offset = value;
+        break;
+    case H2_ACT_SET_1X_MODE:
+        UpstreamSlave_SetGapTolerant((uint8_t)value);
+        break;
+    case H2_ACT_PROFILE_SELECT:
+        profile_select = (uint8_t)value;
+        break;
+    case H2_ACT_PROFILE_CLEAR:
+        Profiler_Clear();
+        break;
+    case H2_ACT_EVENT_ACK:
+        (void)ModbusTable_AckSlaveEvents(value);
+        break;
+    case H2_ACT_TIMED_IO_SELECT:
+        timed_io_select = (uint8_t)value;
+        break;
+    case H2_ACT_REMOTE_OUT_SELECT:
+        remote_out_select = (uint8_t)value;
+        break;
+    case H2_ACT_REMOTE_OUT_CLEAR:
+        RemoteOut_ClearMetrics();
+        break;
+    case H2_ACT_SCHED_SELECT:
+        sched_select = (uint8_t)value;
+        break;
+    default:
+        break;
+    }
+    return 0;
+}
+
+/* FC03/FC04: count registers from start_addr, all inside one mapped run of area */
+static int handle_reg_read(uint8_t fc, H2_Area_t area, uint16_t start_addr, uint16_t count,
+                           const aggregated_status_t *agg, uint8_t *response, uint16_t resp_max)
+{
+    uint16_t regs[UPSTREAM_REG_READ_MAX];
+
+    if (count == 0 || count > UPSTREAM_REG_READ_MAX)
+        return exception(fc, EX_ILLEGAL_DATA_VAL, response);
+    const H2_MapEntry_t *run = H2Map_FindRun(area, start_addr, count);
+    if (!run)
+        return exception(fc, EX_ILLEGAL_DATA_ADDR, response);
+    for (uint16_t i = 0; i < count; i++)
+        regs[i] = read_reg(&run[i], agg);
+    return put_regs(fc, regs, count, response, resp_max);
+}
 
 /* FC02 Read Discrete Inputs: H2TECH 1x, h2_dec = start_addr + 1 + i */
 static int handle_fc02(uint16_t start_addr, uint16_t count, uint8_t *response, uint16_t resp_max)
 {
+    if (count == 0 || count > UPSTREAM_BIT_READ_MAX)
+        return exception(0x02, EX_ILLEGAL_DATA_VAL, response);
+
     const uint16_t byte_count = (uint16_t)((count + 7u) / 8u);
     if (resp_max < 2u + byte_count) return -1;
 
@@ -36,21 +347,21 @@ static int handle_fc02(uint16_t start_addr, uint16_t count, uint8_t *response, u
     for (uint16_t i = 0; i < byte_count; i++)
         response[2u + i] = 0;
 
-    for (uint16_t i = 0; i < count; i++) {
-        uint16_t h2_dec = H2Map_ModbusAddrToH2Dec(start_addr) + i;
-        const H2_MapEntry_t *e = H2Map_FindByDec(H2_AREA_1X, h2_dec);
+    if (gap_tolerant) {
+        if (!H2Map_ReadSpanBits(H2_AREA_1X, H2Map_ModbusAddrToH2Dec(start_addr), count, &response[2])) {
+            response[0] = 0x82;
+            response[1] = EX_ILLEGAL_DATA_ADDR;
+            return 2;
+        }
+    } else {
+        /* Whole range checked at once; its entries are then consecutive in the map */
+        const H2_MapEntry_t *e = H2Map_FindRun(H2_AREA_1X, H2Map_ModbusAddrToH2Dec(start_addr), count);
         if (!e) {
             response[0] = 0x82;
             response[1] = EX_ILLEGAL_DATA_ADDR;
             return 2;
         }
-        bool bit = false;
-        if (e->src == H2_SRC_AGG_BIT)
-            bit = H2Map_ReadAggBit(e->agg_bit_index);
-        else if (e->src == H2_SRC_CONST0)
-            bit = false;
-        if (bit)
-            response[2u + (i / 8u)] |= (uint8_t)(1u << (i % 8u));
+        H2Map_ReadRunBits(e, count, &response[2], 0);
     }
     /* Clear downstream write-fail alarm when PC reads 1x0880 (ALM12). */
     if (start_addr <= 880u && (start_addr + count) > 880u)
@@ -58,99 +369,74 @@ static int handle_fc02(uint16_t start_addr, uint16_t count, uint8_t *response, u
     return (int)(2 + byte_count);
 }
 
-/* FC03 Read Holding Registers: 4x2000..4x200D = per-port current raw (read-only).
- * Also 4x2100 count=2: MAIN DI bitmap (reg 2100), DO bitmap (reg 2101).
- * Policy: only start=2000 count=14 or start=2100 count=2 accepted; else 0x02 (bad address) or 0x03 (bad value). */
-static int handle_fc03(uint16_t start_addr, uint16_t count, const void *p_agg,
+/* FC03 Read Holding Registers: 4x table rows (currents, MAIN IO, capture, data age, 1x mode) or the
+ * 4x2210 capture samples. */
+static int handle_fc03(uint16_t start_addr, uint16_t count, const aggregated_status_t *agg,
                        uint8_t *response, uint16_t resp_max)
 {
-    /* MAIN I/O block: 4x2100, 4x2101 */
-    if (start_addr == UPSTREAM_MAIN_IO_DI_REG) {
-        if (count != UPSTREAM_MAIN_IO_REG_COUNT) {
-            response[0] = 0x83;
-            response[1] = EX_ILLEGAL_DATA_VAL;
-            return 2;
-        }
-        if (resp_max < 2u + 4u) return -1;
-        uint16_t di = IO_Main_ReadDI_Bitmap();
-        uint16_t do_val = IO_Main_ReadDO_Bitmap();
-        response[0] = 0x03;
-        response[1] = 4u;
-        response[2] = (uint8_t)(di >> 8);
-        response[3] = (uint8_t)(di & 0xFF);
-        response[4] = (uint8_t)(do_val >> 8);
-        response[5] = (uint8_t)(do_val & 0xFF);
-        return 6;
-    }
-    if (start_addr == UPSTREAM_MAIN_IO_DO_REG) {
-        response[0] = 0x83;
-        response[1] = EX_ILLEGAL_DATA_ADDR;
-        return 2;
-    }
+    if (start_addr == UPSTREAM_CAPTURE_DATA_REG)
+        return handle_capture_read(count, response, resp_max);
+    return handle_reg_read(0x03, H2_AREA_4X, start_addr, count, agg, response, resp_max);
+}
 
-    if (start_addr != UPSTREAM_CURRENT_START) {
-        response[0] = 0x83;
-        response[1] = EX_ILLEGAL_DATA_ADDR;
-        return 2;
-    }
-    if (count != UPSTREAM_CURRENT_COUNT) {
-        response[0] = 0x83;
-        response[1] = EX_ILLEGAL_DATA_VAL;
-        return 2;
-    }
-    const uint16_t byte_count = count * 2u;
-    if (resp_max < 2u + byte_count) return -1;
+/* FC04 Read Input Registers: 3x table rows (environment, board status, currents, link statistics) */
+static int handle_fc04(uint16_t start_addr, uint16_t count, const aggregated_status_t *agg,
+                       uint8_t *response, uint16_t resp_max)
+{
+    return handle_reg_read(0x04, H2_AREA_3X, start_addr, count, agg, response, resp_max);
+}
 
-    const aggregated_status_t *agg = (const aggregated_status_t *)p_agg;
-    response[0] = 0x03;
-    response[1] = (uint8_t)byte_count;
+/* FC06 Write Single Register: writable 4x rows (2101 DO bitmap, 2200/2201 capture, 2400 1x mode,
+ * 2500/2501 profiler, 2700 event ack, 2800 timed output select, 2900/2901 remote coils,
+ * 2950 scheduler task select). Unmapped -> 0x02, read-only -> 0x03. */
+static int handle_fc06(uint16_t start_addr, const uint8_t *write_data,
+                       uint8_t *response, uint16_t resp_max)
+{
+    if (resp_max < 5u || !write_data) return -1;
 
-    uint16_t regs[UPSTREAM_CURRENT_COUNT];
-    regs[0] = agg->hpsb_sense_raw[0];
-    regs[1] = agg->hpsb_sense_raw[1];
-    regs[2] = agg->hpsb_sense_raw[2];
-    regs[3] = agg->lpsb1_sense_raw[0];
-    regs[4] = agg->lpsb1_sense_raw[1];
-    regs[5] = agg->lpsb1_sense_raw[2];
-    regs[6] = agg->lpsb2_sense_raw[0];
-    regs[7] = agg->lpsb2_sense_raw[1];
-    regs[8] = agg->lpsb2_sense_raw[2];
-    regs[9] = agg->lpsb3_sense_raw[0];
-    regs[10] = agg->lpsb3_sense_raw[1];
-    regs[11] = agg->lpsb3_sense_raw[2];
-    regs[12] = 0;  /* MAIN DOOR1 current (none) */
-    regs[13] = 0;  /* MAIN DOOR2 current (none) */
-    for (uint16_t i = 0; i < count; i++) {
-        response[2 + i * 2]     = (uint8_t)(regs[i] >> 8);
-        response[2 + i * 2 + 1] = (uint8_t)(regs[i] & 0xFF);
-    }
-    return (int)(2 + byte_count);
+    const H2_MapEntry_t *e = H2Map_FindByDec(H2_AREA_4X, start_addr);
+    if (!e)
+        return exception(0x06, EX_ILLEGAL_DATA_ADDR, response);
+    if (e->rw != H2_RW_WRITE)
+        return exception(0x06, EX_ILLEGAL_DATA_VAL, response);
+    uint8_t ex = write_reg(e, (uint16_t)((write_data[0] << 8) | write_data[1]));
+    if (ex)
+        return exception(0x06, ex, response);
+    response[0] = 0x06;
+    response[1] = (uint8_t)(start_addr >> 8);
+    response[2] = (uint8_t)(start_addr & 0xFF);
+    response[3] = write_data[0];
+    response[4] = write_data[1];
+    return 5;
 }
 
-/* FC06 Write Single Register: only addr 2101 (DO bitmap). Value bits 0..3 valid; others ignored. */
-static int handle_fc06(uint16_t start_addr, const uint8_t *write_data,
+/* FC16 Write Multiple Registers: the whole range must be one run of writable 4x rows, and every value
+ * must pass check_reg, before anything is written; values are then applied in address order. */
+static int handle_fc16(uint16_t start_addr, uint16_t count, const uint8_t *write_data,
                        uint8_t *response, uint16_t resp_max)
 {
-    if (resp_max < 6u || !write_data) return -1;
-    if (start_addr == UPSTREAM_MAIN_IO_DI_REG) {
-        response[0] = 0x86;
-        response[1] = EX_ILLEGAL_DATA_VAL;
-        return 2;
-    }
-    if (start_addr != UPSTREAM_MAIN_IO_DO_REG) {
-        response[0] = 0x86;
-        response[1] = EX_ILLEGAL_DATA_ADDR;
-        return 2;
+    if (resp_max < 5u || !write_data) return -1;
+
+    if (count == 0 || count > UPSTREAM_REG_WRITE_MAX)
+        return exception(0x10, EX_ILLEGAL_DATA_VAL, response);
+    const H2_MapEntry_t *run = H2Map_FindRun(H2_AREA_4X, start_addr, count);
+    if (!run)
+        return exception(0x10, EX_ILLEGAL_DATA_ADDR, response);
+    for (uint16_t i = 0; i < count; i++) {
+        if (run[i].rw != H2_RW_WRITE)
+            return exception(0x10, EX_ILLEGAL_DATA_VAL, response);
+        uint8_t ex = check_reg(&run[i], (uint16_t)((write_data[i * 2u] << 8) | write_data[i * 2u + 1u]));
+        if (ex)
+            return exception(0x10, ex, response);
     }
-    uint16_t value = (uint16_t)((write_data[0] << 8) | write_data[1]);
-    value &= 0x0Fu;
-    IO_Main_WriteDO_Bitmap(value);
-    response[0] = 0x06;
+    for (uint16_t i = 0; i < count; i++)
+        (void)write_reg(&run[i], (uint16_t)((write_data[i * 2u] << 8) | write_data[i * 2u + 1u]));
+    response[0] = 0x10;
     response[1] = (uint8_t)(start_addr >> 8);
     response[2] = (uint8_t)(start_addr & 0xFF);
-    response[3] = (uint8_t)(value >> 8);
-    response[4] = (uint8_t)(value & 0xFF);
-    return 6;
+    response[3] = (uint8_t)(count >> 8);
+    response[4] = (uint8_t)(count & 0xFF);
+    return 5;
 }
 
 /* FC05 Write Single Coil */
@@ -191,28 +477,35 @@ static int handle_fc15(uint16_t start_addr, uint16_t count, const uint8_t *write
                        uint8_t *response, uint16_t resp_max)
 {
     if (resp_max < 5u || !write_data) return -1;
+    if (count == 0 || count > UPSTREAM_BIT_WRITE_MAX)
+        return exception(0x0F, EX_ILLEGAL_DATA_VAL, response);
 
+    /* 0899/0900 not in table -> 0x02 before anything is applied */
+    const H2_MapEntry_t *run = H2Map_FindRun(H2_AREA_1X, H2Map_ModbusAddrToH2Dec(start_addr), count);
+    if (!run) {
+        response[0] = 0x8F;
+        response[1] = EX_ILLEGAL_DATA_ADDR;
+        return 2;
+    }
+
+    /* Whole range checked before any coil is applied, so a rejected request changes nothing */
     for (uint16_t i = 0; i < count; i++) {
-        uint16_t h2_dec = H2Map_ModbusAddrToH2Dec(start_addr) + i;
-        const H2_MapEntry_t *e = H2Map_FindByDec(H2_AREA_1X, h2_dec);
-        if (!e) {
-            response[0] = 0x8F;
-            response[1] = EX_ILLEGAL_DATA_ADDR;
-            return 2;
-        }
-        /* Defensive: write to read-only range -> 0x03; 0899/0900 not in table -> 0x02 above */
-        if (e->rw != H2_RW_WRITE) {
+        /* Defensive: write to read-only range -> 0x03 */
+        if (run[i].rw != H2_RW_WRITE) {
             response[0] = 0x8F;
             response[1] = EX_ILLEGAL_DATA_VAL;
             return 2;
         }
-        bool value = (write_data[i / 8u] >> (i % 8u)) & 1u;
-        if (!H2Map_ApplyWrite(e, value, PULSE_MS_DEFAULT)) {
+        if (!H2Map_CanApplyWrite(&run[i])) {
             response[0] = 0x8F;
             response[1] = EX_ILLEGAL_DATA_ADDR;
             return 2;
         }
     }
+    for (uint16_t i = 0; i < count; i++) {
+        bool value = (write_data[i / 8u] >> (i % 8u)) & 1u;
+        (void)H2Map_ApplyWrite(&run[i], value, PULSE_MS_DEFAULT);
+    }
     response[0] = 0x0F;
     response[1] = (uint8_t)(start_addr >> 8);
     response[2] = (uint8_t)(start_addr & 0xFF);
@@ -221,28 +514,44 @@ static int handle_fc15(uint16_t start_addr, uint16_t count, const uint8_t *write
     return 5;
 }
 
+/* 1x read mode (4x2400): 0 = strict (H2TECH, any unmapped address -> 0x02), 1 = gap-tolerant (unmapped
+ * addresses inside 1x0821..0898 read 0, so one FC02 fetches every status block). RAM only, strict at boot. */
+void UpstreamSlave_SetGapTolerant(uint8_t on)
+{
+    gap_tolerant = on ? 1u : 0u;
+}
+
+uint8_t UpstreamSlave_IsGapTolerant(void)
+{
+    return gap_tolerant;
+}
+
 int UpstreamSlave_HandleRequest(uint8_t fc, uint16_t start_addr, uint16_t count,
                                 const uint8_t *write_data,
                                 const void *p_agg,
                                 uint8_t *response, uint16_t resp_max)
 {
-    (void)p_agg;
+    const aggregated_status_t *agg = (const aggregated_status_t *)p_agg;
     if (!response || resp_max < 2u) return -1;
 
     switch (fc) {
     case 0x02:
         return handle_fc02(start_addr, count, response, resp_max);
     case 0x03:
-        return handle_fc03(start_addr, count, p_agg, response, resp_max);
+        if (!agg) return -1;
+        return handle_fc03(start_addr, count, agg, response, resp_max);
+    case 0x04:
+        if (!agg) return -1;
+        return handle_fc04(start_addr, count, agg, response, resp_max);
     case 0x05:
         return handle_fc05(start_addr, write_data, response, resp_max);
     case 0x06:
         return handle_fc06(start_addr, write_data, response, resp_max);
     case 0x0F:
         return handle_fc15(start_addr, count, write_data, response, resp_max);
-    case 0x01:
-    case 0x04:
     case 0x10:
+        return handle_fc16(start_addr, count, write_data, response, resp_max);
+    case 0x01:
     default:
         response[0] = (uint8_t)(fc | 0x80);
         response[1] = EX_ILLEGAL_FUNCTION;
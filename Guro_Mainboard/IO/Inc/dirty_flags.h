@@ -0,0 +1,40 @@
+/**
+ * @file dirty_flags.h
+ * @brief MAIN board: change marks for the aggregator. The Modbus master, the local IO and the
+ *        gateway mark what they changed; Aggregator_Update() takes the marks and recomputes only
+ *        the fields and agg bits that depend on them. Main-loop context only.
+ */
+#ifndef DIRTY_FLAGS_H
+#define DIRTY_FLAGS_H
+
+#include "io_map.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DIRTY_MAIN_DI       (1u << 0)   /* MAIN DI bitmap changed (IO_Main_ScanDI) */
+#define DIRTY_MAIN_DO       (1u << 1)   /* MAIN DO written */
+#define DIRTY_COMM          (1u << 2)   /* a slave's comm state or the enumerated set changed */
+#define DIRTY_GATEWAY       (1u << 3)   /* downstream write-fail alarm set or cleared */
+#define DIRTY_AGE_TICK      (1u << 4)   /* periodic: data age, staleness, HPSB OC cycle count */
+#define DIRTY_ALL           0x1Fu
+
+/* Slave marks: bit (address - SLAVE_ID_FIRST), one per address */
+#define DIRTY_SLAVE_BIT(s)  (1u << ((uint32_t)(s) - SLAVE_ID_FIRST))
+#define DIRTY_SLAVES_ALL    0xFFFFFFFFu
+
+void     DirtyFlags_Mark(uint32_t flags);
+/* Published image content of slave changed */
+void     DirtyFlags_MarkSlave(SlaveId_t slave);
+void     DirtyFlags_MarkAll(void);
+uint8_t  DirtyFlags_Any(void);
+/* Returns the DIRTY_* marks and the slave marks (may be NULL) and clears both */
+uint32_t DirtyFlags_Take(uint32_t *slaves);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DIRTY_FLAGS_H */
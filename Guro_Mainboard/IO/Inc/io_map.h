@@ -13,16 +13,41 @@ extern "C" {
 #endif
 
 /* ========== Slave IDs (Modbus 0x address) ========== */
+/* Any address 1..SLAVE_ADDR_MAX may hold a sub-board (slave_registry.h); the named ones are the
+ * boards with fixed slots in the H2TECH upstream map. */
+#define SLAVE_ADDR_MAX   32u
+
 typedef enum {
     SLAVE_ID_HPSB  = 1,
     SLAVE_ID_LPSB1 = 2,
     SLAVE_ID_LPSB2 = 3,
     SLAVE_ID_LPSB3 = 4,
-    SLAVE_ID_COUNT = 4
+    SLAVE_ID_COUNT = SLAVE_ADDR_MAX
 } SlaveId_t;
 
 #define SLAVE_ID_FIRST   SLAVE_ID_HPSB
-#define SLAVE_ID_LAST    SLAVE_ID_LPSB3
+#define SLAVE_ID_LAST    ((SlaveId_t)SLAVE_ADDR_MAX)
+
+/* LPSBs mapped upstream (aggregated_status_t, H2TECH ON/OFF 6..14, ALM 8..10, currents 3..11) */
+#define SLAVE_LPSB_MAPPED_COUNT  3u
+#define SLAVE_ID_LPSB(n)         ((SlaveId_t)(SLAVE_ID_LPSB1 + (n)))
+#define SLAVE_LPSB_PORT_COUNT    3u
+
+/* Sub-board address = base + ID_BIT1..4 DIP (slave modbus_cfg.h). Board type comes from the
+ * FC17 Report Slave ID response during bus enumeration (bus_enum.c). */
+typedef enum {
+    SLAVE_TYPE_NONE = 0,        /* not enumerated */
+    SLAVE_TYPE_HPSB = 0x01,
+    SLAVE_TYPE_LPSB = 0x02
+} SlaveType_t;
+
+/* FC17 additional data after [type][run indicator 0xFF] */
+#define SLAVE_REPORT_ID_LEN          7u     /* type, run, ID DIP, holding count, input count, UID lo/hi */
+#define SLAVE_REPORT_ID_DIP          2u
+#define SLAVE_REPORT_ID_HOLDING_CNT  3u
+#define SLAVE_REPORT_ID_INPUT_CNT    4u
+#define SLAVE_REPORT_ID_UID_LO       5u     /* 16-bit fold of the slave MCU's 96-bit unique ID */
+#define SLAVE_REPORT_ID_UID_HI       6u
 
 /* ========== Poll types (what MAIN reads/writes) ========== */
 typedef enum {
@@ -44,6 +69,8 @@ typedef enum {
 #define MODBUS_HOLDING_COUNT        4
 #define MODBUS_INPUT_REG_START      0
 #define MODBUS_INPUT_REG_COUNT      7
+#define MODBUS_HPSB_INPUT_POLL_COUNT  7     /* DI image, CT raw x3, CT RMS x3 */
+#define MODBUS_LPSB_INPUT_POLL_COUNT  4     /* DI image, ACS raw x3 */
 
 /* ========== MAIN local Digital Inputs (GPIO) ========== */
 typedef enum {
@@ -68,21 +95,53 @@ typedef enum {
 } MainDoChannel_t;
 
 /* ========== Sub-board image indices (for application) ========== */
-/* HPSB: Discrete[0..7], Coil[0..7], Holding[0..3], InputReg[0..1] */
-/* LPSB: same layout */
+/* HPSB: Discrete[0..7], Coil[0..7], Holding[0..3], InputReg[0..6] */
+/* LPSB: Discrete[0..7], Coil[0..7], Holding[0..3], InputReg[0..3] (slave_registry.h) */
 #define SUB_DISCRETE_COUNT    MODBUS_DISCRETE_COUNT
 #define SUB_COIL_COUNT        MODBUS_COIL_COUNT
 #define SUB_HOLDING_COUNT     MODBUS_HOLDING_COUNT
 #define SUB_INPUT_REG_COUNT   MODBUS_INPUT_REG_COUNT
 
+/* Image areas, each with its own acquisition time (ModbusTable_GetAgeMs) */
+typedef enum {
+    SLAVE_AREA_DISCRETE = 0,
+    SLAVE_AREA_COIL,
+    SLAVE_AREA_HOLDING,
+    SLAVE_AREA_INPUT,
+    SLAVE_AREA_COUNT
+} SlaveArea_t;
+
 /* Holding register indices (status / alarm) */
 typedef enum {
     HOLDING_REG_STATUS  = 0,
     HOLDING_REG_ALARM  = 1,
-    HOLDING_REG_RESERVED_2 = 2,
+    HOLDING_REG_TRIP_CAUSE = 2,     /* LPSB: local OC trip cause (peak/RMS per port) */
     HOLDING_REG_RESERVED_3 = 3
 } HoldingRegIdx_t;
 
+/* LPSB HOLDING_REG_ALARM: bit n = Port(n+1) local OC trip latched (SSR forced off).
+ * Cleared by writing 0 to the bit (FC06 HOLDING_REG_ALARM). */
+#define LPSB_ALARM_OC_TRIP_MASK  0x0007u
+
+/* Burst waveform capture (same registers on HPSB and LPSB; slave capture.h). Not polled:
+ * driven on demand by capture_fetch. Readout is channel-major through the FC04 window. */
+#define SLAVE_HOLDING_CAPTURE_CTRL        8u    /* write SLAVE_CAPTURE_CMD_* */
+#define SLAVE_HOLDING_CAPTURE_OFFSET      9u    /* readout offset; MAIN writes it before every window read */
+#define SLAVE_HOLDING_CAPTURE_TRIG_RAW    10u
+#define SLAVE_HOLDING_CAPTURE_LENGTH      11u
+#define SLAVE_HOLDING_CAPTURE_PERIOD_US   12u
+#define SLAVE_HOLDING_BAUD_CODE           13u   /* unicast write stages, broadcast commits (modbus_baud.h) */
+#define SLAVE_INPUT_REG_CAPTURE_STATUS    16u   /* 5 regs: status, count, period_us, pretrig, seq */
+#define SLAVE_INPUT_REG_CAPTURE_INFO_COUNT 5u
+#define SLAVE_CAPTURE_WINDOW_START        32u
+#define SLAVE_CAPTURE_WINDOW_REGS         24u
+#define SLAVE_CAPTURE_CH_COUNT            3u
+#define SLAVE_CAPTURE_CMD_STOP            0u
+#define SLAVE_CAPTURE_CMD_TRIGGER         1u
+#define SLAVE_CAPTURE_CMD_ARM             2u
+#define SLAVE_CAPTURE_STATE_MASK          0x0003u
+#define SLAVE_CAPTURE_STATE_DONE          3u
+
 /* Coil indices per sub-board: 0=first relay/SSR, 1=second, 2=third, 3..7 reserved */
 typedef enum {
     COIL_0 = 0,
@@ -105,6 +164,8 @@ void    IO_Main_ReadAllDI(uint8_t *bits);
 uint16_t IO_Main_ReadDI_Bitmap(void);
 uint16_t IO_Main_ReadDO_Bitmap(void);
 void     IO_Main_WriteDO_Bitmap(uint16_t bitmap);
+/** Call periodically: marks DIRTY_MAIN_DI when the DI bitmap differs from the previous scan. */
+void     IO_Main_ScanDI(void);
 
 /** HPSB current sensing (HCT17W): ADC ch 0,1,2. Returns raw ADC count; stub returns 0 until ADC wired. */
 uint16_t IO_ReadHpsbCurrentRaw(uint8_t ch_0_to_2);
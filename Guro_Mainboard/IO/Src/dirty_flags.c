@@ -0,0 +1,41 @@
+/**
+ * @file dirty_flags.c
+ * @brief MAIN board: change marks taken by the aggregator.
+ */
+#include "dirty_flags.h"
+
+_Static_assert(SLAVE_ADDR_MAX <= 32u, "slave marks are one bit per address in 32 bits");
+
+static uint32_t marks;
+static uint32_t slave_marks;
+
+void DirtyFlags_Mark(uint32_t flags)
+{
+    marks |= flags;
+}
+
+void DirtyFlags_MarkSlave(SlaveId_t slave)
+{
+    if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST) return;
+    slave_marks |= DIRTY_SLAVE_BIT(slave);
+}
+
+void DirtyFlags_MarkAll(void)
+{
+    marks = DIRTY_ALL;
+    slave_marks = DIRTY_SLAVES_ALL;
+}
+
+uint8_t DirtyFlags_Any(void)
+{
+    return (marks | slave_marks) ? 1 : 0;
+}
+
+uint32_t DirtyFlags_Take(uint32_t *slaves)
+{
+    uint32_t m = marks;
+    if (slaves) *slaves = slave_marks;
+    marks = 0;
+    slave_marks = 0;
+    return m;
+}
@@ -5,6 +5,7 @@
  */
 #include "io_map.h"
 #include "modbus_table.h"
+#include "dirty_flags.h"
 #include "main.h"
 
 /* Map DI enum to GPIO pin/port */
@@ -26,6 +27,8 @@ static const struct { uint16_t pin; GPIO_TypeDef *port; } main_do_map[MAIN_DO_CO
     { RELAY4_EN_Pin, RELAY4_EN_GPIO_Port },
 };
 
+static uint16_t last_di;
+
 uint8_t IO_Main_ReadDI(MainDiChannel_t ch)
 {
     if (ch >= MAIN_DI_COUNT) return 0;
@@ -36,6 +39,7 @@ void IO_Main_WriteDO(MainDoChannel_t ch, uint8_t value)
 {
     if (ch >= MAIN_DO_COUNT) return;
     HAL_GPIO_WritePin(main_do_map[ch].port, main_do_map[ch].pin, value ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    DirtyFlags_Mark(DIRTY_MAIN_DO);
 }
 
 uint8_t IO_Main_ReadDO(MainDoChannel_t ch)
@@ -52,6 +56,14 @@ uint16_t IO_Main_ReadDI_Bitmap(void)
     return v;
 }
 
+void IO_Main_ScanDI(void)
+{
+    uint16_t di = IO_Main_ReadDI_Bitmap();
+    if (di == last_di) return;
+    last_di = di;
+    DirtyFlags_Mark(DIRTY_MAIN_DI);
+}
+
 uint16_t IO_Main_ReadDO_Bitmap(void)
 {
     uint16_t v = 0;
@@ -76,6 +88,7 @@ void IO_Main_ReadAllDI(uint8_t *bits)
 
 uint16_t IO_ReadHpsbCurrentRaw(uint8_t ch_0_to_2)
 {
-    if (ch_0_to_2 > 2) return 0;
-    return ModbusTable_GetInputReg(SLAVE_ID_HPSB, (uint16_t)(1 + ch_0_to_2));
+    SlaveSnapshot_t v;
+    if (ch_0_to_2 > 2 || ModbusTable_GetSnapshot(SLAVE_ID_HPSB, &v) != 0) return 0;
+    return v.input[1 + ch_0_to_2];      /* one aligned halfword read: never torn */
 }
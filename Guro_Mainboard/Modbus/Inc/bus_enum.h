@@ -0,0 +1,41 @@
+/**
+ * @file bus_enum.h
+ * @brief MAIN board: downstream bus enumeration. MODBUS_ENUM_START_DELAY_MS after boot every
+ *        address SLAVE_ID_FIRST..SLAVE_ID_LAST is probed with FC17 Report Slave ID (short
+ *        MODBUS_PROBE_TIMEOUT_MS). Slaves that answer are added to the slave registry and the poll
+ *        table is built from it.
+ *        Absent addresses are then re-probed one at a time every MODBUS_ENUM_REPROBE_MS and join
+ *        the poll table when they appear. Probes run at the default speed a new board boots at;
+ *        if the bus has been negotiated faster, the new board is switched to the active speed
+ *        (modbus_baud.h) before it is registered. An enumerated slave that stops answering stays in the
+ *        table and is reported as a comm fault.
+ *        A board is only registered once a second probe returns the same type, DIP and UID. A
+ *        garbled answer or a different id flags an address collision (two boards set to one
+ *        address) and the address stays out of the poll table until it answers consistently.
+ */
+#ifndef BUS_ENUM_H
+#define BUS_ENUM_H
+
+#include "io_map.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void    BusEnum_Init(void);
+/* Call from the downstream Modbus task: submits probes as master jobs. */
+void    BusEnum_Poll(void);
+
+uint8_t BusEnum_IsScanDone(void);
+uint8_t BusEnum_IsPresent(SlaveId_t slave);
+uint8_t BusEnum_GetType(SlaveId_t slave);   /* SlaveType_t */
+uint8_t BusEnum_GetDip(SlaveId_t slave);    /* ID_BIT1..4 reported by the slave */
+uint8_t BusEnum_IsCollision(SlaveId_t slave);
+uint32_t BusEnum_GetCollisionMask(void);    /* bit n = address SLAVE_ID_FIRST + n */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUS_ENUM_H */
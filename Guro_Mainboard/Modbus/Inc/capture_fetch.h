@@ -0,0 +1,63 @@
+/**
+ * @file capture_fetch.h
+ * @brief MAIN board: start a burst waveform capture on HPSB/LPSB and pull it into RAM through
+ *        master jobs (FC06 control, FC04 status and readout window). The PC reads the result
+ *        through the upstream H2TECH registers 4x2200.. (upstream_slave_h2tech.c).
+ */
+#ifndef CAPTURE_FETCH_H
+#define CAPTURE_FETCH_H
+
+#include "io_map.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CAPTURE_FETCH_MAX_DEPTH       256u    /* samples per channel MAIN can hold */
+#define CAPTURE_FETCH_BUF_SAMPLES     (SLAVE_CAPTURE_CH_COUNT * CAPTURE_FETCH_MAX_DEPTH)
+#define CAPTURE_FETCH_WAIT_MS         2000u   /* trigger-now: slave must finish within this */
+#define CAPTURE_FETCH_STATUS_POLL_MS  100u    /* status poll interval while waiting */
+#define CAPTURE_FETCH_RETRIES         3u      /* per transaction before giving up */
+
+typedef enum {
+    CAPTURE_FETCH_CMD_TRIGGER = 1,  /* trigger now, then fetch */
+    CAPTURE_FETCH_CMD_ARM     = 2,  /* arm the slave threshold trigger, fetch when it fires */
+    CAPTURE_FETCH_CMD_FETCH   = 3   /* fetch the capture already held by the slave */
+} CaptureFetchCmd_t;
+
+typedef enum {
+    CAPTURE_FETCH_IDLE = 0,
+    CAPTURE_FETCH_BUSY,
+    CAPTURE_FETCH_WAIT_TRIGGER,
+    CAPTURE_FETCH_DONE,
+    CAPTURE_FETCH_ERROR
+} CaptureFetchState_t;
+
+typedef struct {
+    SlaveId_t slave_id;
+    uint8_t   state;            /* CaptureFetchState_t */
+    uint16_t  count;            /* samples per channel */
+    uint16_t  period_us;
+    uint16_t  pretrig;          /* samples before the trigger point */
+    uint16_t  seq;              /* slave capture sequence number */
+    uint16_t  slave_status;     /* slave capture status register at fetch time */
+} CaptureFetchInfo_t;
+
+void     CaptureFetch_Init(void);
+/* Call from the downstream Modbus task: submits the next master job when one is due. */
+void     CaptureFetch_Poll(void);
+
+/* Returns -1 if a fetch is in progress or the slave/command is invalid. */
+int      CaptureFetch_Start(SlaveId_t slave, CaptureFetchCmd_t cmd);
+/* 0 if CaptureFetch_Start would accept the request now; nothing is started. */
+int      CaptureFetch_CanStart(SlaveId_t slave, CaptureFetchCmd_t cmd);
+void     CaptureFetch_GetInfo(CaptureFetchInfo_t *info);
+/* Copy fetched samples (channel-major: ch * count + n). Returns number copied. */
+uint16_t CaptureFetch_ReadSamples(uint16_t offset, uint16_t *out, uint16_t num);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAPTURE_FETCH_H */
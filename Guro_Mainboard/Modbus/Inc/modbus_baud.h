@@ -0,0 +1,47 @@
+/**
+ * @file modbus_baud.h
+ * @brief MAIN board: downstream RS485 speed negotiation. Stages a speed code on every slave that
+ *        currently answers (FC06 SLAVE_HOLDING_BAUD_CODE, acked at the old speed), commits it with
+ *        a broadcast FC06, switches USART1 and checks the per-slave link statistics. A failed check
+ *        or a degraded link returns MAIN to the default speed (the slaves follow on their own after
+ *        1 s without a valid frame) and the next attempt is made one code lower.
+ *        A slave that was absent during negotiation boots at the default speed; bus_enum.c finds
+ *        it with a probe at the default speed, stages and commits the active code on it alone and
+ *        adds it to the monitored members (ModbusBaud_AddMember).
+ */
+#ifndef MODBUS_BAUD_H
+#define MODBUS_BAUD_H
+
+#include "io_map.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    MODBUS_BAUD_ST_WAIT = 0,    /* at a settled speed, waiting to try a faster one */
+    MODBUS_BAUD_ST_STAGE,       /* unicast FC06 to each member slave */
+    MODBUS_BAUD_ST_COMMIT,      /* broadcast FC06 */
+    MODBUS_BAUD_ST_VERIFY,      /* switched, checking the link */
+    MODBUS_BAUD_ST_RUN          /* negotiated speed in use, link monitored */
+} ModbusBaudState_t;
+
+void     ModbusBaud_Init(void);
+/* Call from the downstream Modbus task after ModbusMaster_Poll. */
+void     ModbusBaud_Poll(void);
+
+uint8_t  ModbusBaud_GetState(void);     /* ModbusBaudState_t */
+uint8_t  ModbusBaud_GetCode(void);      /* active code, index into MODBUS_BAUD_TABLE */
+uint32_t ModbusBaud_GetBaud(void);
+uint32_t ModbusBaud_GetDefaultBaud(void);
+/* 1 while no negotiation is in progress (WAIT or RUN) */
+uint8_t  ModbusBaud_IsSettled(void);
+/* Monitor a slave brought to the active speed after the negotiation (hot-plugged) */
+void     ModbusBaud_AddMember(SlaveId_t slave);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MODBUS_BAUD_H */
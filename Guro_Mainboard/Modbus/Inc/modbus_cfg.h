@@ -18,12 +18,34 @@ extern "C" {
 
 /* Timing (character time at 9600 baud ~ 1.04 ms per char) */
 #define MODBUS_RESPONSE_TIMEOUT_MS    50
+#define MODBUS_PROBE_TIMEOUT_MS       10      /* FC17 enumeration probe: short, most addresses are empty */
 #define MODBUS_FRAME_DELAY_MS         5
 
 /* Buffer sizes */
 #define MODBUS_RTU_RX_BUF_SIZE        64
 #define MODBUS_RTU_TX_BUF_SIZE        64
 #define MODBUS_MAX_PDU_LEN            64
+#define MODBUS_MAX_READ_REGS          ((MODBUS_RTU_RX_BUF_SIZE - 5) / 2)   /* FC03/04 regs per response */
+
+#define MODBUS_BROADCAST_ADDR         0
+
+/* Bus enumeration (bus_enum.h) */
+#define MODBUS_ENUM_START_DELAY_MS    300u    /* slaves calibrate current offsets before answering */
+#define MODBUS_ENUM_PROBE_TRIES       2u      /* per address in the boot scan */
+#define MODBUS_ENUM_REPROBE_MS        250u    /* one absent address probed per period after boot */
+
+/* Downstream bus speed negotiation (modbus_baud.h). Codes index MODBUS_BAUD_TABLE and must
+ * match the slaves' modbus_cfg.h. */
+#define MODBUS_BAUD_TABLE             { 115200u, 230400u, 460800u, 921600u }
+#define MODBUS_BAUD_CODE_COUNT        4u
+#define MODBUS_BAUD_DEFAULT_CODE      0u      /* power-up speed of every board */
+#define MODBUS_BAUD_TARGET_CODE       3u      /* fastest code to try; 0 = stay at the default */
+#define MODBUS_BAUD_START_DELAY_MS    2000u   /* let the slaves answer at the default speed first */
+#define MODBUS_BAUD_RETRY_MS          10000u  /* after a failed attempt or a fallback (> slave fallback 1 s) */
+#define MODBUS_BAUD_VERIFY_MS         1000u   /* link check window right after switching */
+#define MODBUS_BAUD_MONITOR_MS        5000u   /* link check window while running fast */
+#define MODBUS_BAUD_VERIFY_MIN_OK     5u      /* good responses per slave needed to pass the verify window */
+#define MODBUS_BAUD_MAX_ERR_PCT       5u      /* timeouts + bad frames allowed, percent of transactions */
 
 #ifdef __cplusplus
 }
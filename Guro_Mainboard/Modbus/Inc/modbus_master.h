@@ -16,14 +16,37 @@ extern "C" {
 void ModbusMaster_Init(void);
 void ModbusMaster_Poll(void);
 
-/* Optional: request write (queued or immediate). Use enum addresses. */
-int ModbusMaster_WriteCoil(SlaveId_t slave, uint16_t coil_addr, uint8_t value);
-int ModbusMaster_WriteHoldingReg(SlaveId_t slave, uint16_t reg_addr, uint16_t value);
+/* Job slot: one extra transaction (FC03/FC04 read, FC05/FC06 write, FC17 probe) run before the next poll entry.
+ * cb(0, regs, num) on success (writes: the slave echoed the request), cb(-1, NULL, 0) on
+ * timeout/exception/bad frame; called from
+ * ModbusMaster_Poll with the slot already free. Returns -1 if a job is queued or in flight.
+ * slave_id MODBUS_BROADCAST_ADDR is allowed for FC06: cb(0) once the frame is out. */
+typedef void (*ModbusMasterJobCb_t)(int result, const uint16_t *regs, uint16_t num);
+int     ModbusMaster_SubmitJob(const PollEntry_t *req, ModbusMasterJobCb_t cb);
+/* Same, with USART1 switched to baud for this one transaction and back afterwards (bus_enum.c:
+ * a hot-plugged board answers at the default speed). baud 0 = the current bus speed. */
+int     ModbusMaster_SubmitJobAtBaud(const PollEntry_t *req, ModbusMasterJobCb_t cb, uint32_t baud);
+uint8_t ModbusMaster_IsJobBusy(void);
 
 /* Communication status for application */
 uint8_t ModbusMaster_GetLastSlaveResponded(void);
 uint8_t ModbusMaster_IsCommOk(SlaveId_t slave);
 
+/* Per-slave transaction counters since boot (free-running, compare deltas) */
+typedef struct {
+    uint32_t ok;
+    uint32_t timeout;
+    uint32_t bad_frame;     /* short frame, CRC or parse error */
+    uint32_t exception;
+} ModbusLinkStats_t;
+void ModbusMaster_GetLinkStats(SlaveId_t slave, ModbusLinkStats_t *out);
+
+/* Reconfigure USART1 (modbus_baud.c). Any transaction in flight is dropped. Returns 0 on success. */
+int  ModbusMaster_SetBaud(uint32_t baud);
+
+/* USART1 idle-line RX event, dispatched to the main loop by uart_dispatch.c */
+void ModbusMaster_UART_RxEventCallback(uint16_t Size);
+
 #ifdef __cplusplus
 }
 #endif
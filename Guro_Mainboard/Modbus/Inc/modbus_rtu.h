@@ -29,6 +29,8 @@ size_t ModbusRTU_BuildFC05(uint8_t *pdu, uint8_t slave_addr, uint16_t coil_addr,
 size_t ModbusRTU_BuildFC06(uint8_t *pdu, uint8_t slave_addr, uint16_t reg_addr, uint16_t value);
 size_t ModbusRTU_BuildFC15(uint8_t *pdu, uint8_t slave_addr, uint16_t start_addr, const uint8_t *coil_bytes, uint16_t num_coils);
 size_t ModbusRTU_BuildFC16(uint8_t *pdu, uint8_t slave_addr, uint16_t start_addr, const uint16_t *regs, uint16_t num_regs);
+size_t ModbusRTU_BuildFC24(uint8_t *pdu, uint8_t slave_addr, uint16_t fifo_ptr);
+size_t ModbusRTU_BuildFC17(uint8_t *pdu, uint8_t slave_addr);
 
 /* Coil/Discrete packing: LSB-first, 8 bits per byte. Bits 0..7 -> byte[0], etc. */
 void ModbusRTU_PackCoilsLSB(const uint8_t *coil_bits, uint16_t num_bits, uint8_t *bytes);
@@ -39,6 +41,9 @@ int ModbusRTU_ParseFC01Response(const uint8_t *frame, size_t frame_len, uint8_t
 int ModbusRTU_ParseFC02Response(const uint8_t *frame, size_t frame_len, uint8_t *discrete_bits, uint16_t num_bits);
 int ModbusRTU_ParseFC03Response(const uint8_t *frame, size_t frame_len, uint16_t *regs, uint16_t num_regs);
 int ModbusRTU_ParseFC04Response(const uint8_t *frame, size_t frame_len, uint16_t *regs, uint16_t num_regs);
+int ModbusRTU_ParseFC24Response(const uint8_t *frame, size_t frame_len, uint16_t *regs, uint16_t max_regs, uint16_t *num_regs);
+/* FC17 Report Slave ID: copies up to max_len data bytes (slave id, run indicator, additional data) */
+int ModbusRTU_ParseFC17Response(const uint8_t *frame, size_t frame_len, uint8_t *data, uint8_t max_len, uint8_t *len);
 
 /* --- Slave: response builders (PDU without CRC). Return PDU length. --- */
 size_t ModbusRTU_BuildFC01Response(uint8_t *pdu, uint8_t slave_addr, const uint8_t *coil_bytes, uint16_t num_coils);
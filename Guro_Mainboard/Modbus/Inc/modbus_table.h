@@ -7,6 +7,7 @@
 #define MODBUS_TABLE_MAIN_H
 
 #include "io_map.h"
+#include "slave_registry.h"
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -19,6 +20,10 @@ typedef enum {
     POLL_ENTRY_READ_COIL,
     POLL_ENTRY_READ_HOLDING,
     POLL_ENTRY_READ_INPUT_REG,
+    POLL_ENTRY_READ_EVENTS,     /* FC24 event FIFO drain */
+    POLL_ENTRY_WRITE_HOLDING,   /* FC06, master jobs only (not in the poll table) */
+    POLL_ENTRY_REPORT_ID,       /* FC17 enumeration probe, master jobs only; one data byte per reg */
+    POLL_ENTRY_WRITE_COIL,      /* FC05, master jobs only; value 0/1 */
     POLL_ENTRY_COUNT
 } PollEntryType_t;
 
@@ -27,15 +32,27 @@ typedef struct {
     PollEntryType_t   entry_type;
     uint16_t         start_addr;
     uint16_t         count;
+    uint16_t         value;     /* POLL_ENTRY_WRITE_HOLDING: register value, POLL_ENTRY_WRITE_COIL: 0/1 */
 } PollEntry_t;
 
-/* Number of poll entries in the table (one per slave per read type) */
-#define POLL_TABLE_SIZE   (SLAVE_ID_COUNT * 4)   /* HPSB: 4 read types, LPSB: 4 read types */
+/* Poll table capacity; the table itself is built from the enumerated slaves */
+#define POLL_ENTRIES_PER_SLAVE  5u      /* 4 area reads + event FIFO */
+#define POLL_TABLE_MAX          (SLAVE_ADDR_MAX * POLL_ENTRIES_PER_SLAVE)
 
-/* Get poll entry by index (0 .. POLL_TABLE_SIZE-1). Returns 0 on success. */
-int ModbusTable_GetPollEntry(uint8_t index, PollEntry_t *entry);
+/* Rebuild the poll table from the slave registry, in address order */
+void    ModbusTable_BuildPollTable(void);
+uint8_t ModbusTable_GetPollCount(void);
+/* Get poll entry by index (0 .. ModbusTable_GetPollCount()-1). Returns 0 on success. */
+int     ModbusTable_GetPollEntry(uint8_t index, PollEntry_t *entry);
 
-/* Slave image buffers: updated by Modbus Master when response received */
+/* Slave images (slave_registry.h): updated by Modbus Master when response received.
+ * Consumers take one snapshot per slave and read its fields directly; the view stays consistent
+ * while the master keeps publishing (see ModbusTable_SnapshotValid). */
+int      ModbusTable_GetSnapshot(SlaveId_t slave, SlaveSnapshot_t *snap);
+uint8_t  ModbusTable_SnapshotValid(const SlaveSnapshot_t *snap);
+
+/* Single-field access (one snapshot / one publish per call). Reads of unregistered slaves or
+ * indices beyond the board type's counts return 0. */
 uint8_t  ModbusTable_GetDiscrete(SlaveId_t slave, uint16_t bit_index);
 uint8_t  ModbusTable_GetCoil(SlaveId_t slave, uint16_t bit_index);
 uint16_t ModbusTable_GetHoldingReg(SlaveId_t slave, uint16_t reg_index);
@@ -52,8 +69,52 @@ void ModbusTable_SetCoilBytes(SlaveId_t slave, const uint8_t *bytes, uint16_t nu
 void ModbusTable_SetHoldingRegs(SlaveId_t slave, uint16_t start, const uint16_t *regs, uint16_t num);
 void ModbusTable_SetInputRegs(SlaveId_t slave, uint16_t start, const uint16_t *regs, uint16_t num);
 
+/* Time since the area was last updated from a slave response (or a confirmed write).
+ * MODBUS_AGE_NEVER if it never was, or the slave is not registered. */
+#define MODBUS_AGE_NEVER  0xFFFFFFFFu
+uint32_t ModbusTable_GetAgeMs(SlaveId_t slave, SlaveArea_t area);
+
 void ModbusTable_ClearAllImages(void);
 
+/* Slave event FIFO (FC24). Each event = 4 regs: [seq][type<<8 | index][value][slave tick ms]. */
+#define MODBUS_EVENT_REGS_PER_EVENT   4u
+#define MODBUS_EVENT_MAX_PER_READ     7u
+#define MODBUS_EVENT_LOG_SIZE         32u
+
+/* Event types reported by HPSB/LPSB (event_fifo.h on the slaves) */
+#define SLAVE_EVENT_BOOT      0u
+#define SLAVE_EVENT_DISCRETE  1u
+#define SLAVE_EVENT_COIL      2u
+#define SLAVE_EVENT_ALARM     3u
+
+typedef struct {
+    SlaveId_t slave_id;
+    uint8_t   type;
+    uint8_t   index;
+    uint16_t  value;
+    uint16_t  seq;
+    uint16_t  slave_tick;
+} SlaveEvent_t;
+
+/* FIFO pointer for the next FC24 read: sequence number MAIN expects next from this slave */
+uint16_t ModbusTable_GetEventCursor(SlaveId_t slave);
+/* Store events from an FC24 response; advances the cursor and counts sequence gaps as lost */
+void     ModbusTable_PushSlaveEvents(SlaveId_t slave, const uint16_t *regs, uint16_t num_regs);
+/* Pop oldest drained event (all slaves, arrival order). Returns 0 if one was returned. */
+int      ModbusTable_PopSlaveEvent(SlaveEvent_t *ev);
+/* Oldest event without removing it, and its log number (counts up by one per event logged).
+ * Returns 0 if there is one. */
+int      ModbusTable_PeekSlaveEvent(SlaveEvent_t *ev, uint16_t *log_seq);
+/* Drop the events up to and including log number log_seq; a repeated ack drops nothing more.
+ * Returns the number dropped, -1 if log_seq is past the newest event (e.g. from before a reset). */
+int      ModbusTable_AckSlaveEvents(uint16_t log_seq);
+/* 0 if ModbusTable_AckSlaveEvents(log_seq) would be accepted, -1 if not; drops nothing */
+int      ModbusTable_CanAckSlaveEvents(uint16_t log_seq);
+uint16_t ModbusTable_GetSlaveEventCount(void);
+/* Events of this slave lost: sequence gaps (slave FIFO overflow) plus events overwritten in the
+ * MAIN log before they were read */
+uint16_t ModbusTable_GetSlaveEventsLost(SlaveId_t slave);
+
 #ifdef __cplusplus
 }
 #endif
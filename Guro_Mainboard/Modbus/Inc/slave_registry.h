@@ -0,0 +1,106 @@
+/**
+ * @file slave_registry.h
+ * @brief MAIN board: storage for the images of the enumerated sub-boards. Up to
+ *        SLAVE_REGISTRY_ADDR_MAX addresses; each registered slave gets a slot from the pool of its
+ *        type, laid out with that board's real register counts (LPSB keeps 4 input regs, not 7).
+ *        Lookup by address is one index read: slot_of[addr]. Discrete inputs and coils are kept
+ *        as bitmaps. The RAM taken by the pools is SLAVE_REGISTRY_RAM_BYTES and is printed when
+ *        slave_registry.c is compiled; exceeding SLAVE_REGISTRY_RAM_BUDGET fails the build.
+ *
+ *        Each slot holds two copies of the image and a sequence counter. The writer (Modbus
+ *        master) copies the published image into the other buffer, updates it and publishes it by
+ *        bumping the counter; the published buffer is (seq >> 1) & 1, so publishing is one store.
+ *        Readers take a snapshot (pointers into the published buffer plus the seq it was taken
+ *        at), read fields directly and may check SlaveRegistry_SnapshotValid() afterwards: it is
+ *        false once the writer has started reusing the snapshot's buffer.
+ */
+#ifndef SLAVE_REGISTRY_H
+#define SLAVE_REGISTRY_H
+
+#include "io_map.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Pool sizes per board type; together at most SLAVE_REGISTRY_ADDR_MAX */
+#define SLAVE_REGISTRY_ADDR_MAX     SLAVE_ADDR_MAX
+#define SLAVE_REGISTRY_HPSB_MAX     4u
+#define SLAVE_REGISTRY_LPSB_MAX     28u
+#define SLAVE_REGISTRY_RAM_BUDGET   2048u
+
+/* Real register counts per board type (slave io_map.h) */
+#define SLAVE_BITS_COUNT            8u      /* discrete inputs / coils, one bitmap byte each */
+#define SLAVE_HOLDING_COUNT         MODBUS_HOLDING_COUNT
+#define SLAVE_HPSB_INPUT_COUNT      MODBUS_HPSB_INPUT_POLL_COUNT
+#define SLAVE_LPSB_INPUT_COUNT      MODBUS_LPSB_INPUT_POLL_COUNT
+
+/* Part of the image common to every board type */
+typedef struct {
+    uint8_t  discrete;              /* bit n = discrete input n */
+    uint8_t  coils;                 /* bit n = coil n */
+    uint16_t holding[SLAVE_HOLDING_COUNT];
+} SlaveImageHead_t;
+
+/* Read-only view of one published slave image */
+typedef struct {
+    const SlaveImageHead_t *head;
+    const uint16_t         *input;
+    const uint32_t         *stamp;          /* [SlaveArea_t]: HAL tick of the last update, 0 = never */
+    uint16_t                input_count;
+    uint16_t                seq;            /* writer sequence the view was taken at */
+    SlaveId_t               slave;
+} SlaveSnapshot_t;
+
+/* Writable view of the back buffer, between BeginWrite and Publish */
+typedef struct {
+    SlaveImageHead_t *head;
+    uint16_t         *input;
+    uint16_t          input_count;
+} SlaveImageWrite_t;
+
+/* FC24 bookkeeping, owned by the master (not double-buffered) */
+typedef struct {
+    uint16_t cursor;                /* next sequence number expected */
+    uint16_t lost;
+} SlaveEventTrack_t;
+
+/* Slot sizes, checked against the structs in slave_registry.c */
+#define SLAVE_HPSB_SLOT_BYTES       72u     /* stamps 16 + 2 x (head 10 + 7 input regs) + events 4 + seq 2 + pad 2 */
+#define SLAVE_LPSB_SLOT_BYTES       60u     /* stamps 16 + 2 x (head 10 + 4 input regs) + events 4 + seq 2 + pad 2 */
+#define SLAVE_REGISTRY_RAM_BYTES    (SLAVE_REGISTRY_HPSB_MAX * SLAVE_HPSB_SLOT_BYTES + \
+                                     SLAVE_REGISTRY_LPSB_MAX * SLAVE_LPSB_SLOT_BYTES + \
+                                     SLAVE_REGISTRY_ADDR_MAX + 1u)
+
+/* Forget every slave and clear all images */
+void     SlaveRegistry_Init(void);
+/* Give slave a slot of its type. 0 on success (also if already registered with that type),
+ * -1 for a bad address/type or a full pool. */
+int      SlaveRegistry_Add(SlaveId_t slave, uint8_t type);
+uint8_t  SlaveRegistry_GetType(SlaveId_t slave);    /* SlaveType_t, NONE if not registered */
+uint8_t  SlaveRegistry_GetCount(void);
+/* Clear the images of every registered slave (registrations are kept) */
+void     SlaveRegistry_ClearImages(void);
+
+/* Reader side. 0 with a view of the published image, or -1 if slave is not registered (the
+ * view then shows an all-zero image with input_count 0). */
+int      SlaveRegistry_Snapshot(SlaveId_t slave, SlaveSnapshot_t *snap);
+/* 1 while the writer has not started reusing the snapshot's buffer */
+uint8_t  SlaveRegistry_SnapshotValid(const SlaveSnapshot_t *snap);
+
+/* Writer side (single writer). BeginWrite gives the back buffer holding a copy of the published
+ * image, Publish makes it the published one. BeginWrite returns -1 if slave is not registered. */
+int      SlaveRegistry_BeginWrite(SlaveId_t slave, SlaveImageWrite_t *w);
+void     SlaveRegistry_Publish(SlaveId_t slave);
+/* Record when an area was last acquired (tick 0 is stored as 1; 0 means never) */
+void     SlaveRegistry_Stamp(SlaveId_t slave, SlaveArea_t area, uint32_t tick);
+
+/* NULL if slave is not registered */
+SlaveEventTrack_t *SlaveRegistry_EventTrack(SlaveId_t slave);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SLAVE_REGISTRY_H */
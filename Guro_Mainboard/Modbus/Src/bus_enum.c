@@ -0,0 +1,300 @@
+/**
+ * @file bus_enum.c
+ * @brief MAIN board: boot scan (FC17 on every address, MODBUS_ENUM_PROBE_TRIES each), then a slow
+ *        round-robin re-probe of the absent addresses. Probes run in the master job slot.
+ *        An answer is only taken after a second probe returns the same id; a garbled answer or
+ *        two different ids mean two boards share the address, which is flagged, not registered.
+ *        Probes go out at the default speed, where a freshly powered board listens. If the bus
+ *        has been negotiated faster, a new board gets the active code staged and committed at the
+ *        default speed (a join) and is registered once it answers at the active speed.
+ */
+#include "bus_enum.h"
+#include "modbus_master.h"
+#include "modbus_baud.h"
+#include "modbus_table.h"
+#include "slave_registry.h"
+#include "modbus_cfg.h"
+#include "dirty_flags.h"
+#include "main.h"
+#include <string.h>
+
+#define SLAVE_TO_INDEX(s)  ((uint8_t)((s) - SLAVE_ID_FIRST))
+
+typedef enum {
+    ANSWER_NONE,            /* timeout or exception */
+    ANSWER_OK,
+    ANSWER_GARBLED          /* short frame or bad CRC: several boards answering at once */
+} Answer_t;
+
+typedef enum {
+    JOIN_NONE,
+    JOIN_STAGE,             /* FC06 BAUD_CODE to the new board, default speed */
+    JOIN_COMMIT,            /* broadcast FC06 BAUD_CODE, default speed: only the new board hears it */
+    JOIN_CHECK              /* FC17 at the active speed */
+} JoinStep_t;
+
+/* Board id from one FC17 answer */
+typedef struct {
+    uint8_t  type;
+    uint8_t  dip;
+    uint16_t uid;
+} ProbeId_t;
+
+static uint8_t  dip[SLAVE_ID_COUNT];        /* 0 = address SLAVE_ID_FIRST */
+static uint32_t collision_mask;             /* bit n = address SLAVE_ID_FIRST + n */
+static uint8_t  scan_done;
+static uint8_t  probe_idx;
+static uint8_t  reprobe_next;
+static uint8_t  tries;
+static uint8_t  in_flight;
+static uint8_t  probe_done;
+static uint8_t  probe_found;
+static uint8_t  confirming;                 /* first answer in first_id, second probe in flight */
+static JoinStep_t join_step;
+static Answer_t answer;
+static ProbeId_t first_id;
+static ProbeId_t answer_id;
+static uint32_t bad_base;                   /* bad_frame count of the probed address at submit */
+static uint32_t due_tick;
+
+static void on_probe(int result, const uint16_t *regs, uint16_t num)
+{
+    ModbusLinkStats_t ls;
+
+    in_flight = 0;
+    probe_done = 1;
+    if (result == 0 && num >= SLAVE_REPORT_ID_LEN) {
+        answer_id.type = (uint8_t)regs[0];
+        answer_id.dip = (uint8_t)regs[SLAVE_REPORT_ID_DIP];
+        answer_id.uid = (uint16_t)(regs[SLAVE_REPORT_ID_UID_LO] | (regs[SLAVE_REPORT_ID_UID_HI] << 8));
+        answer = ANSWER_OK;
+        return;
+    }
+    ModbusMaster_GetLinkStats((SlaveId_t)(SLAVE_ID_FIRST + probe_idx), &ls);
+    answer = (ls.bad_frame != bad_base) ? ANSWER_GARBLED : ANSWER_NONE;
+}
+
+static void on_join(int result, const uint16_t *regs, uint16_t num)
+{
+    (void)regs;
+    (void)num;
+    in_flight = 0;
+    probe_done = 1;
+    answer = (result == 0) ? ANSWER_OK : ANSWER_NONE;
+}
+
+/* FC17 at baud (0 = the active bus speed) */
+static void probe_at(uint8_t idx, uint32_t baud)
+{
+    PollEntry_t req = { (SlaveId_t)(SLAVE_ID_FIRST + idx), POLL_ENTRY_REPORT_ID, 0, 0, 0 };
+    ModbusLinkStats_t ls;
+
+    ModbusMaster_GetLinkStats(req.slave_id, &ls);
+    probe_idx = idx;
+    if (ModbusMaster_SubmitJobAtBaud(&req, on_probe, baud) == 0) {
+        in_flight = 1;      /* otherwise the job slot is busy: retried on the next poll */
+        probe_done = 0;
+        probe_found = 0;
+        answer = ANSWER_NONE;
+        bad_base = ls.bad_frame;
+    }
+}
+
+static void probe(uint8_t idx)
+{
+    probe_at(idx, ModbusBaud_GetDefaultBaud());
+}
+
+static void submit_baud_code(uint8_t addr)
+{
+    PollEntry_t req = { (SlaveId_t)addr, POLL_ENTRY_WRITE_HOLDING, SLAVE_HOLDING_BAUD_CODE, 0, ModbusBaud_GetCode() };
+    if (ModbusMaster_SubmitJobAtBaud(&req, on_join, ModbusBaud_GetDefaultBaud()) == 0) {
+        in_flight = 1;
+        probe_done = 0;
+    }
+}
+
+static uint8_t same_id(const ProbeId_t *a, const ProbeId_t *b)
+{
+    return (a->type == b->type && a->dip == b->dip && a->uid == b->uid) ? 1 : 0;
+}
+
+static void set_collision(uint8_t idx, uint8_t on)
+{
+    uint32_t bit = 1uL << idx;
+    if (((collision_mask & bit) != 0) == (on != 0)) return;
+    collision_mask = on ? (collision_mask | bit) : (collision_mask & ~bit);
+    DirtyFlags_Mark(DIRTY_COMM);
+}
+
+static void add_board(void)
+{
+    /* Unknown type or full registry pool: left out, and probed again later */
+    if (SlaveRegistry_Add((SlaveId_t)(SLAVE_ID_FIRST + probe_idx), answer_id.type) != 0) return;
+    dip[probe_idx] = answer_id.dip;
+    set_collision(probe_idx, 0);
+    probe_found = 1;
+    DirtyFlags_Mark(DIRTY_COMM);        /* a newly present board counts for the comm alarms */
+}
+
+/* Next step of a join. A board left staged or switched by a failed join drops back to the default
+ * speed on its own within 1 s and is probed again later. Returns 1 while a step is in flight. */
+static uint8_t join_next(void)
+{
+    JoinStep_t step = join_step;
+
+    join_step = JOIN_NONE;
+    if (answer != ANSWER_OK) return 0;
+    switch (step) {
+        case JOIN_STAGE:
+            submit_baud_code(MODBUS_BROADCAST_ADDR);
+            join_step = JOIN_COMMIT;
+            break;
+        case JOIN_COMMIT:
+            probe_at(probe_idx, 0);
+            join_step = JOIN_CHECK;
+            break;
+        case JOIN_CHECK:
+            if (same_id(&answer_id, &first_id)) {
+                add_board();
+                if (probe_found) ModbusBaud_AddMember((SlaveId_t)(SLAVE_ID_FIRST + probe_idx));
+            }
+            return 0;
+        default:
+            return 0;
+    }
+    if (!in_flight) join_step = JOIN_NONE;
+    return (join_step != JOIN_NONE) ? 1 : 0;
+}
+
+/* Evaluate the finished job. Returns 1 while a confirming probe or a join step is in flight. A
+ * board is registered (probe_found) only when two probes in a row return the same id. */
+static uint8_t take_answer(void)
+{
+    if (join_step != JOIN_NONE) return join_next();
+    if (answer == ANSWER_GARBLED) {
+        confirming = 0;
+        set_collision(probe_idx, 1);
+        return 0;
+    }
+    if (answer == ANSWER_NONE) {
+        confirming = 0;         /* absent, or gone before the confirmation: probed again later */
+        return 0;
+    }
+    if (!confirming) {
+        first_id = answer_id;
+        probe(probe_idx);
+        confirming = in_flight;
+        return confirming;
+    }
+    confirming = 0;
+    if (!same_id(&answer_id, &first_id)) {
+        set_collision(probe_idx, 1);    /* two boards taking turns at winning the bus */
+        return 0;
+    }
+    if (ModbusBaud_GetCode() == MODBUS_BAUD_DEFAULT_CODE) {
+        add_board();
+        return 0;
+    }
+    /* The bus runs faster than the default the new board booted at */
+    submit_baud_code((uint8_t)(SLAVE_ID_FIRST + probe_idx));
+    join_step = in_flight ? JOIN_STAGE : JOIN_NONE;
+    return in_flight;
+}
+
+void BusEnum_Init(void)
+{
+    SlaveRegistry_Init();
+    memset(dip, 0, sizeof(dip));
+    collision_mask = 0;
+    scan_done = 0;
+    probe_idx = 0;
+    reprobe_next = 0;
+    tries = 0;
+    in_flight = 0;
+    probe_done = 0;
+    probe_found = 0;
+    confirming = 0;
+    join_step = JOIN_NONE;
+    answer = ANSWER_NONE;
+    due_tick = HAL_GetTick() + MODBUS_ENUM_START_DELAY_MS;
+}
+
+void BusEnum_Poll(void)
+{
+    uint32_t now = HAL_GetTick();
+
+    if (in_flight || (int32_t)(now - due_tick) < 0) return;
+
+    if (!scan_done) {
+        if (probe_done) {
+            probe_done = 0;
+            if (take_answer()) return;
+            if (probe_found || (collision_mask & (1uL << probe_idx)) || ++tries >= MODBUS_ENUM_PROBE_TRIES) {
+                tries = 0;
+                if (probe_idx + 1u >= SLAVE_ID_COUNT) {
+                    ModbusTable_BuildPollTable();
+                    scan_done = 1;
+                    due_tick = now + MODBUS_ENUM_REPROBE_MS;
+                    return;
+                }
+                probe_idx++;
+            }
+        }
+        probe(probe_idx);
+        return;
+    }
+
+    if (probe_done) {
+        probe_done = 0;
+        if (take_answer()) return;
+        if (probe_found) ModbusTable_BuildPollTable();
+        due_tick = now + MODBUS_ENUM_REPROBE_MS;
+        return;
+    }
+    if (!ModbusBaud_IsSettled()) {
+        due_tick = now + MODBUS_ENUM_REPROBE_MS;    /* no default-speed probes mid-negotiation */
+        return;
+    }
+    for (uint8_t n = 0; n < SLAVE_ID_COUNT; n++) {
+        uint8_t idx = reprobe_next;
+        reprobe_next = (uint8_t)((reprobe_next + 1u) % SLAVE_ID_COUNT);
+        if (SlaveRegistry_GetType((SlaveId_t)(SLAVE_ID_FIRST + idx)) == SLAVE_TYPE_NONE) {
+            probe(idx);
+            return;
+        }
+    }
+    due_tick = now + MODBUS_ENUM_REPROBE_MS;    /* everything present */
+}
+
+uint8_t BusEnum_IsScanDone(void)
+{
+    return scan_done;
+}
+
+uint8_t BusEnum_IsPresent(SlaveId_t slave)
+{
+    return (BusEnum_GetType(slave) != SLAVE_TYPE_NONE) ? 1 : 0;
+}
+
+uint8_t BusEnum_GetType(SlaveId_t slave)
+{
+    return SlaveRegistry_GetType(slave);
+}
+
+uint8_t BusEnum_IsCollision(SlaveId_t slave)
+{
+    if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST) return 0;
+    return (collision_mask & (1uL << SLAVE_TO_INDEX(slave))) ? 1 : 0;
+}
+
+uint32_t BusEnum_GetCollisionMask(void)
+{
+    return collision_mask;
+}
+
+uint8_t BusEnum_GetDip(SlaveId_t slave)
+{
+    if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST) return 0;
+    return dip[SLAVE_TO_INDEX(slave)];
+}
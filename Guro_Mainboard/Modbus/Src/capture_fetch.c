@@ -0,0 +1,190 @@
+/**
+ * @file capture_fetch.c
+ * @brief MAIN board: capture fetch sequence, one master job at a time:
+ *        FC06 CAPTURE_CTRL -> FC04 status (repeat until done) -> { FC06 CAPTURE_OFFSET = fetched ->
+ *        FC04 window } until count * 3 samples are in RAM. The slave advances its offset on every
+ *        window read, so the offset is written again before each window (and each retry): a window
+ *        whose response was lost cannot shift the samples that follow.
+ *        Jobs are submitted from CaptureFetch_Poll so they interleave with the poll table.
+ */
+#include "capture_fetch.h"
+#include "modbus_master.h"
+#include "main.h"
+
+typedef enum {
+    STEP_CMD,
+    STEP_STATUS,
+    STEP_OFFSET,
+    STEP_WINDOW
+} FetchStep_t;
+
+static uint16_t samples[CAPTURE_FETCH_BUF_SAMPLES];
+static CaptureFetchInfo_t info;
+static CaptureFetchCmd_t  cmd;
+static FetchStep_t step;
+static uint8_t  in_flight;
+static uint8_t  retries;
+static uint16_t fetched;
+static uint32_t start_tick;
+static uint32_t due_tick;
+
+static void fail(void)
+{
+    info.state = CAPTURE_FETCH_ERROR;
+}
+
+static void on_status(const uint16_t *regs)
+{
+    uint32_t now = HAL_GetTick();
+
+    info.slave_status = regs[0];
+    info.count        = regs[1];
+    info.period_us    = regs[2];
+    info.pretrig      = regs[3];
+    info.seq          = regs[4];
+
+    if ((info.slave_status & SLAVE_CAPTURE_STATE_MASK) == SLAVE_CAPTURE_STATE_DONE) {
+        if (info.count == 0 || info.count > CAPTURE_FETCH_MAX_DEPTH) {
+            fail();
+            return;
+        }
+        info.state = CAPTURE_FETCH_BUSY;
+        fetched = 0;
+        step = STEP_OFFSET;
+        return;
+    }
+    if (cmd == CAPTURE_FETCH_CMD_FETCH ||
+        (cmd == CAPTURE_FETCH_CMD_TRIGGER && (now - start_tick) >= CAPTURE_FETCH_WAIT_MS)) {
+        fail();
+        return;
+    }
+    if (cmd == CAPTURE_FETCH_CMD_ARM) info.state = CAPTURE_FETCH_WAIT_TRIGGER;
+    due_tick = now + CAPTURE_FETCH_STATUS_POLL_MS;
+}
+
+static void on_result(int result, const uint16_t *regs, uint16_t num)
+{
+    in_flight = 0;
+    if (result != 0) {
+        if (++retries > CAPTURE_FETCH_RETRIES) fail();
+        if (step == STEP_WINDOW) step = STEP_OFFSET;
+        return;     /* resubmitted by the next CaptureFetch_Poll */
+    }
+    /* Offset write + window count as one transaction for the retry limit */
+    if (step != STEP_OFFSET) retries = 0;
+
+    switch (step) {
+        case STEP_CMD:
+            step = STEP_STATUS;
+            break;
+        case STEP_STATUS:
+            if (num < SLAVE_INPUT_REG_CAPTURE_INFO_COUNT) { fail(); break; }
+            on_status(regs);
+            break;
+        case STEP_OFFSET:
+            step = STEP_WINDOW;
+            break;
+        case STEP_WINDOW:
+            for (uint16_t i = 0; i < num && fetched < CAPTURE_FETCH_BUF_SAMPLES; i++)
+                samples[fetched++] = regs[i];
+            if (fetched >= (uint16_t)(info.count * SLAVE_CAPTURE_CH_COUNT))
+                info.state = CAPTURE_FETCH_DONE;
+            else
+                step = STEP_OFFSET;
+            break;
+        default:
+            fail();
+            break;
+    }
+}
+
+void CaptureFetch_Init(void)
+{
+    info.slave_id = SLAVE_ID_HPSB;
+    info.state = CAPTURE_FETCH_IDLE;
+    info.count = 0;
+    info.period_us = 0;
+    info.pretrig = 0;
+    info.seq = 0;
+    info.slave_status = 0;
+    in_flight = 0;
+    retries = 0;
+    fetched = 0;
+}
+
+void CaptureFetch_Poll(void)
+{
+    PollEntry_t req = { info.slave_id, POLL_ENTRY_READ_INPUT_REG, 0, 0, 0 };
+
+    if (in_flight) return;
+    if (info.state != CAPTURE_FETCH_BUSY && info.state != CAPTURE_FETCH_WAIT_TRIGGER) return;
+    if (step == STEP_STATUS && (int32_t)(HAL_GetTick() - due_tick) < 0) return;
+
+    switch (step) {
+        case STEP_CMD:
+            req.entry_type = POLL_ENTRY_WRITE_HOLDING;
+            req.start_addr = SLAVE_HOLDING_CAPTURE_CTRL;
+            req.value = (cmd == CAPTURE_FETCH_CMD_ARM) ? SLAVE_CAPTURE_CMD_ARM : SLAVE_CAPTURE_CMD_TRIGGER;
+            break;
+        case STEP_STATUS:
+            req.start_addr = SLAVE_INPUT_REG_CAPTURE_STATUS;
+            req.count = SLAVE_INPUT_REG_CAPTURE_INFO_COUNT;
+            break;
+        case STEP_OFFSET:
+            req.entry_type = POLL_ENTRY_WRITE_HOLDING;
+            req.start_addr = SLAVE_HOLDING_CAPTURE_OFFSET;
+            req.value = fetched;
+            break;
+        case STEP_WINDOW: {
+            uint16_t left = (uint16_t)(info.count * SLAVE_CAPTURE_CH_COUNT - fetched);
+            req.start_addr = SLAVE_CAPTURE_WINDOW_START;
+            req.count = (left < SLAVE_CAPTURE_WINDOW_REGS) ? left : SLAVE_CAPTURE_WINDOW_REGS;
+            break;
+        }
+        default:
+            fail();
+            return;
+    }
+    if (ModbusMaster_SubmitJob(&req, on_result) == 0)
+        in_flight = 1;
+}
+
+int CaptureFetch_CanStart(SlaveId_t slave, CaptureFetchCmd_t c)
+{
+    if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST) return -1;
+    if (c != CAPTURE_FETCH_CMD_TRIGGER && c != CAPTURE_FETCH_CMD_ARM && c != CAPTURE_FETCH_CMD_FETCH) return -1;
+    if (in_flight || info.state == CAPTURE_FETCH_BUSY) return -1;
+    return 0;
+}
+
+int CaptureFetch_Start(SlaveId_t slave, CaptureFetchCmd_t c)
+{
+    if (CaptureFetch_CanStart(slave, c) != 0) return -1;
+
+    info.slave_id = slave;
+    info.state = CAPTURE_FETCH_BUSY;
+    info.count = 0;
+    cmd = c;
+    step = (c == CAPTURE_FETCH_CMD_FETCH) ? STEP_STATUS : STEP_CMD;
+    retries = 0;
+    fetched = 0;
+    start_tick = HAL_GetTick();
+    due_tick = start_tick;
+    return 0;
+}
+
+void CaptureFetch_GetInfo(CaptureFetchInfo_t *out)
+{
+    if (out) *out = info;
+}
+
+uint16_t CaptureFetch_ReadSamples(uint16_t offset, uint16_t *out, uint16_t num)
+{
+    uint16_t n = 0;
+    if (info.state != CAPTURE_FETCH_DONE || out == NULL) return 0;
+    while (n < num && (uint16_t)(offset + n) < fetched) {
+        out[n] = samples[offset + n];
+        n++;
+    }
+    return n;
+}
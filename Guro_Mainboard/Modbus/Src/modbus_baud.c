@@ -0,0 +1,201 @@
+/**
+ * @file modbus_baud.c
+ * @brief MAIN board: downstream RS485 speed negotiation through master jobs:
+ *        FC06 BAUD_CODE to each member slave -> broadcast FC06 BAUD_CODE -> switch USART1 ->
+ *        verify window -> monitored run. Any failure falls back to MODBUS_BAUD_DEFAULT_CODE.
+ */
+#include "modbus_baud.h"
+#include "modbus_master.h"
+#include "modbus_cfg.h"
+#include "main.h"
+
+typedef enum {
+    LINK_GOOD,
+    LINK_SILENT,        /* a member stopped answering (e.g. it was reset and is back at the default) */
+    LINK_ERRORS         /* timeouts / bad frames above MODBUS_BAUD_MAX_ERR_PCT */
+} LinkCheck_t;
+
+static const uint32_t baud_table[MODBUS_BAUD_CODE_COUNT] = MODBUS_BAUD_TABLE;
+
+static ModbusBaudState_t state;
+static uint8_t  code;                       /* active */
+static uint8_t  try_code;
+static uint8_t  max_code;                   /* lowered after each failed speed */
+static uint8_t  member[SLAVE_ID_COUNT];     /* slaves taking part, 0 = HPSB */
+static uint8_t  stage_idx;
+static uint8_t  in_flight;
+static uint8_t  job_done;
+static int      job_result;
+static uint32_t due_tick;
+static ModbusLinkStats_t base[SLAVE_ID_COUNT];
+
+static void on_job(int result, const uint16_t *regs, uint16_t num)
+{
+    (void)regs;
+    (void)num;
+    in_flight = 0;
+    job_done = 1;
+    job_result = result;
+}
+
+static void submit(uint8_t addr)
+{
+    PollEntry_t req = { (SlaveId_t)addr, POLL_ENTRY_WRITE_HOLDING, SLAVE_HOLDING_BAUD_CODE, 0, try_code };
+    if (ModbusMaster_SubmitJob(&req, on_job) == 0)
+        in_flight = 1;      /* otherwise the job slot is busy: retried on the next poll */
+}
+
+static void snapshot(void)
+{
+    for (uint8_t i = 0; i < SLAVE_ID_COUNT; i++)
+        ModbusMaster_GetLinkStats((SlaveId_t)(SLAVE_ID_FIRST + i), &base[i]);
+}
+
+static LinkCheck_t check_link(uint32_t min_ok)
+{
+    uint8_t silent = 0;
+
+    for (uint8_t i = 0; i < SLAVE_ID_COUNT; i++) {
+        ModbusLinkStats_t now;
+        if (!member[i]) continue;
+        ModbusMaster_GetLinkStats((SlaveId_t)(SLAVE_ID_FIRST + i), &now);
+        uint32_t ok  = now.ok - base[i].ok;
+        uint32_t err = (now.timeout - base[i].timeout) + (now.bad_frame - base[i].bad_frame);
+        if (ok == 0) {
+            silent = 1;
+            continue;
+        }
+        if (ok < min_ok || err * 100u > (ok + err) * MODBUS_BAUD_MAX_ERR_PCT)
+            return LINK_ERRORS;
+    }
+    return silent ? LINK_SILENT : LINK_GOOD;
+}
+
+static void retry_later(void)
+{
+    due_tick = HAL_GetTick() + MODBUS_BAUD_RETRY_MS;
+    state = MODBUS_BAUD_ST_WAIT;
+}
+
+/* Back to the default speed; slaves still at the old speed see only garbage and follow within 1 s. */
+static void fall_back(uint8_t lower)
+{
+    ModbusMaster_SetBaud(baud_table[MODBUS_BAUD_DEFAULT_CODE]);
+    if (lower && code > MODBUS_BAUD_DEFAULT_CODE) max_code = (uint8_t)(code - 1u);
+    code = MODBUS_BAUD_DEFAULT_CODE;
+    retry_later();
+}
+
+void ModbusBaud_Init(void)
+{
+    state = MODBUS_BAUD_ST_WAIT;
+    code = MODBUS_BAUD_DEFAULT_CODE;
+    max_code = (MODBUS_BAUD_TARGET_CODE < MODBUS_BAUD_CODE_COUNT) ? MODBUS_BAUD_TARGET_CODE : MODBUS_BAUD_DEFAULT_CODE;
+    in_flight = 0;
+    job_done = 0;
+    due_tick = HAL_GetTick() + MODBUS_BAUD_START_DELAY_MS;
+}
+
+void ModbusBaud_Poll(void)
+{
+    uint32_t now = HAL_GetTick();
+    uint8_t n = 0;
+
+    if (in_flight) return;
+
+    switch (state) {
+        case MODBUS_BAUD_ST_WAIT:
+            if (code >= max_code || (int32_t)(now - due_tick) < 0) break;
+            for (uint8_t i = 0; i < SLAVE_ID_COUNT; i++) {
+                member[i] = ModbusMaster_IsCommOk((SlaveId_t)(SLAVE_ID_FIRST + i));
+                n += member[i];
+            }
+            if (n == 0) {
+                retry_later();
+                break;
+            }
+            try_code = max_code;
+            stage_idx = 0;
+            job_done = 0;
+            state = MODBUS_BAUD_ST_STAGE;
+            break;
+
+        case MODBUS_BAUD_ST_STAGE:
+            if (job_done) {
+                job_done = 0;
+                if (job_result != 0) {      /* a member did not ack: nothing has switched yet */
+                    retry_later();
+                    break;
+                }
+                stage_idx++;
+            }
+            while (stage_idx < SLAVE_ID_COUNT && !member[stage_idx]) stage_idx++;
+            if (stage_idx >= SLAVE_ID_COUNT) {
+                state = MODBUS_BAUD_ST_COMMIT;
+                break;
+            }
+            submit((uint8_t)(SLAVE_ID_FIRST + stage_idx));
+            break;
+
+        case MODBUS_BAUD_ST_COMMIT:
+            if (!job_done) {
+                submit(MODBUS_BROADCAST_ADDR);
+                break;
+            }
+            job_done = 0;
+            if (job_result != 0) {
+                retry_later();
+                break;
+            }
+            ModbusMaster_SetBaud(baud_table[try_code]);
+            code = try_code;
+            snapshot();
+            due_tick = now + MODBUS_BAUD_VERIFY_MS;
+            state = MODBUS_BAUD_ST_VERIFY;
+            break;
+
+        case MODBUS_BAUD_ST_VERIFY:
+            if ((int32_t)(now - due_tick) < 0) break;
+            if (check_link(MODBUS_BAUD_VERIFY_MIN_OK) != LINK_GOOD) {
+                fall_back(1);
+                break;
+            }
+            snapshot();
+            due_tick = now + MODBUS_BAUD_MONITOR_MS;
+            state = MODBUS_BAUD_ST_RUN;
+            break;
+
+        case MODBUS_BAUD_ST_RUN:
+            if ((int32_t)(now - due_tick) < 0) break;
+            switch (check_link(1u)) {
+                case LINK_ERRORS: fall_back(1); break;
+                case LINK_SILENT: fall_back(0); break;
+                default:
+                    snapshot();
+                    due_tick = now + MODBUS_BAUD_MONITOR_MS;
+                    break;
+            }
+            break;
+
+        default:
+            fall_back(0);
+            break;
+    }
+}
+
+uint8_t  ModbusBaud_GetState(void) { return (uint8_t)state; }
+uint8_t  ModbusBaud_GetCode(void)  { return code; }
+uint32_t ModbusBaud_GetBaud(void)  { return baud_table[code]; }
+uint32_t ModbusBaud_GetDefaultBaud(void) { return baud_table[MODBUS_BAUD_DEFAULT_CODE]; }
+
+uint8_t ModbusBaud_IsSettled(void)
+{
+    return (state == MODBUS_BAUD_ST_WAIT || state == MODBUS_BAUD_ST_RUN) ? 1 : 0;
+}
+
+void ModbusBaud_AddMember(SlaveId_t slave)
+{
+    if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST) return;
+    member[slave - SLAVE_ID_FIRST] = 1;
+    ModbusMaster_GetLinkStats(slave, &base[slave - SLAVE_ID_FIRST]);
+}
@@ -1,12 +1,17 @@
 /**
  * @file modbus_master.c
  * @brief MAIN board: Modbus Master - polling table driver, one transaction per Poll().
+ *        A single job slot (ModbusMaster_SubmitJob) runs one extra transaction ahead of the
+ *        next poll entry, e.g. capture_fetch readout; the poll cycle resumes where it left off.
+ *        Responses are received by interrupt up to an idle line and handled on the next Poll,
+ *        which then sends the following request straight away.
  */
 #include "modbus_master.h"
 #include "modbus_rtu.h"
 #include "modbus_cfg.h"
 #include "main.h"
 #include "led_status.h"
+#include "dirty_flags.h"
 #include <string.h>
 
 extern UART_HandleTypeDef huart1;
@@ -15,7 +20,7 @@ typedef enum {
     MST_IDLE,
     MST_SEND_REQUEST,
     MST_WAIT_RESPONSE,
-    MST_PARSE_RESPONSE
+    MST_BROADCAST_DELAY     /* no response: give the slaves a turnaround before the next frame */
 } MasterState_t;
 
 static MasterState_t state = MST_IDLE;
@@ -23,19 +28,61 @@ static uint8_t      poll_index;
 static uint32_t     response_deadline;
 static uint8_t      tx_buf[MODBUS_RTU_TX_BUF_SIZE];
 static uint8_t      rx_buf[MODBUS_RTU_RX_BUF_SIZE];
-static uint16_t     rx_len;
+static uint16_t     rx_len;                  /* set by the idle-line event */
+static uint8_t      rx_done;
 static uint8_t      last_slave_responded;
-static uint8_t      comm_ok[SLAVE_ID_COUNT]; /* 0 = HPSB, 1 = LPSB */
+static uint8_t      comm_ok[SLAVE_ID_COUNT]; /* 0 = address SLAVE_ID_FIRST */
+static ModbusLinkStats_t link_stats[SLAVE_ID_COUNT];
+static PollEntry_t  cur;                     /* transaction in flight */
+static uint8_t      cur_is_job;
+static PollEntry_t  job;
+static uint8_t      job_pending;
+static ModbusMasterJobCb_t job_cb;           /* non-NULL while a job is queued or in flight */
+static uint32_t     job_baud;                /* 0 = the job runs at the bus speed */
+static uint32_t     bus_baud;                /* speed to restore after the job, 0 = not switched */
 
 #define SLAVE_TO_INDEX(s)  ((uint8_t)((s) - SLAVE_ID_FIRST))
 
 static void set_de_tx(void)   { HAL_GPIO_WritePin(MODBUS_DE_GPIO_PORT, MODBUS_DE_GPIO_PIN, GPIO_PIN_SET); }
 static void set_de_rx(void)   { HAL_GPIO_WritePin(MODBUS_DE_GPIO_PORT, MODBUS_DE_GPIO_PIN, GPIO_PIN_RESET); }
 
+static void set_comm_ok(SlaveId_t slave, uint8_t ok)
+{
+    if (comm_ok[SLAVE_TO_INDEX(slave)] == ok) return;
+    comm_ok[SLAVE_TO_INDEX(slave)] = ok;
+    DirtyFlags_Mark(DIRTY_COMM);
+}
+
+static int set_uart_baud(uint32_t baud)
+{
+    HAL_UART_AbortReceive(&MODBUS_UART);
+    MODBUS_UART.Init.BaudRate = baud;
+    return (HAL_UART_Init(&MODBUS_UART) == HAL_OK) ? 0 : -1;
+}
+
+static void finish_job(int result, const uint16_t *regs, uint16_t num)
+{
+    ModbusMasterJobCb_t cb = job_cb;
+    if (bus_baud != 0) {
+        set_uart_baud(bus_baud);
+        bus_baud = 0;
+    }
+    job_cb = NULL;              /* cleared first: the callback may submit the next job */
+    if (cb) cb(result, regs, num);
+}
+
 static void send_request(void)
 {
     PollEntry_t e;
-    if (ModbusTable_GetPollEntry(poll_index, &e) != 0) return;
+    if (job_pending) {
+        e = job;
+        job_pending = 0;
+        cur_is_job = 1;
+    } else {
+        if (ModbusTable_GetPollEntry(poll_index, &e) != 0) return;
+        cur_is_job = 0;
+    }
+    cur = e;
 
     size_t pdu_len = 0;
     switch (e.entry_type) {
@@ -51,34 +98,136 @@ static void send_request(void)
         case POLL_ENTRY_READ_INPUT_REG:
             pdu_len = ModbusRTU_BuildFC04(tx_buf, (uint8_t)e.slave_id, e.start_addr, e.count);
             break;
+        case POLL_ENTRY_READ_EVENTS:
+            pdu_len = ModbusRTU_BuildFC24(tx_buf, (uint8_t)e.slave_id, ModbusTable_GetEventCursor(e.slave_id));
+            break;
+        case POLL_ENTRY_WRITE_HOLDING:
+            pdu_len = ModbusRTU_BuildFC06(tx_buf, (uint8_t)e.slave_id, e.start_addr, e.value);
+            break;
+        case POLL_ENTRY_WRITE_COIL:
+            pdu_len = ModbusRTU_BuildFC05(tx_buf, (uint8_t)e.slave_id, e.start_addr, (uint8_t)e.value);
+            break;
+        case POLL_ENTRY_REPORT_ID:
+            pdu_len = ModbusRTU_BuildFC17(tx_buf, (uint8_t)e.slave_id);
+            break;
         default:
+            if (cur_is_job) finish_job(-1, NULL, 0);
             state = MST_IDLE;
             return;
     }
     ModbusRTU_AppendCRC(tx_buf, pdu_len);
+    if (cur_is_job && job_baud != 0 && job_baud != MODBUS_UART.Init.BaudRate) {
+        bus_baud = MODBUS_UART.Init.BaudRate;     /* restored by finish_job */
+        set_uart_baud(job_baud);
+    }
+    HAL_UART_AbortReceive(&MODBUS_UART);
+    rx_len = 0;
+    rx_done = 0;
     set_de_tx();
     HAL_UART_Transmit(&MODBUS_UART, tx_buf, (uint16_t)(pdu_len + 2), 100);
     set_de_rx();
     LED_Status_OnRS485Activity();
-    rx_len = 0;
-    response_deadline = HAL_GetTick() + MODBUS_RESPONSE_TIMEOUT_MS;
+    if (e.slave_id == (SlaveId_t)MODBUS_BROADCAST_ADDR) {
+        response_deadline = HAL_GetTick() + MODBUS_FRAME_DELAY_MS;
+        state = MST_BROADCAST_DELAY;
+        return;
+    }
+    HAL_UARTEx_ReceiveToIdle_IT(&MODBUS_UART, rx_buf, MODBUS_RTU_RX_BUF_SIZE);
+    response_deadline = HAL_GetTick() +
+        ((e.entry_type == POLL_ENTRY_REPORT_ID) ? MODBUS_PROBE_TIMEOUT_MS : MODBUS_RESPONSE_TIMEOUT_MS);
     state = MST_WAIT_RESPONSE;
 }
 
-static void parse_response(void)
+void ModbusMaster_UART_RxEventCallback(uint16_t Size)
 {
-    PollEntry_t e;
-    if (ModbusTable_GetPollEntry(poll_index, &e) != 0) {
-        state = MST_IDLE;
-        return;
+    /* Posted before a timeout aborted that reception and a new request re-armed it: not this one */
+    if (MODBUS_UART.RxState != HAL_UART_STATE_READY) return;
+    rx_len = Size;
+    rx_done = 1;
+}
+
+/* Move on after a transaction: the poll cycle only advances for poll-table entries. */
+static void next_request(void)
+{
+    if (!cur_is_job) {
+        poll_index++;
+        if (poll_index >= ModbusTable_GetPollCount()) poll_index = 0;
     }
+    send_request();
+}
+
+static void parse_response(void)
+{
+    const PollEntry_t e = cur;
+    uint16_t job_regs[MODBUS_MAX_READ_REGS];
+    uint16_t job_num = 0;
+
     if (rx_len < 5) {
+        link_stats[SLAVE_TO_INDEX(e.slave_id)].bad_frame++;
+        if (cur_is_job) finish_job(-1, NULL, 0);
         state = MST_IDLE;
         return;
     }
 
     uint8_t slave = (uint8_t)e.slave_id;
     int ok = 0;
+    if (cur_is_job) {
+        /* Job results go to the callback, not into the slave images */
+        switch (e.entry_type) {
+            case POLL_ENTRY_READ_HOLDING:
+                if (e.count > MODBUS_MAX_READ_REGS) { ok = -1; break; }
+                ok = ModbusRTU_ParseFC03Response(rx_buf, rx_len, job_regs, e.count);
+                job_num = e.count;
+                break;
+            case POLL_ENTRY_READ_INPUT_REG:
+                if (e.count > MODBUS_MAX_READ_REGS) { ok = -1; break; }
+                ok = ModbusRTU_ParseFC04Response(rx_buf, rx_len, job_regs, e.count);
+                job_num = e.count;
+                break;
+            case POLL_ENTRY_WRITE_HOLDING: {
+                uint16_t addr, value;
+                ok = -1;
+                if (rx_len >= 8 && rx_buf[1] == 0x06 && ModbusRTU_CRC16Check(rx_buf, 8) == 0 &&
+                    ModbusRTU_ParseFC06Request(rx_buf, 8, &addr, &value) == 0 &&
+                    addr == e.start_addr && value == e.value)
+                    ok = 0;
+                break;
+            }
+            case POLL_ENTRY_WRITE_COIL: {
+                uint16_t addr;
+                uint8_t value;
+                ok = -1;
+                if (rx_len >= 8 && rx_buf[1] == 0x05 && ModbusRTU_CRC16Check(rx_buf, 8) == 0 &&
+                    ModbusRTU_ParseFC05Request(rx_buf, 8, &addr, &value) == 0 &&
+                    addr == e.start_addr && value == (e.value ? 1u : 0u))
+                    ok = 0;
+                break;
+            }
+            case POLL_ENTRY_REPORT_ID: {
+                uint8_t id[SLAVE_REPORT_ID_LEN];
+                uint8_t n = 0;
+                ok = ModbusRTU_ParseFC17Response(rx_buf, rx_len, id, sizeof(id), &n);
+                for (uint8_t i = 0; ok == 0 && i < n; i++) job_regs[i] = id[i];
+                job_num = n;
+                break;
+            }
+            default:
+                ok = -1;
+                break;
+        }
+        if (ok == 0) {
+            last_slave_responded = slave;
+            set_comm_ok(e.slave_id, 1);
+            link_stats[SLAVE_TO_INDEX(e.slave_id)].ok++;
+            LED_Status_OnRS485Activity();
+        } else {
+            link_stats[SLAVE_TO_INDEX(e.slave_id)].bad_frame++;
+        }
+        finish_job(ok, job_regs, (ok == 0) ? job_num : 0);
+        state = MST_IDLE;
+        return;
+    }
+
     switch (e.entry_type) {
         case POLL_ENTRY_READ_DISCRETE: {
             uint8_t bits[MODBUS_DISCRETE_COUNT];
@@ -104,13 +253,23 @@ static void parse_response(void)
             if (ok == 0) ModbusTable_SetInputRegs(e.slave_id, e.start_addr, regs, e.count);
             break;
         }
+        case POLL_ENTRY_READ_EVENTS: {
+            uint16_t regs[MODBUS_EVENT_MAX_PER_READ * MODBUS_EVENT_REGS_PER_EVENT];
+            uint16_t num = 0;
+            ok = ModbusRTU_ParseFC24Response(rx_buf, rx_len, regs, (uint16_t)(sizeof(regs) / sizeof(regs[0])), &num);
+            if (ok == 0) ModbusTable_PushSlaveEvents(e.slave_id, regs, num);
+            break;
+        }
         default:
             break;
     }
     if (ok == 0) {
         last_slave_responded = slave;
-        comm_ok[SLAVE_TO_INDEX(e.slave_id)] = 1;
+        set_comm_ok(e.slave_id, 1);
+        link_stats[SLAVE_TO_INDEX(e.slave_id)].ok++;
         LED_Status_OnRS485Activity();
+    } else {
+        link_stats[SLAVE_TO_INDEX(e.slave_id)].bad_frame++;
     }
     state = MST_IDLE;
 }
@@ -120,21 +279,21 @@ void ModbusMaster_Init(void)
     state = MST_IDLE;
     poll_index = 0;
     rx_len = 0;
+    rx_done = 0;
     last_slave_responded = 0;
     memset(comm_ok, 0, sizeof(comm_ok));
+    memset(link_stats, 0, sizeof(link_stats));
+    cur_is_job = 0;
+    job_pending = 0;
+    job_cb = NULL;
+    job_baud = 0;
+    bus_baud = 0;
     ModbusTable_ClearAllImages();
     set_de_rx();
 }
 
 void ModbusMaster_Poll(void)
 {
-    /* Consume RX bytes if any */
-    uint8_t byte;
-    while (HAL_UART_Receive(&MODBUS_UART, &byte, 1, 0) == HAL_OK) {
-        if (rx_len < MODBUS_RTU_RX_BUF_SIZE)
-            rx_buf[rx_len++] = byte;
-    }
-
     switch (state) {
         case MST_IDLE:
             poll_index = 0;
@@ -142,43 +301,35 @@ void ModbusMaster_Poll(void)
             break;
 
         case MST_WAIT_RESPONSE:
-            if (HAL_GetTick() >= response_deadline) {
-                PollEntry_t te;
-                if (ModbusTable_GetPollEntry(poll_index, &te) == 0)
-                    comm_ok[SLAVE_TO_INDEX(te.slave_id)] = 0;
-                state = MST_IDLE;
-                poll_index++;
-                if (poll_index >= POLL_TABLE_SIZE)
-                    poll_index = 0;
-                send_request();
-                return;
-            }
-            if (rx_len >= 5) {
-                uint8_t exp_slave = rx_buf[0];
-                (void)exp_slave;
-                uint8_t fc = rx_buf[1];
-                if (fc & 0x80) {
+            if (rx_done) {
+                /* Whole frame is in: parse and send the next request in the same call */
+                if (rx_len >= 5 && (rx_buf[1] & 0x80)) {
+                    link_stats[SLAVE_TO_INDEX(cur.slave_id)].exception++;
                     state = MST_IDLE;
-                    poll_index++;
-                    if (poll_index >= POLL_TABLE_SIZE) poll_index = 0;
-                    send_request();
-                    return;
-                }
-                if (fc == 0x01 || fc == 0x02) {
-                    if (rx_len >= (uint16_t)(3 + rx_buf[2] + 2))
-                        state = MST_PARSE_RESPONSE;
-                } else if (fc == 0x03 || fc == 0x04) {
-                    if (rx_len >= (uint16_t)(3 + rx_buf[2] + 2))
-                        state = MST_PARSE_RESPONSE;
+                    if (cur_is_job) finish_job(-1, NULL, 0);
+                } else {
+                    parse_response();
                 }
+                next_request();
+                return;
+            }
+            if ((int32_t)(HAL_GetTick() - response_deadline) >= 0) {
+                HAL_UART_AbortReceive(&MODBUS_UART);
+                set_comm_ok(cur.slave_id, 0);
+                link_stats[SLAVE_TO_INDEX(cur.slave_id)].timeout++;
+                state = MST_IDLE;
+                if (cur_is_job) finish_job(-1, NULL, 0);
+                next_request();
+                return;
             }
             break;
 
-        case MST_PARSE_RESPONSE:
-            parse_response();
-            poll_index++;
-            if (poll_index >= POLL_TABLE_SIZE) poll_index = 0;
-            send_request();
+        case MST_BROADCAST_DELAY:
+            if ((int32_t)(HAL_GetTick() - response_deadline) >= 0) {
+                state = MST_IDLE;
+                finish_job(0, NULL, 0);
+                next_request();
+            }
             break;
 
         default:
@@ -187,28 +338,29 @@ void ModbusMaster_Poll(void)
     }
 }
 
-int ModbusMaster_WriteCoil(SlaveId_t slave, uint16_t coil_addr, uint8_t value)
+int ModbusMaster_SubmitJob(const PollEntry_t *req, ModbusMasterJobCb_t cb)
 {
-    uint8_t pdu[8];
-    size_t len = ModbusRTU_BuildFC05(pdu, (uint8_t)slave, coil_addr, value);
-    ModbusRTU_AppendCRC(pdu, len);
-    set_de_tx();
-    HAL_StatusTypeDef s = HAL_UART_Transmit(&MODBUS_UART, pdu, (uint16_t)(len + 2), 100);
-    set_de_rx();
-    if (s == HAL_OK) LED_Status_OnRS485Activity();
-    return (s == HAL_OK) ? 0 : -1;
+    return ModbusMaster_SubmitJobAtBaud(req, cb, 0);
 }
 
-int ModbusMaster_WriteHoldingReg(SlaveId_t slave, uint16_t reg_addr, uint16_t value)
+int ModbusMaster_SubmitJobAtBaud(const PollEntry_t *req, ModbusMasterJobCb_t cb, uint32_t baud)
 {
-    uint8_t pdu[10];
-    size_t len = ModbusRTU_BuildFC06(pdu, (uint8_t)slave, reg_addr, value);
-    ModbusRTU_AppendCRC(pdu, len);
-    set_de_tx();
-    HAL_StatusTypeDef s = HAL_UART_Transmit(&MODBUS_UART, pdu, (uint16_t)(len + 2), 100);
-    set_de_rx();
-    if (s == HAL_OK) LED_Status_OnRS485Activity();
-    return (s == HAL_OK) ? 0 : -1;
+    if (req == NULL || cb == NULL || job_cb != NULL) return -1;
+    if (req->slave_id == (SlaveId_t)MODBUS_BROADCAST_ADDR) {
+        if (req->entry_type != POLL_ENTRY_WRITE_HOLDING) return -1;
+    } else if (req->slave_id < SLAVE_ID_FIRST || req->slave_id > SLAVE_ID_LAST) {
+        return -1;
+    }
+    job = *req;
+    job_cb = cb;
+    job_baud = baud;
+    job_pending = 1;
+    return 0;
+}
+
+uint8_t ModbusMaster_IsJobBusy(void)
+{
+    return (job_cb != NULL) ? 1 : 0;
 }
 
 uint8_t ModbusMaster_GetLastSlaveResponded(void) { return last_slave_responded; }
@@ -218,3 +370,22 @@ uint8_t ModbusMaster_IsCommOk(SlaveId_t slave)
     if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST) return 0;
     return comm_ok[SLAVE_TO_INDEX(slave)];
 }
+
+void ModbusMaster_GetLinkStats(SlaveId_t slave, ModbusLinkStats_t *out)
+{
+    if (out == NULL) return;
+    if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    *out = link_stats[SLAVE_TO_INDEX(slave)];
+}
+
+int ModbusMaster_SetBaud(uint32_t baud)
+{
+    /* Drop the transaction in flight; the poll cycle restarts at the new speed */
+    HAL_UART_AbortReceive(&MODBUS_UART);
+    if (state != MST_IDLE && cur_is_job) finish_job(-1, NULL, 0);
+    state = MST_IDLE;
+    return set_uart_baud(baud);
+}
@@ -111,6 +111,22 @@ size_t ModbusRTU_BuildFC04(uint8_t *pdu, uint8_t slave_addr, uint16_t start_addr
     return 6;
 }
 
+size_t ModbusRTU_BuildFC24(uint8_t *pdu, uint8_t slave_addr, uint16_t fifo_ptr)
+{
+    pdu[0] = slave_addr;
+    pdu[1] = 0x18;
+    pdu[2] = (uint8_t)(fifo_ptr >> 8);
+    pdu[3] = (uint8_t)(fifo_ptr & 0xFF);
+    return 4;
+}
+
+size_t ModbusRTU_BuildFC17(uint8_t *pdu, uint8_t slave_addr)
+{
+    pdu[0] = slave_addr;
+    pdu[1] = 0x11;
+    return 2;
+}
+
 size_t ModbusRTU_BuildFC05(uint8_t *pdu, uint8_t slave_addr, uint16_t coil_addr, uint8_t value)
 {
     pdu[0] = slave_addr;
@@ -234,6 +250,35 @@ int ModbusRTU_ParseFC04Response(const uint8_t *frame, size_t frame_len, uint16_t
     return 0;
 }
 
+/* FC24: [Slave][0x18][ByteCount 2][FifoCount 2][regs...][CRC]; ByteCount = 2 + 2*FifoCount */
+int ModbusRTU_ParseFC24Response(const uint8_t *frame, size_t frame_len, uint16_t *regs, uint16_t max_regs, uint16_t *num_regs)
+{
+    if (frame_len < 8 || frame[1] != 0x18) return -1;
+    uint16_t byte_count = (uint16_t)((frame[2] << 8) | frame[3]);
+    uint16_t fifo_count = (uint16_t)((frame[4] << 8) | frame[5]);
+    if (byte_count != (uint16_t)(2 + fifo_count * 2)) return -1;
+    if (frame_len < (size_t)(4 + byte_count + 2)) return -1;
+    if (fifo_count > max_regs) return -1;
+    if (ModbusRTU_CRC16Check(frame, frame_len) != 0) return -1;
+    for (uint16_t i = 0; i < fifo_count; i++)
+        regs[i] = (uint16_t)((frame[6 + i * 2] << 8) | frame[7 + i * 2]);
+    *num_regs = fifo_count;
+    return 0;
+}
+
+/* FC17: [Slave][0x11][ByteCount][data...][CRC] */
+int ModbusRTU_ParseFC17Response(const uint8_t *frame, size_t frame_len, uint8_t *data, uint8_t max_len, uint8_t *len)
+{
+    if (frame_len < 5 || frame[1] != 0x11) return -1;
+    uint8_t byte_count = frame[2];
+    if (frame_len < (size_t)(3 + byte_count + 2)) return -1;
+    if (ModbusRTU_CRC16Check(frame, frame_len) != 0) return -1;
+    uint8_t n = (byte_count < max_len) ? byte_count : max_len;
+    for (uint8_t i = 0; i < n; i++) data[i] = frame[3 + i];
+    *len = n;
+    return 0;
+}
+
 int ModbusRTU_IsExceptionResponse(const uint8_t *frame, size_t frame_len, uint8_t expected_slave, uint8_t expected_fc)
 {
     if (frame_len < 5) return 0;
@@ -1,139 +1,296 @@
 /**
  * @file modbus_table.c
- * @brief MAIN board: polling table definition and slave image storage.
+ * @brief MAIN board: polling table (built from the bus enumeration) and slave image access.
+ *        The images live in the slave registry; unregistered slaves read as 0 and ignore writes.
+ *        A write that changes the image content marks the slave for the aggregator.
  */
 #include "modbus_table.h"
+#include "dirty_flags.h"
+#include "main.h"
 #include <string.h>
 
-/* Per-slave images. Index 0 = HPSB, 1 = LPSB (use slave_id - 1). */
-static uint8_t  discrete_img[SLAVE_ID_COUNT][MODBUS_DISCRETE_COUNT];
-static uint8_t  coil_img[SLAVE_ID_COUNT][MODBUS_COIL_COUNT];
-static uint16_t holding_img[SLAVE_ID_COUNT][MODBUS_HOLDING_COUNT];
-static uint16_t input_reg_img[SLAVE_ID_COUNT][MODBUS_INPUT_REG_COUNT];
-
-static const PollEntry_t poll_table[POLL_TABLE_SIZE] = {
-    /* HPSB */
-    { SLAVE_ID_HPSB, POLL_ENTRY_READ_DISCRETE,  MODBUS_DISCRETE_START, MODBUS_DISCRETE_COUNT },
-    { SLAVE_ID_HPSB, POLL_ENTRY_READ_COIL,      MODBUS_COIL_START,     MODBUS_COIL_COUNT },
-    { SLAVE_ID_HPSB, POLL_ENTRY_READ_HOLDING,   MODBUS_HOLDING_START, MODBUS_HOLDING_COUNT },
-    { SLAVE_ID_HPSB, POLL_ENTRY_READ_INPUT_REG, MODBUS_INPUT_REG_START, 7 },
-    /* LPSB1 */
-    { SLAVE_ID_LPSB1, POLL_ENTRY_READ_DISCRETE,  MODBUS_DISCRETE_START, MODBUS_DISCRETE_COUNT },
-    { SLAVE_ID_LPSB1, POLL_ENTRY_READ_COIL,      MODBUS_COIL_START,     MODBUS_COIL_COUNT },
-    { SLAVE_ID_LPSB1, POLL_ENTRY_READ_HOLDING,   MODBUS_HOLDING_START, MODBUS_HOLDING_COUNT },
-    { SLAVE_ID_LPSB1, POLL_ENTRY_READ_INPUT_REG, MODBUS_INPUT_REG_START, 4 },
-    /* LPSB2 */
-    { SLAVE_ID_LPSB2, POLL_ENTRY_READ_DISCRETE,  MODBUS_DISCRETE_START, MODBUS_DISCRETE_COUNT },
-    { SLAVE_ID_LPSB2, POLL_ENTRY_READ_COIL,      MODBUS_COIL_START,     MODBUS_COIL_COUNT },
-    { SLAVE_ID_LPSB2, POLL_ENTRY_READ_HOLDING,   MODBUS_HOLDING_START, MODBUS_HOLDING_COUNT },
-    { SLAVE_ID_LPSB2, POLL_ENTRY_READ_INPUT_REG, MODBUS_INPUT_REG_START, 4 },
-    /* LPSB3 */
-    { SLAVE_ID_LPSB3, POLL_ENTRY_READ_DISCRETE,  MODBUS_DISCRETE_START, MODBUS_DISCRETE_COUNT },
-    { SLAVE_ID_LPSB3, POLL_ENTRY_READ_COIL,      MODBUS_COIL_START,     MODBUS_COIL_COUNT },
-    { SLAVE_ID_LPSB3, POLL_ENTRY_READ_HOLDING,   MODBUS_HOLDING_START, MODBUS_HOLDING_COUNT },
-    { SLAVE_ID_LPSB3, POLL_ENTRY_READ_INPUT_REG, MODBUS_INPUT_REG_START, 4 },
-};
-
-static inline uint8_t slave_idx(SlaveId_t slave)
-{
-    return (uint8_t)(slave - SLAVE_ID_FIRST);
+/* Drained slave events: one log for all slaves, oldest overwritten when full */
+static SlaveEvent_t event_log[MODBUS_EVENT_LOG_SIZE];
+static uint16_t     event_head;
+static uint16_t     event_count;
+static uint16_t     event_head_seq;     /* log number of event_log[event_head] */
+
+/* Built by ModbusTable_BuildPollTable from what answered the enumeration scan */
+static PollEntry_t poll_table[POLL_TABLE_MAX];
+static uint8_t     poll_count;
+
+static void add_entry(SlaveId_t slave, PollEntryType_t type, uint16_t start, uint16_t count)
+{
+    PollEntry_t *e = &poll_table[poll_count++];
+    e->slave_id   = slave;
+    e->entry_type = type;
+    e->start_addr = start;
+    e->count      = count;
+    e->value      = 0;
+}
+
+void ModbusTable_BuildPollTable(void)
+{
+    poll_count = 0;
+    for (uint32_t a = SLAVE_ID_FIRST; a <= SLAVE_ID_LAST; a++) {
+        SlaveId_t s = (SlaveId_t)a;
+        uint16_t input_count;
+        uint8_t type = SlaveRegistry_GetType(s);
+        if (type == SLAVE_TYPE_HPSB)      input_count = SLAVE_HPSB_INPUT_COUNT;
+        else if (type == SLAVE_TYPE_LPSB) input_count = SLAVE_LPSB_INPUT_COUNT;
+        else continue;
+        add_entry(s, POLL_ENTRY_READ_DISCRETE,  MODBUS_DISCRETE_START,  MODBUS_DISCRETE_COUNT);
+        add_entry(s, POLL_ENTRY_READ_COIL,      MODBUS_COIL_START,      MODBUS_COIL_COUNT);
+        add_entry(s, POLL_ENTRY_READ_HOLDING,   MODBUS_HOLDING_START,   MODBUS_HOLDING_COUNT);
+        add_entry(s, POLL_ENTRY_READ_INPUT_REG, MODBUS_INPUT_REG_START, input_count);
+        add_entry(s, POLL_ENTRY_READ_EVENTS,    0, MODBUS_EVENT_MAX_PER_READ);
+    }
+}
+
+uint8_t ModbusTable_GetPollCount(void)
+{
+    return poll_count;
 }
 
 int ModbusTable_GetPollEntry(uint8_t index, PollEntry_t *entry)
 {
-    if (index >= POLL_TABLE_SIZE || entry == NULL) return -1;
+    if (index >= poll_count || entry == NULL) return -1;
     *entry = poll_table[index];
     return 0;
 }
 
+int ModbusTable_GetSnapshot(SlaveId_t slave, SlaveSnapshot_t *snap)
+{
+    return SlaveRegistry_Snapshot(slave, snap);
+}
+
+uint8_t ModbusTable_SnapshotValid(const SlaveSnapshot_t *snap)
+{
+    return SlaveRegistry_SnapshotValid(snap);
+}
+
 uint8_t ModbusTable_GetDiscrete(SlaveId_t slave, uint16_t bit_index)
 {
-    if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST || bit_index >= MODBUS_DISCRETE_COUNT)
-        return 0;
-    return discrete_img[slave_idx(slave)][bit_index];
+    SlaveSnapshot_t v;
+    if (SlaveRegistry_Snapshot(slave, &v) != 0 || bit_index >= SLAVE_BITS_COUNT) return 0;
+    return (uint8_t)((v.head->discrete >> bit_index) & 1u);
 }
 
 uint8_t ModbusTable_GetCoil(SlaveId_t slave, uint16_t bit_index)
 {
-    if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST || bit_index >= MODBUS_COIL_COUNT)
-        return 0;
-    return coil_img[slave_idx(slave)][bit_index];
+    SlaveSnapshot_t v;
+    if (SlaveRegistry_Snapshot(slave, &v) != 0 || bit_index >= SLAVE_BITS_COUNT) return 0;
+    return (uint8_t)((v.head->coils >> bit_index) & 1u);
 }
 
 uint16_t ModbusTable_GetHoldingReg(SlaveId_t slave, uint16_t reg_index)
 {
-    if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST || reg_index >= MODBUS_HOLDING_COUNT)
-        return 0;
-    return holding_img[slave_idx(slave)][reg_index];
+    SlaveSnapshot_t v;
+    if (SlaveRegistry_Snapshot(slave, &v) != 0 || reg_index >= SLAVE_HOLDING_COUNT) return 0;
+    return v.head->holding[reg_index];
 }
 
 uint16_t ModbusTable_GetInputReg(SlaveId_t slave, uint16_t reg_index)
 {
-    if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST || reg_index >= MODBUS_INPUT_REG_COUNT)
-        return 0;
-    return input_reg_img[slave_idx(slave)][reg_index];
+    SlaveSnapshot_t v;
+    if (SlaveRegistry_Snapshot(slave, &v) != 0 || reg_index >= v.input_count) return 0;
+    return v.input[reg_index];
+}
+
+/* Publish the back buffer and record when the area was acquired. The back buffer starts as a
+ * copy of the published image, so the setters see the old values while writing the new ones. */
+static void publish(SlaveId_t slave, SlaveArea_t area, uint8_t changed)
+{
+    SlaveRegistry_Publish(slave);
+    SlaveRegistry_Stamp(slave, area, HAL_GetTick());
+    if (changed) DirtyFlags_MarkSlave(slave);
+}
+
+static uint8_t set_reg(uint16_t *reg, uint16_t value)
+{
+    if (*reg == value) return 0;
+    *reg = value;
+    return 1;
+}
+
+static uint8_t set_bit(uint8_t *bits, uint16_t bit_index, uint8_t value)
+{
+    uint8_t old = *bits;
+    if (value) *bits |= (uint8_t)(1u << bit_index);
+    else       *bits &= (uint8_t)~(1u << bit_index);
+    return (uint8_t)(*bits != old);
 }
 
 void ModbusTable_SetDiscrete(SlaveId_t slave, uint16_t bit_index, uint8_t value)
 {
-    if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST || bit_index >= MODBUS_DISCRETE_COUNT) return;
-    discrete_img[slave_idx(slave)][bit_index] = value ? 1 : 0;
+    SlaveImageWrite_t w;
+    if (bit_index >= SLAVE_BITS_COUNT || SlaveRegistry_BeginWrite(slave, &w) != 0) return;
+    publish(slave, SLAVE_AREA_DISCRETE, set_bit(&w.head->discrete, bit_index, value));
 }
 
 void ModbusTable_SetCoil(SlaveId_t slave, uint16_t bit_index, uint8_t value)
 {
-    if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST || bit_index >= MODBUS_COIL_COUNT) return;
-    coil_img[slave_idx(slave)][bit_index] = value ? 1 : 0;
+    SlaveImageWrite_t w;
+    if (bit_index >= SLAVE_BITS_COUNT || SlaveRegistry_BeginWrite(slave, &w) != 0) return;
+    publish(slave, SLAVE_AREA_COIL, set_bit(&w.head->coils, bit_index, value));
 }
 
 void ModbusTable_SetHoldingReg(SlaveId_t slave, uint16_t reg_index, uint16_t value)
 {
-    if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST || reg_index >= MODBUS_HOLDING_COUNT) return;
-    holding_img[slave_idx(slave)][reg_index] = value;
+    SlaveImageWrite_t w;
+    if (reg_index >= SLAVE_HOLDING_COUNT || SlaveRegistry_BeginWrite(slave, &w) != 0) return;
+    publish(slave, SLAVE_AREA_HOLDING, set_reg(&w.head->holding[reg_index], value));
 }
 
 void ModbusTable_SetInputReg(SlaveId_t slave, uint16_t reg_index, uint16_t value)
 {
-    if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST || reg_index >= MODBUS_INPUT_REG_COUNT) return;
-    input_reg_img[slave_idx(slave)][reg_index] = value;
+    SlaveImageWrite_t w;
+    uint8_t changed = 0;
+    if (SlaveRegistry_BeginWrite(slave, &w) != 0) return;
+    if (reg_index < w.input_count) changed = set_reg(&w.input[reg_index], value);
+    publish(slave, SLAVE_AREA_INPUT, changed);
+}
+
+/* Bits 0..7 arrive in the first response byte, LSB first: the same as the bitmap */
+static uint8_t set_bits(uint8_t *bits, const uint8_t *bytes, uint16_t num_bits)
+{
+    uint8_t mask = (num_bits >= SLAVE_BITS_COUNT) ? 0xFFu : (uint8_t)((1u << num_bits) - 1u);
+    uint8_t old = *bits;
+    *bits = (uint8_t)((old & ~mask) | (bytes[0] & mask));
+    return (uint8_t)(*bits != old);
 }
 
 void ModbusTable_SetDiscreteBytes(SlaveId_t slave, const uint8_t *bytes, uint16_t num_bits)
 {
-    uint8_t si = slave_idx(slave);
-    if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST || bytes == NULL) return;
-    for (uint16_t i = 0; i < num_bits && i < MODBUS_DISCRETE_COUNT; i++)
-        discrete_img[si][i] = (bytes[i / 8] >> (i % 8)) & 1u;
+    SlaveImageWrite_t w;
+    if (bytes == NULL || num_bits == 0 || SlaveRegistry_BeginWrite(slave, &w) != 0) return;
+    publish(slave, SLAVE_AREA_DISCRETE, set_bits(&w.head->discrete, bytes, num_bits));
 }
 
 void ModbusTable_SetCoilBytes(SlaveId_t slave, const uint8_t *bytes, uint16_t num_bits)
 {
-    uint8_t si = slave_idx(slave);
-    if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST || bytes == NULL) return;
-    for (uint16_t i = 0; i < num_bits && i < MODBUS_COIL_COUNT; i++)
-        coil_img[si][i] = (bytes[i / 8] >> (i % 8)) & 1u;
+    SlaveImageWrite_t w;
+    if (bytes == NULL || num_bits == 0 || SlaveRegistry_BeginWrite(slave, &w) != 0) return;
+    publish(slave, SLAVE_AREA_COIL, set_bits(&w.head->coils, bytes, num_bits));
 }
 
 void ModbusTable_SetHoldingRegs(SlaveId_t slave, uint16_t start, const uint16_t *regs, uint16_t num)
 {
-    uint8_t si = slave_idx(slave);
-    if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST || regs == NULL) return;
-    for (uint16_t i = 0; i < num && (start + i) < MODBUS_HOLDING_COUNT; i++)
-        holding_img[si][start + i] = regs[i];
+    SlaveImageWrite_t w;
+    uint8_t changed = 0;
+    if (regs == NULL || SlaveRegistry_BeginWrite(slave, &w) != 0) return;
+    for (uint16_t i = 0; i < num && (start + i) < SLAVE_HOLDING_COUNT; i++)
+        changed |= set_reg(&w.head->holding[start + i], regs[i]);
+    publish(slave, SLAVE_AREA_HOLDING, changed);
 }
 
 void ModbusTable_SetInputRegs(SlaveId_t slave, uint16_t start, const uint16_t *regs, uint16_t num)
 {
-    uint8_t si = slave_idx(slave);
-    if (slave < SLAVE_ID_FIRST || slave > SLAVE_ID_LAST || regs == NULL) return;
-    for (uint16_t i = 0; i < num && (start + i) < MODBUS_INPUT_REG_COUNT; i++)
-        input_reg_img[si][start + i] = regs[i];
+    SlaveImageWrite_t w;
+    uint8_t changed = 0;
+    if (regs == NULL || SlaveRegistry_BeginWrite(slave, &w) != 0) return;
+    for (uint16_t i = 0; i < num && (start + i) < w.input_count; i++)
+        changed |= set_reg(&w.input[start + i], regs[i]);
+    publish(slave, SLAVE_AREA_INPUT, changed);
+}
+
+uint32_t ModbusTable_GetAgeMs(SlaveId_t slave, SlaveArea_t area)
+{
+    SlaveSnapshot_t v;
+    if (area >= SLAVE_AREA_COUNT || SlaveRegistry_Snapshot(slave, &v) != 0) return MODBUS_AGE_NEVER;
+    uint32_t stamp = v.stamp[area];
+    if (stamp == 0) return MODBUS_AGE_NEVER;
+    return HAL_GetTick() - stamp;
 }
 
 void ModbusTable_ClearAllImages(void)
 {
-    memset(discrete_img, 0, sizeof(discrete_img));
-    memset(coil_img, 0, sizeof(coil_img));
-    memset(holding_img, 0, sizeof(holding_img));
-    memset(input_reg_img, 0, sizeof(input_reg_img));
+    SlaveRegistry_ClearImages();
+    DirtyFlags_MarkAll();
+}
+
+uint16_t ModbusTable_GetEventCursor(SlaveId_t slave)
+{
+    const SlaveEventTrack_t *t = SlaveRegistry_EventTrack(slave);
+    return (t != NULL) ? t->cursor : 0;
+}
+
+void ModbusTable_PushSlaveEvents(SlaveId_t slave, const uint16_t *regs, uint16_t num_regs)
+{
+    SlaveEventTrack_t *t = SlaveRegistry_EventTrack(slave);
+    if (t == NULL || regs == NULL) return;
+
+    for (uint16_t i = 0; i + MODBUS_EVENT_REGS_PER_EVENT <= num_regs; i += MODBUS_EVENT_REGS_PER_EVENT) {
+        SlaveEvent_t ev;
+        ev.slave_id   = slave;
+        ev.seq        = regs[i];
+        ev.type       = (uint8_t)(regs[i + 1] >> 8);
+        ev.index      = (uint8_t)(regs[i + 1] & 0xFF);
+        ev.value      = regs[i + 2];
+        ev.slave_tick = regs[i + 3];
+
+        /* Gap ahead of the cursor = events dropped by the slave FIFO. A BOOT event or a
+         * sequence behind the cursor means the slave restarted: resync without counting. */
+        int16_t gap = (int16_t)(ev.seq - t->cursor);
+        if (gap > 0 && ev.type != SLAVE_EVENT_BOOT)
+            t->lost = (uint16_t)(t->lost + (uint16_t)gap);
+        t->cursor = (uint16_t)(ev.seq + 1);
+
+        if (event_count >= MODBUS_EVENT_LOG_SIZE) {
+            /* Log full: the oldest event is lost to its own slave's count */
+            SlaveEventTrack_t *old = SlaveRegistry_EventTrack(event_log[event_head].slave_id);
+            if (old != NULL) old->lost++;
+            event_head = (uint16_t)((event_head + 1) % MODBUS_EVENT_LOG_SIZE);
+            event_head_seq++;
+            event_count--;
+        }
+        event_log[(event_head + event_count) % MODBUS_EVENT_LOG_SIZE] = ev;
+        event_count++;
+    }
+}
+
+int ModbusTable_PopSlaveEvent(SlaveEvent_t *ev)
+{
+    if (ev == NULL || event_count == 0) return -1;
+    *ev = event_log[event_head];
+    event_head = (uint16_t)((event_head + 1) % MODBUS_EVENT_LOG_SIZE);
+    event_head_seq++;
+    event_count--;
+    return 0;
+}
+
+int ModbusTable_PeekSlaveEvent(SlaveEvent_t *ev, uint16_t *log_seq)
+{
+    if (event_count == 0) return -1;
+    if (ev != NULL) *ev = event_log[event_head];
+    if (log_seq != NULL) *log_seq = event_head_seq;
+    return 0;
+}
+
+int ModbusTable_CanAckSlaveEvents(uint16_t log_seq)
+{
+    int16_t n = (int16_t)(log_seq - event_head_seq + 1u);
+    return (n > 0 && (uint16_t)n > event_count) ? -1 : 0;
+}
+
+int ModbusTable_AckSlaveEvents(uint16_t log_seq)
+{
+    /* Events from the head up to log_seq; 0 or negative when already dropped */
+    int16_t n = (int16_t)(log_seq - event_head_seq + 1u);
+    if (n <= 0) return 0;
+    if ((uint16_t)n > event_count) return -1;
+    SlaveEvent_t ev;
+    for (int16_t i = 0; i < n; i++) ModbusTable_PopSlaveEvent(&ev);
+    return n;
+}
+
+uint16_t ModbusTable_GetSlaveEventCount(void)
+{
+    return event_count;
+}
+
+uint16_t ModbusTable_GetSlaveEventsLost(SlaveId_t slave)
+{
+    const SlaveEventTrack_t *t = SlaveRegistry_EventTrack(slave);
+    return (t != NULL) ? t->lost : 0;
 }
@@ -0,0 +1,216 @@
+/**
+ * @file slave_registry.c
+ * @brief MAIN board: per-type image pools and the address -> slot index.
+ *        Slots 0..SLAVE_REGISTRY_HPSB_MAX-1 are HPSB, the following ones LPSB.
+ *
+ *        Sequence counter: odd while the writer fills the back buffer, even once published.
+ *        Published buffer = (seq >> 1) & 1 for either parity. A snapshot taken at an even seq s
+ *        is overwritten from s + 3 on (the second write after it), one taken at an odd seq from
+ *        s + 2 on.
+ */
+#include "slave_registry.h"
+#include <string.h>
+
+#define SLOT_NONE       0xFFu
+#define SLOT_LPSB_BASE  SLAVE_REGISTRY_HPSB_MAX
+
+typedef struct {
+    SlaveImageHead_t head;
+    uint16_t input[SLAVE_HPSB_INPUT_COUNT];
+} HpsbImage_t;
+
+typedef struct {
+    SlaveImageHead_t head;
+    uint16_t input[SLAVE_LPSB_INPUT_COUNT];
+} LpsbImage_t;
+
+/* Stamps sit outside the double buffer: single aligned words, written after each publish */
+typedef struct {
+    volatile uint32_t stamp[SLAVE_AREA_COUNT];
+    HpsbImage_t       img[2];
+    SlaveEventTrack_t ev;
+    volatile uint16_t seq;
+} HpsbSlot_t;
+
+typedef struct {
+    volatile uint32_t stamp[SLAVE_AREA_COUNT];
+    LpsbImage_t       img[2];
+    SlaveEventTrack_t ev;
+    volatile uint16_t seq;
+} LpsbSlot_t;
+
+/* Seen through the view of an unregistered slave */
+static const SlaveImageHead_t zero_head;
+static const uint16_t         zero_input[SLAVE_HPSB_INPUT_COUNT];
+static const uint32_t         zero_stamp[SLAVE_AREA_COUNT];
+
+static HpsbSlot_t hpsb_pool[SLAVE_REGISTRY_HPSB_MAX];
+static LpsbSlot_t lpsb_pool[SLAVE_REGISTRY_LPSB_MAX];
+static uint8_t    slot_of[SLAVE_REGISTRY_ADDR_MAX + 1u];   /* by address, SLOT_NONE = not registered */
+static uint8_t    hpsb_used;
+static uint8_t    lpsb_used;
+
+#define XSTR(x) STR(x)
+#define STR(x)  #x
+#pragma message("slave registry RAM: " XSTR(SLAVE_REGISTRY_HPSB_MAX) " x " XSTR(SLAVE_HPSB_SLOT_BYTES) " B HPSB + " \
+                 XSTR(SLAVE_REGISTRY_LPSB_MAX) " x " XSTR(SLAVE_LPSB_SLOT_BYTES) " B LPSB + " \
+                 XSTR(SLAVE_REGISTRY_ADDR_MAX) " + 1 B index, budget " XSTR(SLAVE_REGISTRY_RAM_BUDGET) " B")
+
+#if SLAVE_REGISTRY_RAM_BYTES > SLAVE_REGISTRY_RAM_BUDGET
+#error "slave registry pools exceed SLAVE_REGISTRY_RAM_BUDGET"
+#endif
+#if SLAVE_REGISTRY_HPSB_MAX + SLAVE_REGISTRY_LPSB_MAX > SLAVE_REGISTRY_ADDR_MAX || SLAVE_REGISTRY_ADDR_MAX >= SLOT_NONE
+#error "slave registry pool sizes do not fit the address range"
+#endif
+_Static_assert(sizeof(HpsbSlot_t) == SLAVE_HPSB_SLOT_BYTES, "SLAVE_HPSB_SLOT_BYTES out of step with HpsbSlot_t");
+_Static_assert(sizeof(LpsbSlot_t) == SLAVE_LPSB_SLOT_BYTES, "SLAVE_LPSB_SLOT_BYTES out of step with LpsbSlot_t");
+_Static_assert(sizeof(hpsb_pool) + sizeof(lpsb_pool) + sizeof(slot_of) == SLAVE_REGISTRY_RAM_BYTES,
+               "SLAVE_REGISTRY_RAM_BYTES out of step with the pools");
+
+static inline uint8_t lookup(SlaveId_t slave)
+{
+    if (slave < SLAVE_ID_FIRST || (uint32_t)slave > SLAVE_REGISTRY_ADDR_MAX) return SLOT_NONE;
+    return slot_of[slave];
+}
+
+static inline volatile uint16_t *seq_of(uint8_t slot)
+{
+    if (slot < SLOT_LPSB_BASE) return &hpsb_pool[slot].seq;
+    return &lpsb_pool[slot - SLOT_LPSB_BASE].seq;
+}
+
+void SlaveRegistry_Init(void)
+{
+    memset(slot_of, SLOT_NONE, sizeof(slot_of));
+    hpsb_used = 0;
+    lpsb_used = 0;
+    SlaveRegistry_ClearImages();
+}
+
+int SlaveRegistry_Add(SlaveId_t slave, uint8_t type)
+{
+    if (slave < SLAVE_ID_FIRST || (uint32_t)slave > SLAVE_REGISTRY_ADDR_MAX) return -1;
+    if (slot_of[slave] != SLOT_NONE)
+        return (SlaveRegistry_GetType(slave) == type) ? 0 : -1;
+
+    if (type == SLAVE_TYPE_HPSB) {
+        if (hpsb_used >= SLAVE_REGISTRY_HPSB_MAX) return -1;
+        memset(&hpsb_pool[hpsb_used], 0, sizeof(hpsb_pool[0]));
+        slot_of[slave] = hpsb_used++;
+    } else if (type == SLAVE_TYPE_LPSB) {
+        if (lpsb_used >= SLAVE_REGISTRY_LPSB_MAX) return -1;
+        memset(&lpsb_pool[lpsb_used], 0, sizeof(lpsb_pool[0]));
+        slot_of[slave] = (uint8_t)(SLOT_LPSB_BASE + lpsb_used++);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+uint8_t SlaveRegistry_GetType(SlaveId_t slave)
+{
+    uint8_t slot = lookup(slave);
+    if (slot == SLOT_NONE) return SLAVE_TYPE_NONE;
+    return (slot < SLOT_LPSB_BASE) ? SLAVE_TYPE_HPSB : SLAVE_TYPE_LPSB;
+}
+
+uint8_t SlaveRegistry_GetCount(void)
+{
+    return (uint8_t)(hpsb_used + lpsb_used);
+}
+
+void SlaveRegistry_ClearImages(void)
+{
+    memset(hpsb_pool, 0, sizeof(hpsb_pool));
+    memset(lpsb_pool, 0, sizeof(lpsb_pool));
+}
+
+int SlaveRegistry_Snapshot(SlaveId_t slave, SlaveSnapshot_t *snap)
+{
+    uint8_t slot = lookup(slave);
+
+    snap->slave = slave;
+    if (slot == SLOT_NONE) {
+        snap->head = &zero_head;
+        snap->input = zero_input;
+        snap->stamp = zero_stamp;
+        snap->input_count = 0;
+        snap->seq = 0;
+        return -1;
+    }
+    /* One read of seq picks the buffer; everything after that is plain pointer arithmetic */
+    uint16_t seq = *seq_of(slot);
+    uint8_t  b = (uint8_t)((seq >> 1) & 1u);
+    if (slot < SLOT_LPSB_BASE) {
+        const HpsbImage_t *img = &hpsb_pool[slot].img[b];
+        snap->head = &img->head;
+        snap->input = img->input;
+        snap->stamp = (const uint32_t *)hpsb_pool[slot].stamp;
+        snap->input_count = SLAVE_HPSB_INPUT_COUNT;
+    } else {
+        const LpsbImage_t *img = &lpsb_pool[slot - SLOT_LPSB_BASE].img[b];
+        snap->head = &img->head;
+        snap->input = img->input;
+        snap->stamp = (const uint32_t *)lpsb_pool[slot - SLOT_LPSB_BASE].stamp;
+        snap->input_count = SLAVE_LPSB_INPUT_COUNT;
+    }
+    snap->seq = seq;
+    return 0;
+}
+
+uint8_t SlaveRegistry_SnapshotValid(const SlaveSnapshot_t *snap)
+{
+    uint8_t slot = lookup(snap->slave);
+    if (slot == SLOT_NONE) return 1;    /* the zero image never changes */
+    uint16_t since = (uint16_t)(*seq_of(slot) - snap->seq);
+    return (since <= (uint16_t)(2u - (snap->seq & 1u))) ? 1 : 0;
+}
+
+int SlaveRegistry_BeginWrite(SlaveId_t slave, SlaveImageWrite_t *w)
+{
+    uint8_t slot = lookup(slave);
+    if (slot == SLOT_NONE) return -1;
+
+    volatile uint16_t *seq = seq_of(slot);
+    uint8_t front = (uint8_t)((*seq >> 1) & 1u);
+    *seq = (uint16_t)(*seq | 1u);       /* odd before the back buffer is touched */
+    if (slot < SLOT_LPSB_BASE) {
+        HpsbSlot_t *s = &hpsb_pool[slot];
+        s->img[front ^ 1u] = s->img[front];
+        w->head = &s->img[front ^ 1u].head;
+        w->input = s->img[front ^ 1u].input;
+        w->input_count = SLAVE_HPSB_INPUT_COUNT;
+    } else {
+        LpsbSlot_t *s = &lpsb_pool[slot - SLOT_LPSB_BASE];
+        s->img[front ^ 1u] = s->img[front];
+        w->head = &s->img[front ^ 1u].head;
+        w->input = s->img[front ^ 1u].input;
+        w->input_count = SLAVE_LPSB_INPUT_COUNT;
+    }
+    return 0;
+}
+
+void SlaveRegistry_Publish(SlaveId_t slave)
+{
+    uint8_t slot = lookup(slave);
+    if (slot == SLOT_NONE) return;
+    volatile uint16_t *seq = seq_of(slot);
+    if (*seq & 1u) *seq = (uint16_t)(*seq + 1u);    /* even: back buffer is now the published one */
+}
+
+void SlaveRegistry_Stamp(SlaveId_t slave, SlaveArea_t area, uint32_t tick)
+{
+    uint8_t slot = lookup(slave);
+    if (slot == SLOT_NONE || area >= SLAVE_AREA_COUNT) return;
+    if (tick == 0) tick = 1;
+    if (slot < SLOT_LPSB_BASE) hpsb_pool[slot].stamp[area] = tick;
+    else                       lpsb_pool[slot - SLOT_LPSB_BASE].stamp[area] = tick;
+}
+
+SlaveEventTrack_t *SlaveRegistry_EventTrack(SlaveId_t slave)
+{
+    uint8_t slot = lookup(slave);
+    if (slot == SLOT_NONE) return NULL;
+    if (slot < SLOT_LPSB_BASE) return &hpsb_pool[slot].ev;
+    return &lpsb_pool[slot - SLOT_LPSB_BASE].ev;
+}
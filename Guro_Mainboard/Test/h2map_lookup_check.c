@@ -0,0 +1,111 @@
+/**
+ * @file h2map_lookup_check.c
+ * @brief Host check for the H2TECH map index. Test/ is not a source folder of the firmware build.
+ *        Compares H2Map_FindByDec / H2Map_FindRun with a linear scan of g_map, the lookup they
+ *        replaced: every address 0..H2_CHECK_DEC_END of every area, and every run length
+ *        1..H2_CHECK_MAX_COUNT from every address. Then times both over the whole map.
+ *        Exits 1 on the first difference.
+ *
+ *        From Guro_Mainboard:
+ *          gcc -O2 -std=gnu11 -IGateway/Inc -IApplication/Inc -IIO/Inc -IModbus/Inc \
+ *              Test/h2map_lookup_check.c -o h2map_lookup_check && ./h2map_lookup_check
+ */
+#include "../Gateway/Src/h2tech_address_map.c"
+
+#include <stdio.h>
+#include <time.h>
+
+#define H2_CHECK_DEC_END    4000u   /* past the last 3x address */
+#define H2_CHECK_MAX_COUNT  125u    /* FC03/FC04 quantity limit */
+#define H2_CHECK_ROUNDS     200u
+
+static const H2_Area_t areas[] = { H2_AREA_1X, H2_AREA_0X, H2_AREA_3X, H2_AREA_4X };
+
+/* The pre-index lookup: first row of the area with that address */
+static const H2_MapEntry_t* linear_find(H2_Area_t area, uint16_t h2_dec) {
+    for (size_t i = 0; i < H2_MAP_COUNT; i++) {
+        if (g_map[i].area == area && g_map[i].h2_dec == h2_dec) return &g_map[i];
+    }
+    return NULL;
+}
+
+/* A run is count mapped addresses whose rows follow each other in g_map */
+static const H2_MapEntry_t* linear_run(H2_Area_t area, uint16_t h2_dec, uint16_t count) {
+    const H2_MapEntry_t* first = linear_find(area, h2_dec);
+    if (!first) return NULL;
+    for (uint16_t k = 1; k < count; k++) {
+        if (linear_find(area, (uint16_t)(h2_dec + k)) != first + k) return NULL;
+    }
+    return first;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int check_results(void) {
+    unsigned finds = 0, runs = 0;
+    for (size_t a = 0; a < sizeof(areas) / sizeof(areas[0]); a++) {
+        for (uint16_t dec = 0; dec <= H2_CHECK_DEC_END; dec++) {
+            if (H2Map_FindByDec(areas[a], dec) != linear_find(areas[a], dec)) {
+                printf("FindByDec differs: area %d dec %u\n", (int)areas[a], dec);
+                return -1;
+            }
+            finds++;
+            for (uint16_t n = 1; n <= H2_CHECK_MAX_COUNT; n++) {
+                if (H2Map_FindRun(areas[a], dec, n) != linear_run(areas[a], dec, n)) {
+                    printf("FindRun differs: area %d dec %u count %u\n", (int)areas[a], dec, n);
+                    return -1;
+                }
+                runs++;
+            }
+        }
+    }
+    printf("identical: %u FindByDec, %u FindRun over %u rows\n", finds, runs, (unsigned)H2_MAP_COUNT);
+    return 0;
+}
+
+/* ns per lookup of every mapped row, and per FC02-style run request over each 1x run */
+static void bench(void) {
+    volatile uintptr_t sink = 0;
+    double t0, t_index, t_linear;
+
+    t0 = now_ns();
+    for (unsigned r = 0; r < H2_CHECK_ROUNDS; r++)
+        for (size_t i = 0; i < H2_MAP_COUNT; i++) sink += (uintptr_t)H2Map_FindByDec(g_map[i].area, g_map[i].h2_dec);
+    t_index = (now_ns() - t0) / (H2_CHECK_ROUNDS * (double)H2_MAP_COUNT);
+    t0 = now_ns();
+    for (unsigned r = 0; r < H2_CHECK_ROUNDS; r++)
+        for (size_t i = 0; i < H2_MAP_COUNT; i++) sink += (uintptr_t)linear_find(g_map[i].area, g_map[i].h2_dec);
+    t_linear = (now_ns() - t0) / (H2_CHECK_ROUNDS * (double)H2_MAP_COUNT);
+    printf("single lookup, all %u rows:  linear %7.1f ns  index %5.1f ns\n", (unsigned)H2_MAP_COUNT, t_linear, t_index);
+
+    unsigned reqs = 0;
+    t0 = now_ns();
+    for (unsigned r = 0; r < H2_CHECK_ROUNDS; r++)
+        for (uint16_t off = 0; off < H2_SPAN(1X); off++)
+            if (g_index_1x[off]) {
+                uint16_t dec = (uint16_t)(H2_1X_DEC_MIN + off);
+                sink += (uintptr_t)H2Map_FindRun(H2_AREA_1X, dec, (uint16_t)(g_run_end_1x[off] - off + 1u));
+                reqs++;
+            }
+    t_index = (now_ns() - t0) / reqs;
+    t0 = now_ns();
+    for (unsigned r = 0; r < H2_CHECK_ROUNDS; r++)
+        for (uint16_t off = 0; off < H2_SPAN(1X); off++)
+            if (g_index_1x[off]) {
+                uint16_t dec = (uint16_t)(H2_1X_DEC_MIN + off);
+                sink += (uintptr_t)linear_run(H2_AREA_1X, dec, (uint16_t)(g_run_end_1x[off] - off + 1u));
+            }
+    t_linear = (now_ns() - t0) / reqs;
+    printf("1x run to the end of its run:  linear %7.1f ns  index %5.1f ns\n", t_linear, t_index);
+    (void)sink;
+}
+
+int main(void) {
+    if (check_results() != 0) return 1;
+    bench();
+    return 0;
+}
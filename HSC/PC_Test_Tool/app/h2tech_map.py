@@ -48,3 +48,21 @@ MAIN_DI_REG = 2100
 MAIN_DO_REG = 2101
 MAIN_DI_COUNT = 1
 MAIN_DO_COUNT = 1
+
+# Waveform capture relay (FC06/FC03). MAIN fetches the burst from the sub-board, PC reads it from MAIN.
+# 4x2200 W = (cmd << 8) | sub-board slave id; R = (slave id << 8) | state
+# 4x2201 R/W = readout offset; 4x2202..2206 = count/ch, period_us, pretrig, seq, slave status
+# 4x2210 count 1..64 = samples (channel-major) from the offset; reading does not move it
+CAPTURE_CTRL_REG = 2200
+CAPTURE_OFFSET_REG = 2201
+CAPTURE_INFO_COUNT = 7
+CAPTURE_DATA_REG = 2210
+CAPTURE_DATA_MAX = 64
+CAPTURE_CH_COUNT = 3
+CAPTURE_CMD_TRIGGER = 1
+CAPTURE_CMD_ARM = 2
+CAPTURE_CMD_FETCH = 3
+CAPTURE_STATE_DONE = 3
+CAPTURE_STATE_ERROR = 4
+CAPTURE_STATE_NAMES = {0: "idle", 1: "busy", 2: "wait trigger", 3: "done", 4: "error"}
+CAPTURE_SLAVES = {1: "HPSB", 2: "LPSB1", 3: "LPSB2", 4: "LPSB3"}
@@ -12,10 +12,12 @@ from .h2tech_map import (
     CMD_ONOFF_START, CMD_ONOFF_COUNT,
     CURRENT_START, CURRENT_COUNT,
     DOOR_OPEN_1_COIL, DOOR_OPEN_2_COIL,
-    VB_ONOFF_8_COIL, VB_ONOFF_12_COIL,
+    VB_ONOFF_8_COIL, VB_ONOFF_9_COIL, VB_ONOFF_10_COIL, VB_ONOFF_11_COIL, VB_ONOFF_12_COIL,
     INVALID_COIL_899, INVALID_COIL_900,
     MAIN_IO_ENABLED, MAIN_DI_REG, MAIN_DO_REG, MAIN_DI_COUNT, MAIN_DO_COUNT,
     MAIN_SLAVE_ID_DEFAULT,
+    CAPTURE_CTRL_REG, CAPTURE_OFFSET_REG, CAPTURE_INFO_COUNT,
+    CAPTURE_DATA_REG, CAPTURE_DATA_MAX, CAPTURE_CH_COUNT,
 )
 
 
@@ -213,3 +215,76 @@ class ModbusClient:
     def write_invalid_coil_900(self) -> tuple[bool, str | None]:
         """Expect exception 0x02."""
         return self.write_coil(INVALID_COIL_900, True)
+
+    def _read_holding(self, address: int, count: int) -> tuple[bool, list[int] | None, str | None]:
+        """FC03 Read Holding Registers. Returns (ok, regs or None, exception_message)."""
+        with self._lock:
+            if not self._client or not self._client.connected:
+                return False, None, "Not connected"
+            try:
+                rr = self._client.read_holding_registers(
+                    address=address,
+                    count=count,
+                    slave=self._slave_id,
+                )
+                if rr.isError():
+                    return False, None, f"Exception 0x{rr.exception_code:02X}"
+                return True, list(rr.registers or []), None
+            except ModbusException as e:
+                return False, None, str(e)
+            except Exception as e:
+                return False, None, str(e)
+
+    def _write_register(self, address: int, value: int) -> tuple[bool, str | None]:
+        """FC06 Write Single Register. Returns (ok, exception_message)."""
+        with self._lock:
+            if not self._client or not self._client.connected:
+                return False, "Not connected"
+            try:
+                rr = self._client.write_register(
+                    address=address,
+                    value=value,
+                    slave=self._slave_id,
+                )
+                if rr.isError():
+                    return False, f"Exception 0x{rr.exception_code:02X}"
+                return True, None
+            except ModbusException as e:
+                return False, str(e)
+            except Exception as e:
+                return False, str(e)
+
+    def capture_start(self, sub_slave: int, cmd: int) -> tuple[bool, str | None]:
+        """FC06 4x2200 = (cmd << 8) | sub_slave. Exception 0x06 = MAIN still fetching."""
+        return self._write_register(CAPTURE_CTRL_REG, ((cmd & 0xFF) << 8) | (sub_slave & 0xFF))
+
+    def read_capture_info(self) -> tuple[bool, dict | None, str | None]:
+        """FC03 4x2200 count=7 -> dict(slave, state, offset, count, period_us, pretrig, seq, slave_status)."""
+        ok, regs, err = self._read_holding(CAPTURE_CTRL_REG, CAPTURE_INFO_COUNT)
+        if not ok or regs is None or len(regs) < CAPTURE_INFO_COUNT:
+            return False, None, err or "Short response"
+        return True, {
+            "slave": regs[0] >> 8,
+            "state": regs[0] & 0xFF,
+            "offset": regs[1],
+            "count": regs[2],
+            "period_us": regs[3],
+            "pretrig": regs[4],
+            "seq": regs[5],
+            "slave_status": regs[6],
+        }, None
+
+    def read_capture_samples(self, count_per_ch: int) -> tuple[bool, list[list[int]] | None, str | None]:
+        """Read count_per_ch * 3 samples via 4x2210, setting 4x2201 before each block. Returns per-channel lists."""
+        total = count_per_ch * CAPTURE_CH_COUNT
+        flat: list[int] = []
+        while len(flat) < total:
+            n = min(CAPTURE_DATA_MAX, total - len(flat))
+            ok, err = self._write_register(CAPTURE_OFFSET_REG, len(flat))
+            if not ok:
+                return False, None, err
+            ok, regs, err = self._read_holding(CAPTURE_DATA_REG, n)
+            if not ok or regs is None:
+                return False, None, err
+            flat.extend(regs[:n])
+        return True, [flat[ch * count_per_ch:(ch + 1) * count_per_ch] for ch in range(CAPTURE_CH_COUNT)], None
@@ -3,6 +3,7 @@ Main window: field test utility — MAIN I/O, HPSB, LPSB, Door, Alarms, Currents
 Layout: top bar, left (MAIN I/O, ON/OFF, Door, Alarms), right (HPSB, LPSB tabs, Currents), bottom (Control Actions, Log).
 Serial/worker/H2TECH addressing unchanged for existing reads/writes.
 """
+import time
 from datetime import datetime
 from PyQt6.QtWidgets import (
     QMainWindow, QWidget, QVBoxLayout, QHBoxLayout, QGridLayout,
@@ -25,8 +26,14 @@ from .h2tech_map import (
     VB_ONOFF_8_COIL, VB_ONOFF_12_COIL,
     INVALID_COIL_899, INVALID_COIL_900,
     MAIN_IO_ENABLED, MAIN_DI_REG, MAIN_DO_REG, MAIN_SLAVE_ID_DEFAULT,
+    CAPTURE_CTRL_REG, CAPTURE_DATA_REG, CAPTURE_CH_COUNT,
+    CAPTURE_CMD_TRIGGER, CAPTURE_CMD_ARM, CAPTURE_CMD_FETCH,
+    CAPTURE_STATE_DONE, CAPTURE_STATE_ERROR, CAPTURE_STATE_NAMES, CAPTURE_SLAVES,
 )
 
+CAPTURE_POLL_MS = 200
+CAPTURE_TIMEOUT_S = 30
+
 # ---- Industrial dark theme QSS ----
 # Background: #1e1e1e | Cards: #2a2a2a | Text: #e0e0e0 | Accent: #2d8cf0
 # ON LED: #00c853 | OFF LED: #555555 | Alarm LED: #ff1744 (blinking)
@@ -491,6 +498,28 @@ class MainWindow(QMainWindow):
             self._vb_buttons.append(b)
         lay_ctrl.addLayout(row_vb)
         lay_ctrl.addWidget(QLabel("HPSB port toggles: Not mapped yet."))
+        lay_ctrl.addWidget(QLabel("Waveform capture (FC06 4x2200, FC03 4x2210):"))
+        row_cap = QHBoxLayout()
+        self._cap_slave = QComboBox()
+        for sid, name in CAPTURE_SLAVES.items():
+            self._cap_slave.addItem(f"{name} (ID {sid})", sid)
+        self._cap_mode = QComboBox()
+        self._cap_mode.addItem("Trigger now", CAPTURE_CMD_TRIGGER)
+        self._cap_mode.addItem("Arm threshold", CAPTURE_CMD_ARM)
+        self._cap_mode.addItem("Fetch last", CAPTURE_CMD_FETCH)
+        self._btn_capture = QPushButton("Capture → CSV")
+        self._btn_capture.setToolTip("MAIN fetches the burst from the sub-board, then it is saved as CSV")
+        self._btn_capture.clicked.connect(self._capture_start)
+        self._cap_status = QLabel("—")
+        row_cap.addWidget(self._cap_slave)
+        row_cap.addWidget(self._cap_mode)
+        row_cap.addWidget(self._btn_capture)
+        row_cap.addWidget(self._cap_status, stretch=1)
+        lay_ctrl.addLayout(row_cap)
+        self._cap_timer = QTimer(self)
+        self._cap_timer.setInterval(CAPTURE_POLL_MS)
+        self._cap_timer.timeout.connect(self._capture_poll)
+        self._cap_deadline = 0.0
         lay_ctrl.addWidget(QLabel("Exception test (expect 0x02):"))
         row2 = QHBoxLayout()
         b899 = QPushButton("0899")
@@ -517,7 +546,7 @@ class MainWindow(QMainWindow):
         self._control_buttons = (
             [self._btn_door1, self._btn_door2] + self._vb_buttons +
             self._hpsb_toggles + self._main_do_buttons +
-            list(chain.from_iterable(self._lpsb_buttons)) + [b899, b900]
+            list(chain.from_iterable(self._lpsb_buttons)) + [b899, b900, self._btn_capture]
         )
         bottom_lay.addWidget(card_ctrl, stretch=1)
 
@@ -596,6 +625,62 @@ class MainWindow(QMainWindow):
             return
         Path(path).write_text(content, encoding="utf-8")
 
+    def _capture_start(self):
+        if not self._client.connected:
+            return
+        sid = self._cap_slave.currentData()
+        cmd = self._cap_mode.currentData()
+        ok, err = self._client.capture_start(sid, cmd)
+        self._log.log("FC06", CAPTURE_CTRL_REG, f"cmd={cmd} slave={sid}", "OK" if ok else "Fail", err or "")
+        if not ok:
+            self._cap_status.setText(f"Start failed: {err}")
+            return
+        self._cap_deadline = time.monotonic() + CAPTURE_TIMEOUT_S
+        self._btn_capture.setEnabled(False)
+        self._cap_status.setText("busy")
+        self._cap_timer.start()
+
+    def _capture_poll(self):
+        ok, info, err = self._client.read_capture_info()
+        if not ok:
+            self._capture_finish(f"Status read failed: {err}")
+            return
+        state = info["state"]
+        self._cap_status.setText(CAPTURE_STATE_NAMES.get(state, str(state)))
+        if state == CAPTURE_STATE_ERROR:
+            self._capture_finish("MAIN reported capture error")
+            return
+        if state != CAPTURE_STATE_DONE:
+            if time.monotonic() > self._cap_deadline:
+                self._capture_finish("Timeout waiting for capture")
+            return
+        self._cap_timer.stop()
+        ok, chans, err = self._client.read_capture_samples(info["count"])
+        self._log.log("FC03", CAPTURE_DATA_REG, f"{info['count']}x{CAPTURE_CH_COUNT}", "OK" if ok else "Fail", err or "")
+        if not ok:
+            self._capture_finish(f"Readout failed: {err}")
+            return
+        self._capture_save_csv(info, chans)
+        self._capture_finish(f"Done: {info['count']} samples/ch @ {info['period_us']} us, seq {info['seq']}")
+
+    def _capture_finish(self, text: str):
+        self._cap_timer.stop()
+        self._cap_status.setText(text)
+        self._btn_capture.setEnabled(self._client.connected)
+
+    def _capture_save_csv(self, info: dict, chans: list):
+        name = CAPTURE_SLAVES.get(info["slave"], str(info["slave"]))
+        path, _ = QFileDialog.getSaveFileName(self, "Save capture", f"capture_{name}_{info['seq']}.csv", "CSV (*.csv)")
+        if not path:
+            return
+        from pathlib import Path
+        # t_us relative to the trigger point (negative = pre-trigger history)
+        lines = ["sample,t_us," + ",".join(f"ch{c + 1}" for c in range(CAPTURE_CH_COUNT))]
+        for n in range(info["count"]):
+            t_us = (n - info["pretrig"]) * info["period_us"]
+            lines.append(f"{n},{t_us}," + ",".join(str(c[n]) for c in chans))
+        Path(path).write_text("\n".join(lines) + "\n", encoding="utf-8")
+
     def _log_copy_selected(self):
         text = self._log_edit.textCursor().selectedText()
         if text: